@@ -0,0 +1,22 @@
+extern void print(int);
+
+int func(int n){
+	int i;
+	int big;
+	int small;
+	int t;
+	i = 0;
+	big = 0;
+	small = 0;
+	while (i < n){
+		t = i * 7;
+		if (t > big) big = t - 3;
+		else small = small + 1;
+		if (big > 20) small = small - 2;
+		if (small > big) print(small);
+		i = i + 1;
+	}
+	print(big);
+	print(small);
+	return big + small;
+}
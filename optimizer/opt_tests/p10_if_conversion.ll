@@ -0,0 +1,100 @@
+; ModuleID = 'p10_if_conversion.c'
+source_filename = "p10_if_conversion.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+; Function Attrs: noinline nounwind optnone uwtable
+define dso_local i32 @func(i32 noundef %0) #0 {
+  %2 = alloca i32, align 4
+  %3 = alloca i32, align 4
+  %4 = alloca i32, align 4
+  %5 = alloca i32, align 4
+  %6 = alloca i32, align 4
+  store i32 %0, ptr %2, align 4
+  store i32 0, ptr %3, align 4
+  store i32 0, ptr %4, align 4
+  store i32 0, ptr %5, align 4
+  br label %7
+
+7:                                                ; preds = %35, %1
+  %8 = load i32, ptr %3, align 4
+  %9 = load i32, ptr %2, align 4
+  %10 = icmp slt i32 %8, %9
+  br i1 %10, label %11, label %38
+
+11:                                               ; preds = %7
+  %12 = load i32, ptr %3, align 4
+  %13 = mul nsw i32 %12, 7
+  store i32 %13, ptr %6, align 4
+  %14 = load i32, ptr %6, align 4
+  %15 = load i32, ptr %4, align 4
+  %16 = icmp sgt i32 %14, %15
+  br i1 %16, label %17, label %20
+
+17:                                               ; preds = %11
+  %18 = load i32, ptr %6, align 4
+  %19 = sub nsw i32 %18, 3
+  store i32 %19, ptr %4, align 4
+  br label %23
+
+20:                                               ; preds = %11
+  %21 = load i32, ptr %5, align 4
+  %22 = add nsw i32 %21, 1
+  store i32 %22, ptr %5, align 4
+  br label %23
+
+23:                                               ; preds = %20, %17
+  %24 = load i32, ptr %4, align 4
+  %25 = icmp sgt i32 %24, 20
+  br i1 %25, label %26, label %29
+
+26:                                               ; preds = %23
+  %27 = load i32, ptr %5, align 4
+  %28 = sub nsw i32 %27, 2
+  store i32 %28, ptr %5, align 4
+  br label %29
+
+29:                                               ; preds = %26, %23
+  %30 = load i32, ptr %5, align 4
+  %31 = load i32, ptr %4, align 4
+  %32 = icmp sgt i32 %30, %31
+  br i1 %32, label %33, label %35
+
+33:                                               ; preds = %29
+  %34 = load i32, ptr %5, align 4
+  call void @print(i32 noundef %34)
+  br label %35
+
+35:                                               ; preds = %33, %29
+  %36 = load i32, ptr %3, align 4
+  %37 = add nsw i32 %36, 1
+  store i32 %37, ptr %3, align 4
+  br label %7, !llvm.loop !6
+
+38:                                               ; preds = %7
+  %39 = load i32, ptr %4, align 4
+  call void @print(i32 noundef %39)
+  %40 = load i32, ptr %5, align 4
+  call void @print(i32 noundef %40)
+  %41 = load i32, ptr %4, align 4
+  %42 = load i32, ptr %5, align 4
+  %43 = add nsw i32 %41, %42
+  ret i32 %43
+}
+
+declare void @print(i32 noundef) #1
+
+attributes #0 = { noinline nounwind optnone uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+attributes #1 = { "frame-pointer"="all" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+
+!llvm.module.flags = !{!0, !1, !2, !3, !4}
+!llvm.ident = !{!5}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{i32 7, !"PIC Level", i32 2}
+!2 = !{i32 7, !"PIE Level", i32 2}
+!3 = !{i32 7, !"uwtable", i32 2}
+!4 = !{i32 7, !"frame-pointer", i32 2}
+!5 = !{!"Ubuntu clang version 15.0.7"}
+!6 = distinct !{!6, !7}
+!7 = !{!"llvm.loop.mustprogress"}
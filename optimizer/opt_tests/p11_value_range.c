@@ -0,0 +1,20 @@
+extern void print(int);
+
+int func(int n){
+	int i;
+	int s;
+	i = 0;
+	s = 0;
+	if (n > 10) {
+		if (n > 5) print(1);
+		else print(2);
+	}
+	while (i < 10) {
+		if (i < 20) s = s + i;
+		else print(i);
+		if (i >= 0) s = s + 1;
+		i = i + 1;
+	}
+	if (i == 10) print(s);
+	return s;
+}
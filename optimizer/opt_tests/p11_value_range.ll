@@ -0,0 +1,103 @@
+; ModuleID = 'p11_value_range.c'
+source_filename = "p11_value_range.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+; Function Attrs: noinline nounwind optnone uwtable
+define dso_local i32 @func(i32 noundef %0) #0 {
+  %2 = alloca i32, align 4
+  %3 = alloca i32, align 4
+  %4 = alloca i32, align 4
+  store i32 %0, ptr %2, align 4
+  store i32 0, ptr %3, align 4
+  store i32 0, ptr %4, align 4
+  %5 = load i32, ptr %2, align 4
+  %6 = icmp sgt i32 %5, 10
+  br i1 %6, label %7, label %13
+
+7:                                                ; preds = %1
+  %8 = load i32, ptr %2, align 4
+  %9 = icmp sgt i32 %8, 5
+  br i1 %9, label %10, label %11
+
+10:                                               ; preds = %7
+  call void @print(i32 noundef 1)
+  br label %12
+
+11:                                               ; preds = %7
+  call void @print(i32 noundef 2)
+  br label %12
+
+12:                                               ; preds = %11, %10
+  br label %13
+
+13:                                               ; preds = %31, %12, %1
+  %14 = load i32, ptr %3, align 4
+  %15 = icmp slt i32 %14, 10
+  br i1 %15, label %16, label %34
+
+16:                                               ; preds = %13
+  %17 = load i32, ptr %3, align 4
+  %18 = icmp slt i32 %17, 20
+  br i1 %18, label %19, label %23
+
+19:                                               ; preds = %16
+  %20 = load i32, ptr %4, align 4
+  %21 = load i32, ptr %3, align 4
+  %22 = add nsw i32 %20, %21
+  store i32 %22, ptr %4, align 4
+  br label %25
+
+23:                                               ; preds = %16
+  %24 = load i32, ptr %3, align 4
+  call void @print(i32 noundef %24)
+  br label %25
+
+25:                                               ; preds = %23, %19
+  %26 = load i32, ptr %3, align 4
+  %27 = icmp sge i32 %26, 0
+  br i1 %27, label %28, label %31
+
+28:                                               ; preds = %25
+  %29 = load i32, ptr %4, align 4
+  %30 = add nsw i32 %29, 1
+  store i32 %30, ptr %4, align 4
+  br label %31
+
+31:                                               ; preds = %28, %25
+  %32 = load i32, ptr %3, align 4
+  %33 = add nsw i32 %32, 1
+  store i32 %33, ptr %3, align 4
+  br label %13, !llvm.loop !6
+
+34:                                               ; preds = %13
+  %35 = load i32, ptr %3, align 4
+  %36 = icmp eq i32 %35, 10
+  br i1 %36, label %37, label %39
+
+37:                                               ; preds = %34
+  %38 = load i32, ptr %4, align 4
+  call void @print(i32 noundef %38)
+  br label %39
+
+39:                                               ; preds = %37, %34
+  %40 = load i32, ptr %4, align 4
+  ret i32 %40
+}
+
+declare void @print(i32 noundef) #1
+
+attributes #0 = { noinline nounwind optnone uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+attributes #1 = { "frame-pointer"="all" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+
+!llvm.module.flags = !{!0, !1, !2, !3, !4}
+!llvm.ident = !{!5}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{i32 7, !"PIC Level", i32 2}
+!2 = !{i32 7, !"PIE Level", i32 2}
+!3 = !{i32 7, !"uwtable", i32 2}
+!4 = !{i32 7, !"frame-pointer", i32 2}
+!5 = !{!"Ubuntu clang version 15.0.7"}
+!6 = distinct !{!6, !7}
+!7 = !{!"llvm.loop.mustprogress"}
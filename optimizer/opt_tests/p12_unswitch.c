@@ -0,0 +1,14 @@
+extern void print(int);
+
+int func(int mode){
+	int i;
+	int s;
+	i = 0;
+	s = 0;
+	while (i < 10) {
+		if (mode > 3) s = s + i * mode;
+		else print(i);
+		i = i + 1;
+	}
+	return s;
+}
@@ -0,0 +1,66 @@
+; ModuleID = 'p12_unswitch.c'
+source_filename = "p12_unswitch.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+; Function Attrs: noinline nounwind optnone uwtable
+define dso_local i32 @func(i32 noundef %0) #0 {
+  %2 = alloca i32, align 4
+  %3 = alloca i32, align 4
+  %4 = alloca i32, align 4
+  store i32 %0, ptr %2, align 4
+  store i32 0, ptr %3, align 4
+  store i32 0, ptr %4, align 4
+  br label %5
+
+5:                                                ; preds = %19, %1
+  %6 = load i32, ptr %3, align 4
+  %7 = icmp slt i32 %6, 10
+  br i1 %7, label %8, label %22
+
+8:                                                ; preds = %5
+  %9 = load i32, ptr %2, align 4
+  %10 = icmp sgt i32 %9, 3
+  br i1 %10, label %11, label %17
+
+11:                                               ; preds = %8
+  %12 = load i32, ptr %4, align 4
+  %13 = load i32, ptr %3, align 4
+  %14 = load i32, ptr %2, align 4
+  %15 = mul nsw i32 %13, %14
+  %16 = add nsw i32 %12, %15
+  store i32 %16, ptr %4, align 4
+  br label %19
+
+17:                                               ; preds = %8
+  %18 = load i32, ptr %3, align 4
+  call void @print(i32 noundef %18)
+  br label %19
+
+19:                                               ; preds = %17, %11
+  %20 = load i32, ptr %3, align 4
+  %21 = add nsw i32 %20, 1
+  store i32 %21, ptr %3, align 4
+  br label %5, !llvm.loop !6
+
+22:                                               ; preds = %5
+  %23 = load i32, ptr %4, align 4
+  ret i32 %23
+}
+
+declare void @print(i32 noundef) #1
+
+attributes #0 = { noinline nounwind optnone uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+attributes #1 = { "frame-pointer"="all" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+
+!llvm.module.flags = !{!0, !1, !2, !3, !4}
+!llvm.ident = !{!5}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{i32 7, !"PIC Level", i32 2}
+!2 = !{i32 7, !"PIE Level", i32 2}
+!3 = !{i32 7, !"uwtable", i32 2}
+!4 = !{i32 7, !"frame-pointer", i32 2}
+!5 = !{!"Ubuntu clang version 15.0.7"}
+!6 = distinct !{!6, !7}
+!7 = !{!"llvm.loop.mustprogress"}
@@ -0,0 +1,21 @@
+extern void print(int);
+extern int read();
+
+int func(int n){
+	int x;
+	int flag;
+	x = read();
+	if (x > n){
+		flag = 1;
+		print(1);
+	}
+	else {
+		flag = 0;
+		print(2);
+	}
+	if (flag == 1) print(x);
+	else print(n);
+	if (x < 0) print(3);
+	if (x < 5) print(4);
+	return flag;
+}
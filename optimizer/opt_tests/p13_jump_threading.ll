@@ -0,0 +1,82 @@
+; ModuleID = 'p13_jump_threading.c'
+source_filename = "p13_jump_threading.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+; Function Attrs: noinline nounwind optnone uwtable
+define dso_local i32 @func(i32 noundef %0) #0 {
+  %2 = alloca i32, align 4
+  %3 = alloca i32, align 4
+  %4 = alloca i32, align 4
+  store i32 %0, ptr %2, align 4
+  %5 = call i32 (...) @read()
+  store i32 %5, ptr %3, align 4
+  %6 = load i32, ptr %3, align 4
+  %7 = load i32, ptr %2, align 4
+  %8 = icmp sgt i32 %6, %7
+  br i1 %8, label %9, label %10
+
+9:                                                ; preds = %1
+  store i32 1, ptr %4, align 4
+  call void @print(i32 noundef 1)
+  br label %11
+
+10:                                               ; preds = %1
+  store i32 0, ptr %4, align 4
+  call void @print(i32 noundef 2)
+  br label %11
+
+11:                                               ; preds = %10, %9
+  %12 = load i32, ptr %4, align 4
+  %13 = icmp eq i32 %12, 1
+  br i1 %13, label %14, label %16
+
+14:                                               ; preds = %11
+  %15 = load i32, ptr %3, align 4
+  call void @print(i32 noundef %15)
+  br label %18
+
+16:                                               ; preds = %11
+  %17 = load i32, ptr %2, align 4
+  call void @print(i32 noundef %17)
+  br label %18
+
+18:                                               ; preds = %16, %14
+  %19 = load i32, ptr %3, align 4
+  %20 = icmp slt i32 %19, 0
+  br i1 %20, label %21, label %22
+
+21:                                               ; preds = %18
+  call void @print(i32 noundef 3)
+  br label %22
+
+22:                                               ; preds = %21, %18
+  %23 = load i32, ptr %3, align 4
+  %24 = icmp slt i32 %23, 5
+  br i1 %24, label %25, label %26
+
+25:                                               ; preds = %22
+  call void @print(i32 noundef 4)
+  br label %26
+
+26:                                               ; preds = %25, %22
+  %27 = load i32, ptr %4, align 4
+  ret i32 %27
+}
+
+declare i32 @read(...) #1
+
+declare void @print(i32 noundef) #1
+
+attributes #0 = { noinline nounwind optnone uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+attributes #1 = { "frame-pointer"="all" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+
+!llvm.module.flags = !{!0, !1, !2, !3, !4}
+!llvm.ident = !{!5}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{i32 7, !"PIC Level", i32 2}
+!2 = !{i32 7, !"PIE Level", i32 2}
+!3 = !{i32 7, !"uwtable", i32 2}
+!4 = !{i32 7, !"frame-pointer", i32 2}
+!5 = !{!"Ubuntu clang version 15.0.7"}
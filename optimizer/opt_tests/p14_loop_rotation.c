@@ -0,0 +1,19 @@
+extern void print(int);
+
+int func(int n){
+	int i;
+	int j;
+	int sum;
+	sum = 0;
+	i = 0;
+	while (i < n){
+		j = i;
+		while (j > 0){
+			sum = sum + j;
+			j = j - 2;
+		}
+		print(sum);
+		i = i + 1;
+	}
+	return sum;
+}
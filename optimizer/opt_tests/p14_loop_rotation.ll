@@ -0,0 +1,72 @@
+; ModuleID = 'p14_loop_rotation.c'
+source_filename = "p14_loop_rotation.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+; Function Attrs: noinline nounwind optnone uwtable
+define dso_local i32 @func(i32 noundef %0) #0 {
+  %2 = alloca i32, align 4
+  %3 = alloca i32, align 4
+  %4 = alloca i32, align 4
+  %5 = alloca i32, align 4
+  store i32 %0, ptr %2, align 4
+  store i32 0, ptr %5, align 4
+  store i32 0, ptr %3, align 4
+  br label %6
+
+6:                                                ; preds = %21, %1
+  %7 = load i32, ptr %3, align 4
+  %8 = load i32, ptr %2, align 4
+  %9 = icmp slt i32 %7, %8
+  br i1 %9, label %10, label %25
+
+10:                                               ; preds = %6
+  %11 = load i32, ptr %3, align 4
+  store i32 %11, ptr %4, align 4
+  br label %12
+
+12:                                               ; preds = %15, %10
+  %13 = load i32, ptr %4, align 4
+  %14 = icmp sgt i32 %13, 0
+  br i1 %14, label %15, label %21
+
+15:                                               ; preds = %12
+  %16 = load i32, ptr %5, align 4
+  %17 = load i32, ptr %4, align 4
+  %18 = add nsw i32 %16, %17
+  store i32 %18, ptr %5, align 4
+  %19 = load i32, ptr %4, align 4
+  %20 = sub nsw i32 %19, 2
+  store i32 %20, ptr %4, align 4
+  br label %12, !llvm.loop !6
+
+21:                                               ; preds = %12
+  %22 = load i32, ptr %5, align 4
+  call void @print(i32 noundef %22)
+  %23 = load i32, ptr %3, align 4
+  %24 = add nsw i32 %23, 1
+  store i32 %24, ptr %3, align 4
+  br label %6, !llvm.loop !8
+
+25:                                               ; preds = %6
+  %26 = load i32, ptr %5, align 4
+  ret i32 %26
+}
+
+declare void @print(i32 noundef) #1
+
+attributes #0 = { noinline nounwind optnone uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+attributes #1 = { "frame-pointer"="all" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+
+!llvm.module.flags = !{!0, !1, !2, !3, !4}
+!llvm.ident = !{!5}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{i32 7, !"PIC Level", i32 2}
+!2 = !{i32 7, !"PIE Level", i32 2}
+!3 = !{i32 7, !"uwtable", i32 2}
+!4 = !{i32 7, !"frame-pointer", i32 2}
+!5 = !{!"Ubuntu clang version 15.0.7"}
+!6 = distinct !{!6, !7}
+!7 = !{!"llvm.loop.mustprogress"}
+!8 = distinct !{!8, !7}
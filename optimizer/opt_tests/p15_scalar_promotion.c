@@ -0,0 +1,17 @@
+extern void print(int);
+
+int func(int n){
+	int i;
+	int odd;
+	int total;
+	i = 0;
+	odd = 0;
+	total = 1;
+	while (i < n){
+		if (i - i / 2 * 2 == 1) odd = odd + 1;
+		total = total * 3 - odd;
+		i = i + 1;
+	}
+	print(odd);
+	return total;
+}
@@ -0,0 +1,16 @@
+extern void print(int);
+
+int func(int n){
+	int i;
+	int t;
+	int sum;
+	i = 0;
+	sum = 0;
+	while (i < n){
+		t = i * i + n;
+		if (i > 3) print(t);
+		sum = sum + i;
+		i = i + 1;
+	}
+	return sum;
+}
@@ -0,0 +1,25 @@
+extern void print(int);
+
+static int collatz(int x){
+	int steps;
+	steps = 0;
+	while (x != 1){
+		if (x - x / 2 * 2 == 0) x = x / 2;
+		else x = 3 * x + 1;
+		steps = steps + 1;
+	}
+	return steps;
+}
+
+int func(int n){
+	int i;
+	int total;
+	total = 0;
+	i = 1;
+	while (i < 6){
+		total = total + collatz(i * 7);
+		print(total);
+		i = i + 1;
+	}
+	return total;
+}
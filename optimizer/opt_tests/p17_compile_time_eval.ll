@@ -0,0 +1,102 @@
+; ModuleID = 'p17_compile_time_eval.c'
+source_filename = "p17_compile_time_eval.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+; Function Attrs: noinline nounwind optnone uwtable
+define internal i32 @collatz(i32 noundef %0) #0 {
+  %2 = alloca i32, align 4
+  %3 = alloca i32, align 4
+  store i32 %0, ptr %2, align 4
+  store i32 0, ptr %3, align 4
+  br label %4
+
+4:                                                ; preds = %21, %1
+  %5 = load i32, ptr %2, align 4
+  %6 = icmp ne i32 %5, 1
+  br i1 %6, label %7, label %24
+
+7:                                                ; preds = %4
+  %8 = load i32, ptr %2, align 4
+  %9 = load i32, ptr %2, align 4
+  %10 = sdiv i32 %9, 2
+  %11 = mul nsw i32 %10, 2
+  %12 = sub nsw i32 %8, %11
+  %13 = icmp eq i32 %12, 0
+  br i1 %13, label %14, label %17
+
+14:                                               ; preds = %7
+  %15 = load i32, ptr %2, align 4
+  %16 = sdiv i32 %15, 2
+  store i32 %16, ptr %2, align 4
+  br label %21
+
+17:                                               ; preds = %7
+  %18 = load i32, ptr %2, align 4
+  %19 = mul nsw i32 3, %18
+  %20 = add nsw i32 %19, 1
+  store i32 %20, ptr %2, align 4
+  br label %21
+
+21:                                               ; preds = %17, %14
+  %22 = load i32, ptr %3, align 4
+  %23 = add nsw i32 %22, 1
+  store i32 %23, ptr %3, align 4
+  br label %4, !llvm.loop !6
+
+24:                                               ; preds = %4
+  %25 = load i32, ptr %3, align 4
+  ret i32 %25
+}
+
+; Function Attrs: noinline nounwind optnone uwtable
+define dso_local i32 @func(i32 noundef %0) #0 {
+  %2 = alloca i32, align 4
+  %3 = alloca i32, align 4
+  %4 = alloca i32, align 4
+  store i32 %0, ptr %2, align 4
+  store i32 0, ptr %4, align 4
+  store i32 1, ptr %3, align 4
+  br label %5
+
+5:                                                ; preds = %8, %1
+  %6 = load i32, ptr %3, align 4
+  %7 = icmp slt i32 %6, 6
+  br i1 %7, label %8, label %17
+
+8:                                                ; preds = %5
+  %9 = load i32, ptr %4, align 4
+  %10 = load i32, ptr %3, align 4
+  %11 = mul nsw i32 %10, 7
+  %12 = call i32 @collatz(i32 noundef %11)
+  %13 = add nsw i32 %9, %12
+  store i32 %13, ptr %4, align 4
+  %14 = load i32, ptr %4, align 4
+  call void @print(i32 noundef %14)
+  %15 = load i32, ptr %3, align 4
+  %16 = add nsw i32 %15, 1
+  store i32 %16, ptr %3, align 4
+  br label %5, !llvm.loop !8
+
+17:                                               ; preds = %5
+  %18 = load i32, ptr %4, align 4
+  ret i32 %18
+}
+
+declare void @print(i32 noundef) #1
+
+attributes #0 = { noinline nounwind optnone uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+attributes #1 = { "frame-pointer"="all" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+
+!llvm.module.flags = !{!0, !1, !2, !3, !4}
+!llvm.ident = !{!5}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{i32 7, !"PIC Level", i32 2}
+!2 = !{i32 7, !"PIE Level", i32 2}
+!3 = !{i32 7, !"uwtable", i32 2}
+!4 = !{i32 7, !"frame-pointer", i32 2}
+!5 = !{!"Ubuntu clang version 15.0.7"}
+!6 = distinct !{!6, !7}
+!7 = !{!"llvm.loop.mustprogress"}
+!8 = distinct !{!8, !7}
@@ -0,0 +1,27 @@
+extern void print(int);
+
+int func(int n){
+	int a;
+	int b;
+	int c;
+	int k;
+	a = 0;
+	b = 3;
+	while (a < n){
+		a = a + 1;
+		b = b + 4;
+	}
+	c = 100;
+	while (c > n){
+		c = c - 1;
+	}
+	k = 0;
+	while (k != 30){
+		k = k + 3;
+	}
+	print(a);
+	print(b);
+	print(c);
+	print(k);
+	return a + b;
+}
@@ -0,0 +1,96 @@
+; ModuleID = 'p18_scalar_evolution.c'
+source_filename = "p18_scalar_evolution.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+; Function Attrs: noinline nounwind optnone uwtable
+define dso_local i32 @func(i32 noundef %0) #0 {
+  %2 = alloca i32, align 4
+  %3 = alloca i32, align 4
+  %4 = alloca i32, align 4
+  %5 = alloca i32, align 4
+  %6 = alloca i32, align 4
+  store i32 %0, ptr %2, align 4
+  store i32 0, ptr %3, align 4
+  store i32 3, ptr %4, align 4
+  br label %7
+
+7:                                                ; preds = %11, %1
+  %8 = load i32, ptr %3, align 4
+  %9 = load i32, ptr %2, align 4
+  %10 = icmp slt i32 %8, %9
+  br i1 %10, label %11, label %16
+
+11:                                               ; preds = %7
+  %12 = load i32, ptr %3, align 4
+  %13 = add nsw i32 %12, 1
+  store i32 %13, ptr %3, align 4
+  %14 = load i32, ptr %4, align 4
+  %15 = add nsw i32 %14, 4
+  store i32 %15, ptr %4, align 4
+  br label %7, !llvm.loop !6
+
+16:                                               ; preds = %7
+  store i32 100, ptr %5, align 4
+  br label %17
+
+17:                                               ; preds = %21, %16
+  %18 = load i32, ptr %5, align 4
+  %19 = load i32, ptr %2, align 4
+  %20 = icmp sgt i32 %18, %19
+  br i1 %20, label %21, label %24
+
+21:                                               ; preds = %17
+  %22 = load i32, ptr %5, align 4
+  %23 = sub nsw i32 %22, 1
+  store i32 %23, ptr %5, align 4
+  br label %17, !llvm.loop !8
+
+24:                                               ; preds = %17
+  store i32 0, ptr %6, align 4
+  br label %25
+
+25:                                               ; preds = %28, %24
+  %26 = load i32, ptr %6, align 4
+  %27 = icmp ne i32 %26, 30
+  br i1 %27, label %28, label %31
+
+28:                                               ; preds = %25
+  %29 = load i32, ptr %6, align 4
+  %30 = add nsw i32 %29, 3
+  store i32 %30, ptr %6, align 4
+  br label %25, !llvm.loop !9
+
+31:                                               ; preds = %25
+  %32 = load i32, ptr %3, align 4
+  call void @print(i32 noundef %32)
+  %33 = load i32, ptr %4, align 4
+  call void @print(i32 noundef %33)
+  %34 = load i32, ptr %5, align 4
+  call void @print(i32 noundef %34)
+  %35 = load i32, ptr %6, align 4
+  call void @print(i32 noundef %35)
+  %36 = load i32, ptr %3, align 4
+  %37 = load i32, ptr %4, align 4
+  %38 = add nsw i32 %36, %37
+  ret i32 %38
+}
+
+declare void @print(i32 noundef) #1
+
+attributes #0 = { noinline nounwind optnone uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+attributes #1 = { "frame-pointer"="all" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+
+!llvm.module.flags = !{!0, !1, !2, !3, !4}
+!llvm.ident = !{!5}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{i32 7, !"PIC Level", i32 2}
+!2 = !{i32 7, !"PIE Level", i32 2}
+!3 = !{i32 7, !"uwtable", i32 2}
+!4 = !{i32 7, !"frame-pointer", i32 2}
+!5 = !{!"Ubuntu clang version 15.0.7"}
+!6 = distinct !{!6, !7}
+!7 = !{!"llvm.loop.mustprogress"}
+!8 = distinct !{!8, !7}
+!9 = distinct !{!9, !7}
@@ -0,0 +1,17 @@
+extern void print(int);
+extern int read();
+
+int func(int a){
+	int b;
+	int c;
+	int d;
+	int e;
+	b = read();
+	c = a * b + a * 3;
+	d = (a + b) * 4 - b * 4;
+	e = (c + 5) - 5 + c;
+	print(c);
+	print(d);
+	print(e);
+	return c + d + e;
+}
@@ -0,0 +1,26 @@
+extern void print(int);
+extern int read();
+
+int func(int n){
+	int x;
+	int y;
+	int i;
+	int s;
+	x = read();
+	if (n > 0) {
+		y = 4;
+		x = 1;
+	} else {
+		y = 4;
+		x = 2;
+	}
+	s = 0;
+	i = 0;
+	while (i < n) {
+		s = s + y;
+		i = i + 1;
+	}
+	print(s);
+	print(x);
+	return s + y;
+}
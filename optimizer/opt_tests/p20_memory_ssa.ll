@@ -0,0 +1,79 @@
+; ModuleID = 'p20_memory_ssa.c'
+source_filename = "p20_memory_ssa.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+; Function Attrs: noinline nounwind optnone uwtable
+define dso_local i32 @func(i32 noundef %0) #0 {
+  %2 = alloca i32, align 4
+  %3 = alloca i32, align 4
+  %4 = alloca i32, align 4
+  %5 = alloca i32, align 4
+  %6 = alloca i32, align 4
+  store i32 %0, ptr %2, align 4
+  %7 = call i32 (...) @read()
+  store i32 %7, ptr %3, align 4
+  %8 = load i32, ptr %2, align 4
+  %9 = icmp sgt i32 %8, 0
+  br i1 %9, label %10, label %11
+
+10:                                               ; preds = %1
+  store i32 4, ptr %4, align 4
+  store i32 1, ptr %3, align 4
+  br label %12
+
+11:                                               ; preds = %1
+  store i32 4, ptr %4, align 4
+  store i32 2, ptr %3, align 4
+  br label %12
+
+12:                                               ; preds = %11, %10
+  store i32 0, ptr %6, align 4
+  store i32 0, ptr %5, align 4
+  br label %13
+
+13:                                               ; preds = %17, %12
+  %14 = load i32, ptr %5, align 4
+  %15 = load i32, ptr %2, align 4
+  %16 = icmp slt i32 %14, %15
+  br i1 %16, label %17, label %23
+
+17:                                               ; preds = %13
+  %18 = load i32, ptr %6, align 4
+  %19 = load i32, ptr %4, align 4
+  %20 = add nsw i32 %18, %19
+  store i32 %20, ptr %6, align 4
+  %21 = load i32, ptr %5, align 4
+  %22 = add nsw i32 %21, 1
+  store i32 %22, ptr %5, align 4
+  br label %13, !llvm.loop !6
+
+23:                                               ; preds = %13
+  %24 = load i32, ptr %6, align 4
+  call void @print(i32 noundef %24)
+  %25 = load i32, ptr %3, align 4
+  call void @print(i32 noundef %25)
+  %26 = load i32, ptr %6, align 4
+  %27 = load i32, ptr %4, align 4
+  %28 = add nsw i32 %26, %27
+  ret i32 %28
+}
+
+declare i32 @read(...) #1
+
+declare void @print(i32 noundef) #1
+
+attributes #0 = { noinline nounwind optnone uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+attributes #1 = { "frame-pointer"="all" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+
+!llvm.module.flags = !{!0, !1, !2, !3, !4}
+!llvm.ident = !{!5}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{i32 7, !"PIC Level", i32 2}
+!2 = !{i32 7, !"PIE Level", i32 2}
+!3 = !{i32 7, !"uwtable", i32 2}
+!4 = !{i32 7, !"frame-pointer", i32 2}
+!5 = !{!"Ubuntu clang version 15.0.7"}
+!6 = distinct !{!6, !7}
+!7 = !{!"llvm.loop.mustprogress"}
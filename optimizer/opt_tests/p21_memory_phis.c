@@ -0,0 +1,89 @@
+extern void print(int);
+extern int read();
+
+int func(int n){
+	int v;
+	v = read();
+	if (n > 0) {
+		v = 10;
+		if (n > 20) print(0);
+	}
+	if (n > 1) {
+		v = 11;
+		if (n > 20) print(1);
+	}
+	if (n > 2) {
+		v = 12;
+		if (n > 20) print(2);
+	}
+	if (n > 3) {
+		v = 13;
+		if (n > 20) print(3);
+	}
+	if (n > 4) {
+		v = 14;
+		if (n > 20) print(4);
+	}
+	if (n > 5) {
+		v = 15;
+		if (n > 20) print(5);
+	}
+	if (n > 6) {
+		v = 16;
+		if (n > 20) print(6);
+	}
+	if (n > 7) {
+		v = 17;
+		if (n > 20) print(7);
+	}
+	if (n > 8) {
+		v = 18;
+		if (n > 20) print(8);
+	}
+	if (n > 9) {
+		v = 19;
+		if (n > 20) print(9);
+	}
+	if (n > 10) {
+		v = 20;
+		if (n > 20) print(10);
+	}
+	if (n > 11) {
+		v = 21;
+		if (n > 20) print(11);
+	}
+	if (n > 12) {
+		v = 22;
+		if (n > 20) print(12);
+	}
+	if (n > 13) {
+		v = 23;
+		if (n > 20) print(13);
+	}
+	if (n > 14) {
+		v = 24;
+		if (n > 20) print(14);
+	}
+	if (n > 15) {
+		v = 25;
+		if (n > 20) print(15);
+	}
+	if (n > 16) {
+		v = 26;
+		if (n > 20) print(16);
+	}
+	if (n > 17) {
+		v = 27;
+		if (n > 20) print(17);
+	}
+	if (n > 18) {
+		v = 28;
+		if (n > 20) print(18);
+	}
+	if (n > 19) {
+		v = 29;
+		if (n > 20) print(19);
+	}
+	print(v);
+	return v;
+}
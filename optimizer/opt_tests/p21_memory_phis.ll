@@ -0,0 +1,394 @@
+; ModuleID = 'p21_memory_phis.c'
+source_filename = "p21_memory_phis.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+; Function Attrs: noinline nounwind optnone uwtable
+define dso_local i32 @func(i32 noundef %0) #0 {
+  %2 = alloca i32, align 4
+  %3 = alloca i32, align 4
+  store i32 %0, ptr %2, align 4
+  %4 = call i32 (...) @read()
+  store i32 %4, ptr %3, align 4
+  %5 = load i32, ptr %2, align 4
+  %6 = icmp sgt i32 %5, 0
+  br i1 %6, label %7, label %12
+
+7:                                                ; preds = %1
+  store i32 10, ptr %3, align 4
+  %8 = load i32, ptr %2, align 4
+  %9 = icmp sgt i32 %8, 20
+  br i1 %9, label %10, label %11
+
+10:                                               ; preds = %7
+  call void @print(i32 noundef 0)
+  br label %11
+
+11:                                               ; preds = %10, %7
+  br label %12
+
+12:                                               ; preds = %11, %1
+  %13 = load i32, ptr %2, align 4
+  %14 = icmp sgt i32 %13, 1
+  br i1 %14, label %15, label %20
+
+15:                                               ; preds = %12
+  store i32 11, ptr %3, align 4
+  %16 = load i32, ptr %2, align 4
+  %17 = icmp sgt i32 %16, 20
+  br i1 %17, label %18, label %19
+
+18:                                               ; preds = %15
+  call void @print(i32 noundef 1)
+  br label %19
+
+19:                                               ; preds = %18, %15
+  br label %20
+
+20:                                               ; preds = %19, %12
+  %21 = load i32, ptr %2, align 4
+  %22 = icmp sgt i32 %21, 2
+  br i1 %22, label %23, label %28
+
+23:                                               ; preds = %20
+  store i32 12, ptr %3, align 4
+  %24 = load i32, ptr %2, align 4
+  %25 = icmp sgt i32 %24, 20
+  br i1 %25, label %26, label %27
+
+26:                                               ; preds = %23
+  call void @print(i32 noundef 2)
+  br label %27
+
+27:                                               ; preds = %26, %23
+  br label %28
+
+28:                                               ; preds = %27, %20
+  %29 = load i32, ptr %2, align 4
+  %30 = icmp sgt i32 %29, 3
+  br i1 %30, label %31, label %36
+
+31:                                               ; preds = %28
+  store i32 13, ptr %3, align 4
+  %32 = load i32, ptr %2, align 4
+  %33 = icmp sgt i32 %32, 20
+  br i1 %33, label %34, label %35
+
+34:                                               ; preds = %31
+  call void @print(i32 noundef 3)
+  br label %35
+
+35:                                               ; preds = %34, %31
+  br label %36
+
+36:                                               ; preds = %35, %28
+  %37 = load i32, ptr %2, align 4
+  %38 = icmp sgt i32 %37, 4
+  br i1 %38, label %39, label %44
+
+39:                                               ; preds = %36
+  store i32 14, ptr %3, align 4
+  %40 = load i32, ptr %2, align 4
+  %41 = icmp sgt i32 %40, 20
+  br i1 %41, label %42, label %43
+
+42:                                               ; preds = %39
+  call void @print(i32 noundef 4)
+  br label %43
+
+43:                                               ; preds = %42, %39
+  br label %44
+
+44:                                               ; preds = %43, %36
+  %45 = load i32, ptr %2, align 4
+  %46 = icmp sgt i32 %45, 5
+  br i1 %46, label %47, label %52
+
+47:                                               ; preds = %44
+  store i32 15, ptr %3, align 4
+  %48 = load i32, ptr %2, align 4
+  %49 = icmp sgt i32 %48, 20
+  br i1 %49, label %50, label %51
+
+50:                                               ; preds = %47
+  call void @print(i32 noundef 5)
+  br label %51
+
+51:                                               ; preds = %50, %47
+  br label %52
+
+52:                                               ; preds = %51, %44
+  %53 = load i32, ptr %2, align 4
+  %54 = icmp sgt i32 %53, 6
+  br i1 %54, label %55, label %60
+
+55:                                               ; preds = %52
+  store i32 16, ptr %3, align 4
+  %56 = load i32, ptr %2, align 4
+  %57 = icmp sgt i32 %56, 20
+  br i1 %57, label %58, label %59
+
+58:                                               ; preds = %55
+  call void @print(i32 noundef 6)
+  br label %59
+
+59:                                               ; preds = %58, %55
+  br label %60
+
+60:                                               ; preds = %59, %52
+  %61 = load i32, ptr %2, align 4
+  %62 = icmp sgt i32 %61, 7
+  br i1 %62, label %63, label %68
+
+63:                                               ; preds = %60
+  store i32 17, ptr %3, align 4
+  %64 = load i32, ptr %2, align 4
+  %65 = icmp sgt i32 %64, 20
+  br i1 %65, label %66, label %67
+
+66:                                               ; preds = %63
+  call void @print(i32 noundef 7)
+  br label %67
+
+67:                                               ; preds = %66, %63
+  br label %68
+
+68:                                               ; preds = %67, %60
+  %69 = load i32, ptr %2, align 4
+  %70 = icmp sgt i32 %69, 8
+  br i1 %70, label %71, label %76
+
+71:                                               ; preds = %68
+  store i32 18, ptr %3, align 4
+  %72 = load i32, ptr %2, align 4
+  %73 = icmp sgt i32 %72, 20
+  br i1 %73, label %74, label %75
+
+74:                                               ; preds = %71
+  call void @print(i32 noundef 8)
+  br label %75
+
+75:                                               ; preds = %74, %71
+  br label %76
+
+76:                                               ; preds = %75, %68
+  %77 = load i32, ptr %2, align 4
+  %78 = icmp sgt i32 %77, 9
+  br i1 %78, label %79, label %84
+
+79:                                               ; preds = %76
+  store i32 19, ptr %3, align 4
+  %80 = load i32, ptr %2, align 4
+  %81 = icmp sgt i32 %80, 20
+  br i1 %81, label %82, label %83
+
+82:                                               ; preds = %79
+  call void @print(i32 noundef 9)
+  br label %83
+
+83:                                               ; preds = %82, %79
+  br label %84
+
+84:                                               ; preds = %83, %76
+  %85 = load i32, ptr %2, align 4
+  %86 = icmp sgt i32 %85, 10
+  br i1 %86, label %87, label %92
+
+87:                                               ; preds = %84
+  store i32 20, ptr %3, align 4
+  %88 = load i32, ptr %2, align 4
+  %89 = icmp sgt i32 %88, 20
+  br i1 %89, label %90, label %91
+
+90:                                               ; preds = %87
+  call void @print(i32 noundef 10)
+  br label %91
+
+91:                                               ; preds = %90, %87
+  br label %92
+
+92:                                               ; preds = %91, %84
+  %93 = load i32, ptr %2, align 4
+  %94 = icmp sgt i32 %93, 11
+  br i1 %94, label %95, label %100
+
+95:                                               ; preds = %92
+  store i32 21, ptr %3, align 4
+  %96 = load i32, ptr %2, align 4
+  %97 = icmp sgt i32 %96, 20
+  br i1 %97, label %98, label %99
+
+98:                                               ; preds = %95
+  call void @print(i32 noundef 11)
+  br label %99
+
+99:                                               ; preds = %98, %95
+  br label %100
+
+100:                                              ; preds = %99, %92
+  %101 = load i32, ptr %2, align 4
+  %102 = icmp sgt i32 %101, 12
+  br i1 %102, label %103, label %108
+
+103:                                              ; preds = %100
+  store i32 22, ptr %3, align 4
+  %104 = load i32, ptr %2, align 4
+  %105 = icmp sgt i32 %104, 20
+  br i1 %105, label %106, label %107
+
+106:                                              ; preds = %103
+  call void @print(i32 noundef 12)
+  br label %107
+
+107:                                              ; preds = %106, %103
+  br label %108
+
+108:                                              ; preds = %107, %100
+  %109 = load i32, ptr %2, align 4
+  %110 = icmp sgt i32 %109, 13
+  br i1 %110, label %111, label %116
+
+111:                                              ; preds = %108
+  store i32 23, ptr %3, align 4
+  %112 = load i32, ptr %2, align 4
+  %113 = icmp sgt i32 %112, 20
+  br i1 %113, label %114, label %115
+
+114:                                              ; preds = %111
+  call void @print(i32 noundef 13)
+  br label %115
+
+115:                                              ; preds = %114, %111
+  br label %116
+
+116:                                              ; preds = %115, %108
+  %117 = load i32, ptr %2, align 4
+  %118 = icmp sgt i32 %117, 14
+  br i1 %118, label %119, label %124
+
+119:                                              ; preds = %116
+  store i32 24, ptr %3, align 4
+  %120 = load i32, ptr %2, align 4
+  %121 = icmp sgt i32 %120, 20
+  br i1 %121, label %122, label %123
+
+122:                                              ; preds = %119
+  call void @print(i32 noundef 14)
+  br label %123
+
+123:                                              ; preds = %122, %119
+  br label %124
+
+124:                                              ; preds = %123, %116
+  %125 = load i32, ptr %2, align 4
+  %126 = icmp sgt i32 %125, 15
+  br i1 %126, label %127, label %132
+
+127:                                              ; preds = %124
+  store i32 25, ptr %3, align 4
+  %128 = load i32, ptr %2, align 4
+  %129 = icmp sgt i32 %128, 20
+  br i1 %129, label %130, label %131
+
+130:                                              ; preds = %127
+  call void @print(i32 noundef 15)
+  br label %131
+
+131:                                              ; preds = %130, %127
+  br label %132
+
+132:                                              ; preds = %131, %124
+  %133 = load i32, ptr %2, align 4
+  %134 = icmp sgt i32 %133, 16
+  br i1 %134, label %135, label %140
+
+135:                                              ; preds = %132
+  store i32 26, ptr %3, align 4
+  %136 = load i32, ptr %2, align 4
+  %137 = icmp sgt i32 %136, 20
+  br i1 %137, label %138, label %139
+
+138:                                              ; preds = %135
+  call void @print(i32 noundef 16)
+  br label %139
+
+139:                                              ; preds = %138, %135
+  br label %140
+
+140:                                              ; preds = %139, %132
+  %141 = load i32, ptr %2, align 4
+  %142 = icmp sgt i32 %141, 17
+  br i1 %142, label %143, label %148
+
+143:                                              ; preds = %140
+  store i32 27, ptr %3, align 4
+  %144 = load i32, ptr %2, align 4
+  %145 = icmp sgt i32 %144, 20
+  br i1 %145, label %146, label %147
+
+146:                                              ; preds = %143
+  call void @print(i32 noundef 17)
+  br label %147
+
+147:                                              ; preds = %146, %143
+  br label %148
+
+148:                                              ; preds = %147, %140
+  %149 = load i32, ptr %2, align 4
+  %150 = icmp sgt i32 %149, 18
+  br i1 %150, label %151, label %156
+
+151:                                              ; preds = %148
+  store i32 28, ptr %3, align 4
+  %152 = load i32, ptr %2, align 4
+  %153 = icmp sgt i32 %152, 20
+  br i1 %153, label %154, label %155
+
+154:                                              ; preds = %151
+  call void @print(i32 noundef 18)
+  br label %155
+
+155:                                              ; preds = %154, %151
+  br label %156
+
+156:                                              ; preds = %155, %148
+  %157 = load i32, ptr %2, align 4
+  %158 = icmp sgt i32 %157, 19
+  br i1 %158, label %159, label %164
+
+159:                                              ; preds = %156
+  store i32 29, ptr %3, align 4
+  %160 = load i32, ptr %2, align 4
+  %161 = icmp sgt i32 %160, 20
+  br i1 %161, label %162, label %163
+
+162:                                              ; preds = %159
+  call void @print(i32 noundef 19)
+  br label %163
+
+163:                                              ; preds = %162, %159
+  br label %164
+
+164:                                              ; preds = %163, %156
+  %165 = load i32, ptr %3, align 4
+  call void @print(i32 noundef %165)
+  %166 = load i32, ptr %3, align 4
+  ret i32 %166
+}
+
+declare i32 @read(...) #1
+
+declare void @print(i32 noundef) #1
+
+attributes #0 = { noinline nounwind optnone uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+attributes #1 = { "frame-pointer"="all" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+
+!llvm.module.flags = !{!0, !1, !2, !3, !4}
+!llvm.ident = !{!5}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{i32 7, !"PIC Level", i32 2}
+!2 = !{i32 7, !"PIE Level", i32 2}
+!3 = !{i32 7, !"uwtable", i32 2}
+!4 = !{i32 7, !"frame-pointer", i32 2}
+!5 = !{!"Ubuntu clang version 15.0.7"}
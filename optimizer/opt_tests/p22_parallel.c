@@ -0,0 +1,41 @@
+extern void print(int);
+extern int read();
+
+int scale(int a, int b){
+	int sum;
+	sum = a + b;
+	return sum * b - a;
+}
+
+int total(int n){
+	int i;
+	int sum;
+	i = 0;
+	sum = 0;
+	while (i < n) {
+		sum = sum + scale(i, n);
+		i = i + 1;
+	}
+	return sum;
+}
+
+int alternate(int n){
+	int i;
+	int sum;
+	i = 0;
+	sum = 0;
+	while (i < n) {
+		if (i % 2 == 0) sum = sum + scale(n, i);
+		else sum = sum - i;
+		i = i + 1;
+	}
+	return sum;
+}
+
+int func(int n){
+	int x;
+	x = read();
+	print(total(n));
+	print(alternate(x));
+	return total(x) + alternate(n);
+}
@@ -0,0 +1,150 @@
+; ModuleID = 'p22_parallel.c'
+source_filename = "p22_parallel.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+; Function Attrs: noinline nounwind optnone uwtable
+define dso_local i32 @scale(i32 noundef %a, i32 noundef %b) #0 {
+entry:
+  %a.addr = alloca i32, align 4
+  %b.addr = alloca i32, align 4
+  %sum = alloca i32, align 4
+  store i32 %a, ptr %a.addr, align 4
+  store i32 %b, ptr %b.addr, align 4
+  %0 = load i32, ptr %a.addr, align 4
+  %1 = load i32, ptr %b.addr, align 4
+  %add = add nsw i32 %0, %1
+  store i32 %add, ptr %sum, align 4
+  %2 = load i32, ptr %sum, align 4
+  %3 = load i32, ptr %b.addr, align 4
+  %mul = mul nsw i32 %2, %3
+  %4 = load i32, ptr %a.addr, align 4
+  %sub = sub nsw i32 %mul, %4
+  ret i32 %sub
+}
+
+; Function Attrs: noinline nounwind optnone uwtable
+define dso_local i32 @total(i32 noundef %n) #0 {
+entry:
+  %n.addr = alloca i32, align 4
+  %i = alloca i32, align 4
+  %sum = alloca i32, align 4
+  store i32 %n, ptr %n.addr, align 4
+  store i32 0, ptr %i, align 4
+  store i32 0, ptr %sum, align 4
+  br label %while.cond
+
+while.cond:                                       ; preds = %while.body, %entry
+  %0 = load i32, ptr %i, align 4
+  %1 = load i32, ptr %n.addr, align 4
+  %cmp = icmp slt i32 %0, %1
+  br i1 %cmp, label %while.body, label %while.end
+
+while.body:                                       ; preds = %while.cond
+  %2 = load i32, ptr %sum, align 4
+  %3 = load i32, ptr %i, align 4
+  %4 = load i32, ptr %n.addr, align 4
+  %call = call i32 @scale(i32 noundef %3, i32 noundef %4)
+  %add = add nsw i32 %2, %call
+  store i32 %add, ptr %sum, align 4
+  %5 = load i32, ptr %i, align 4
+  %add1 = add nsw i32 %5, 1
+  store i32 %add1, ptr %i, align 4
+  br label %while.cond, !llvm.loop !6
+
+while.end:                                        ; preds = %while.cond
+  %6 = load i32, ptr %sum, align 4
+  ret i32 %6
+}
+
+; Function Attrs: noinline nounwind optnone uwtable
+define dso_local i32 @alternate(i32 noundef %n) #0 {
+entry:
+  %n.addr = alloca i32, align 4
+  %i = alloca i32, align 4
+  %sum = alloca i32, align 4
+  store i32 %n, ptr %n.addr, align 4
+  store i32 0, ptr %i, align 4
+  store i32 0, ptr %sum, align 4
+  br label %while.cond
+
+while.cond:                                       ; preds = %if.end, %entry
+  %0 = load i32, ptr %i, align 4
+  %1 = load i32, ptr %n.addr, align 4
+  %cmp = icmp slt i32 %0, %1
+  br i1 %cmp, label %while.body, label %while.end
+
+while.body:                                       ; preds = %while.cond
+  %2 = load i32, ptr %i, align 4
+  %rem = srem i32 %2, 2
+  %cmp1 = icmp eq i32 %rem, 0
+  br i1 %cmp1, label %if.then, label %if.else
+
+if.then:                                          ; preds = %while.body
+  %3 = load i32, ptr %sum, align 4
+  %4 = load i32, ptr %n.addr, align 4
+  %5 = load i32, ptr %i, align 4
+  %call = call i32 @scale(i32 noundef %4, i32 noundef %5)
+  %add = add nsw i32 %3, %call
+  store i32 %add, ptr %sum, align 4
+  br label %if.end
+
+if.else:                                          ; preds = %while.body
+  %6 = load i32, ptr %sum, align 4
+  %7 = load i32, ptr %i, align 4
+  %sub = sub nsw i32 %6, %7
+  store i32 %sub, ptr %sum, align 4
+  br label %if.end
+
+if.end:                                           ; preds = %if.else, %if.then
+  %8 = load i32, ptr %i, align 4
+  %add2 = add nsw i32 %8, 1
+  store i32 %add2, ptr %i, align 4
+  br label %while.cond, !llvm.loop !8
+
+while.end:                                        ; preds = %while.cond
+  %9 = load i32, ptr %sum, align 4
+  ret i32 %9
+}
+
+; Function Attrs: noinline nounwind optnone uwtable
+define dso_local i32 @func(i32 noundef %n) #0 {
+entry:
+  %n.addr = alloca i32, align 4
+  %x = alloca i32, align 4
+  store i32 %n, ptr %n.addr, align 4
+  %call = call i32 (...) @read()
+  store i32 %call, ptr %x, align 4
+  %0 = load i32, ptr %n.addr, align 4
+  %call1 = call i32 @total(i32 noundef %0)
+  call void @print(i32 noundef %call1)
+  %1 = load i32, ptr %x, align 4
+  %call2 = call i32 @alternate(i32 noundef %1)
+  call void @print(i32 noundef %call2)
+  %2 = load i32, ptr %x, align 4
+  %call3 = call i32 @total(i32 noundef %2)
+  %3 = load i32, ptr %n.addr, align 4
+  %call4 = call i32 @alternate(i32 noundef %3)
+  %add = add nsw i32 %call3, %call4
+  ret i32 %add
+}
+
+declare i32 @read(...) #1
+
+declare void @print(i32 noundef) #1
+
+attributes #0 = { noinline nounwind optnone uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+attributes #1 = { "frame-pointer"="all" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+
+!llvm.module.flags = !{!0, !1, !2, !3, !4}
+!llvm.ident = !{!5}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{i32 7, !"PIC Level", i32 2}
+!2 = !{i32 7, !"PIE Level", i32 2}
+!3 = !{i32 7, !"uwtable", i32 2}
+!4 = !{i32 7, !"frame-pointer", i32 2}
+!5 = !{!"Ubuntu clang version 15.0.7"}
+!6 = distinct !{!6, !7}
+!7 = !{!"llvm.loop.mustprogress"}
+!8 = distinct !{!8, !7}
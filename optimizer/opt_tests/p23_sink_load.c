@@ -0,0 +1,15 @@
+extern void print(int);
+
+int g;
+
+int func(int n){
+	int v;
+	v = g;
+	if (n > 3) {
+		g = 5;
+		print(v + 1);
+	} else {
+		g = 7;
+	}
+	return g;
+}
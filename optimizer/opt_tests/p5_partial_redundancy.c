@@ -0,0 +1,22 @@
+extern void print(int);
+extern int read();
+
+int func(int i){
+	int a;
+	int b;
+	int c;
+	int d;
+
+	a = read();
+	b = read();
+	if (a > i) {
+		c = a + b;
+	}
+	else {
+		c = 0;
+	}
+	d = a + b;
+	print(c);
+	print(d);
+	return d;
+}
@@ -0,0 +1,62 @@
+; ModuleID = 'p5_partial_redundancy.c'
+source_filename = "p5_partial_redundancy.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+; Function Attrs: noinline nounwind optnone uwtable
+define dso_local i32 @func(i32 noundef %0) #0 {
+  %2 = alloca i32, align 4
+  %3 = alloca i32, align 4
+  %4 = alloca i32, align 4
+  %5 = alloca i32, align 4
+  %6 = alloca i32, align 4
+  store i32 %0, ptr %2, align 4
+  %7 = call i32 (...) @read()
+  store i32 %7, ptr %3, align 4
+  %8 = call i32 (...) @read()
+  store i32 %8, ptr %4, align 4
+  %9 = load i32, ptr %3, align 4
+  %10 = load i32, ptr %2, align 4
+  %11 = icmp sgt i32 %9, %10
+  br i1 %11, label %12, label %16
+
+12:                                               ; preds = %1
+  %13 = load i32, ptr %3, align 4
+  %14 = load i32, ptr %4, align 4
+  %15 = add nsw i32 %13, %14
+  store i32 %15, ptr %5, align 4
+  br label %17
+
+16:                                               ; preds = %1
+  store i32 0, ptr %5, align 4
+  br label %17
+
+17:                                               ; preds = %16, %12
+  %18 = load i32, ptr %3, align 4
+  %19 = load i32, ptr %4, align 4
+  %20 = add nsw i32 %18, %19
+  store i32 %20, ptr %6, align 4
+  %21 = load i32, ptr %5, align 4
+  call void @print(i32 noundef %21)
+  %22 = load i32, ptr %6, align 4
+  call void @print(i32 noundef %22)
+  %23 = load i32, ptr %6, align 4
+  ret i32 %23
+}
+
+declare i32 @read(...) #1
+
+declare void @print(i32 noundef) #1
+
+attributes #0 = { noinline nounwind optnone uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+attributes #1 = { "frame-pointer"="all" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+
+!llvm.module.flags = !{!0, !1, !2, !3, !4}
+!llvm.ident = !{!5}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{i32 7, !"PIC Level", i32 2}
+!2 = !{i32 7, !"PIE Level", i32 2}
+!3 = !{i32 7, !"uwtable", i32 2}
+!4 = !{i32 7, !"frame-pointer", i32 2}
+!5 = !{!"Ubuntu clang version 15.0.7"}
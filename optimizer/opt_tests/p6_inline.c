@@ -0,0 +1,32 @@
+#include<stdio.h>
+
+int read(){
+	int x;
+	scanf("%d", &x); 
+	return x;
+}
+
+void print(int x){
+	printf("%d\n", x);
+}
+
+int square(int x){
+	return x * x;
+}
+
+int func(int i){
+	int a;
+	int b;
+
+	a = read();
+	b = square(i) + a;
+	print(a);
+	print(b);
+	return b;
+}
+
+int main(){
+	int i = func(5);
+	printf("In main printing return value of test: %d\n", i);
+	return 0;
+}
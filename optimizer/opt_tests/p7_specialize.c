@@ -0,0 +1,21 @@
+extern void print(int);
+extern int read();
+
+static int count(int n, int step){
+	int a;
+	a = 0;
+	while (a < n){
+		a = a + step;
+	}
+	return a;
+}
+
+int func(int i){
+	int x;
+	int y;
+	x = count(i, 2);
+	y = count(10, 2);
+	print(x);
+	print(y);
+	return x + y;
+}
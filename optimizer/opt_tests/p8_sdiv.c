@@ -0,0 +1,19 @@
+extern void print(int);
+
+int func(int x){
+	int c;
+	c = -100;
+	print(x / 1);
+	print(x / -1);
+	print(x / 8);
+	print(x / -8);
+	print(x / 3);
+	print(x / 7);
+	print(x / -7);
+	print(x / 641);
+	print(x / (-2147483647 - 1));
+	print(x / 2);
+	print(x / -2);
+	print(c / 7);
+	return x / 10;
+}
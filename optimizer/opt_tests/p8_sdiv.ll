@@ -0,0 +1,66 @@
+; ModuleID = 'p8_sdiv.c'
+source_filename = "p8_sdiv.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+; Function Attrs: noinline nounwind optnone uwtable
+define dso_local i32 @func(i32 noundef %0) #0 {
+  %2 = alloca i32, align 4
+  %3 = alloca i32, align 4
+  store i32 %0, ptr %2, align 4
+  store i32 -100, ptr %3, align 4
+  %4 = load i32, ptr %2, align 4
+  %5 = sdiv i32 %4, 1
+  call void @print(i32 noundef %5)
+  %6 = load i32, ptr %2, align 4
+  %7 = sdiv i32 %6, -1
+  call void @print(i32 noundef %7)
+  %8 = load i32, ptr %2, align 4
+  %9 = sdiv i32 %8, 8
+  call void @print(i32 noundef %9)
+  %10 = load i32, ptr %2, align 4
+  %11 = sdiv i32 %10, -8
+  call void @print(i32 noundef %11)
+  %12 = load i32, ptr %2, align 4
+  %13 = sdiv i32 %12, 3
+  call void @print(i32 noundef %13)
+  %14 = load i32, ptr %2, align 4
+  %15 = sdiv i32 %14, 7
+  call void @print(i32 noundef %15)
+  %16 = load i32, ptr %2, align 4
+  %17 = sdiv i32 %16, -7
+  call void @print(i32 noundef %17)
+  %18 = load i32, ptr %2, align 4
+  %19 = sdiv i32 %18, 641
+  call void @print(i32 noundef %19)
+  %20 = load i32, ptr %2, align 4
+  %21 = sdiv i32 %20, -2147483648
+  call void @print(i32 noundef %21)
+  %22 = load i32, ptr %2, align 4
+  %23 = sdiv i32 %22, 2
+  call void @print(i32 noundef %23)
+  %24 = load i32, ptr %2, align 4
+  %25 = sdiv i32 %24, -2
+  call void @print(i32 noundef %25)
+  %26 = load i32, ptr %3, align 4
+  %27 = sdiv i32 %26, 7
+  call void @print(i32 noundef %27)
+  %28 = load i32, ptr %2, align 4
+  %29 = sdiv i32 %28, 10
+  ret i32 %29
+}
+
+declare void @print(i32 noundef) #1
+
+attributes #0 = { noinline nounwind optnone uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+attributes #1 = { "frame-pointer"="all" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+
+!llvm.module.flags = !{!0, !1, !2, !3, !4}
+!llvm.ident = !{!5}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{i32 7, !"PIC Level", i32 2}
+!2 = !{i32 7, !"PIE Level", i32 2}
+!3 = !{i32 7, !"uwtable", i32 2}
+!4 = !{i32 7, !"frame-pointer", i32 2}
+!5 = !{!"Ubuntu clang version 15.0.7"}
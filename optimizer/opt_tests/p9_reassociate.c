@@ -0,0 +1,21 @@
+extern void print(int);
+extern int read();
+
+int func(int b){
+	int a;
+	int c;
+	int d;
+	int e;
+	int f;
+	int g;
+	d = read();
+	a = b + 1;
+	c = a + 2;
+	e = d * 4;
+	f = e * 5;
+	g = c - 10;
+	print(c);
+	print(f);
+	print(g + 7);
+	return a + d;
+}
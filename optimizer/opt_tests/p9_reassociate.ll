@@ -0,0 +1,61 @@
+; ModuleID = 'p9_reassociate.c'
+source_filename = "p9_reassociate.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+; Function Attrs: noinline nounwind optnone uwtable
+define dso_local i32 @func(i32 noundef %0) #0 {
+  %2 = alloca i32, align 4
+  %3 = alloca i32, align 4
+  %4 = alloca i32, align 4
+  %5 = alloca i32, align 4
+  %6 = alloca i32, align 4
+  %7 = alloca i32, align 4
+  %8 = alloca i32, align 4
+  store i32 %0, ptr %2, align 4
+  %9 = call i32 (...) @read()
+  store i32 %9, ptr %5, align 4
+  %10 = load i32, ptr %2, align 4
+  %11 = add nsw i32 %10, 1
+  store i32 %11, ptr %3, align 4
+  %12 = load i32, ptr %3, align 4
+  %13 = add nsw i32 %12, 2
+  store i32 %13, ptr %4, align 4
+  %14 = load i32, ptr %5, align 4
+  %15 = mul nsw i32 %14, 4
+  store i32 %15, ptr %6, align 4
+  %16 = load i32, ptr %6, align 4
+  %17 = mul nsw i32 %16, 5
+  store i32 %17, ptr %7, align 4
+  %18 = load i32, ptr %4, align 4
+  %19 = sub nsw i32 %18, 10
+  store i32 %19, ptr %8, align 4
+  %20 = load i32, ptr %4, align 4
+  call void @print(i32 noundef %20)
+  %21 = load i32, ptr %7, align 4
+  call void @print(i32 noundef %21)
+  %22 = load i32, ptr %8, align 4
+  %23 = add nsw i32 %22, 7
+  call void @print(i32 noundef %23)
+  %24 = load i32, ptr %3, align 4
+  %25 = load i32, ptr %5, align 4
+  %26 = add nsw i32 %24, %25
+  ret i32 %26
+}
+
+declare i32 @read(...) #1
+
+declare void @print(i32 noundef) #1
+
+attributes #0 = { noinline nounwind optnone uwtable "frame-pointer"="all" "min-legal-vector-width"="0" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+attributes #1 = { "frame-pointer"="all" "no-trapping-math"="true" "stack-protector-buffer-size"="8" "target-cpu"="x86-64" "target-features"="+cx8,+fxsr,+mmx,+sse,+sse2,+x87" "tune-cpu"="generic" }
+
+!llvm.module.flags = !{!0, !1, !2, !3, !4}
+!llvm.ident = !{!5}
+
+!0 = !{i32 1, !"wchar_size", i32 4}
+!1 = !{i32 7, !"PIC Level", i32 2}
+!2 = !{i32 7, !"PIE Level", i32 2}
+!3 = !{i32 7, !"uwtable", i32 2}
+!4 = !{i32 7, !"frame-pointer", i32 2}
+!5 = !{!"Ubuntu clang version 15.0.7"}
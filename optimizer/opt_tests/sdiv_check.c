@@ -0,0 +1,230 @@
+// Exhaustive check of the sdiv pass: for every 32-bit divisor d != 0, the sequence buildSDivByConstant emits
+// for x / d must give the truncated quotient for the edge-case dividends and a few random ones.
+//
+// Running the emitted IR 2^32 times would take days, so the check has two parts:
+// 1. modelSDiv, a transcription of the emitted sequence into C that uses signedDivisionMagic from the
+//    optimizer, is checked for every divisor. Each divisor falls into one shape of sequence (d = 1, d = -1,
+//    d = INT_MIN, +-2^k for each k, or divisor sign, multiplier sign and shift for the rest).
+// 2. For one divisor of every shape that came up, the sequence is built as IR by buildSDivByConstant and run
+//    by the compile-time evaluator on the same dividends, so the model cannot drift from the emitted code.
+//
+// With -quick both parts only run on quickDivisors, a fixed sample with divisors of every kind of shape, which
+// takes well under a second; "make sdiv-check" builds the checker and runs that.
+//
+// Build (from optimizer/):
+//   make sdiv_check
+// Usage: ./sdiv_check [first last | -quick]   (a range of divisors; all of them by default)
+
+#define main optimizerMain
+#include "../optimizer.c"
+#undef main
+
+#define NUM_SHAPES 256
+#define MAX_REPORTED 10 // failures printed per part
+
+// 1, -1 and INT32_MIN; +-2^k for small and large k; then for each sign of divisor and of magic multiplier,
+// divisors from the smallest shift to the largest (shift in the comments)
+const int32_t quickDivisors[] = {
+	1, -1, INT32_MIN,
+	2, -2, 4, -4, 8, -8, 1 << 15, -(1 << 15), 1 << 30, -(1 << 30),
+	3, 641, 5, 1000000007, INT32_MAX,             // d > 0, multiplier > 0: 0, 0, 1, 28, 29
+	7, 1000003, 1519526442,                       // d > 0, multiplier < 0: 2, 19, 30
+	-3, -7, -1000003, -1519526442,                // d < 0, multiplier > 0: 1, 2, 19, 30
+	-6, -641, -5, -1000000007, -INT32_MAX,        // d < 0, multiplier < 0: 0, 0, 1, 28, 29
+};
+
+// x / d as the emitted sequence computes it, in 32-bit two's complement arithmetic; magic is that of d when
+// it needs one
+int32_t modelSDiv(int32_t x, int32_t d, SDivMagic magic) {
+	if (d == 1) return x;
+	if (d == -1) return (int32_t)(0u - (uint32_t)x);
+	if (d == INT32_MIN) return x == INT32_MIN;
+
+	uint32_t ad = d < 0 ? 0u - (uint32_t)d : (uint32_t)d;
+	if ((ad & (ad - 1)) == 0) {
+		int k = 0;
+		while ((1u << k) != ad) k++;
+		uint32_t sign = k == 1 ? (uint32_t)x : (uint32_t)(x >> (k - 1));
+		uint32_t bias = sign >> (32 - k);
+		int32_t q = (int32_t)((uint32_t)x + bias) >> k;
+		return d < 0 ? (int32_t)(0u - (uint32_t)q) : q;
+	}
+
+	int32_t q = (int32_t)(((int64_t)x * magic.multiplier) >> 32);
+	if (d > 0 && magic.multiplier < 0) q = (int32_t)((uint32_t)q + (uint32_t)x);
+	if (d < 0 && magic.multiplier > 0) q = (int32_t)((uint32_t)q - (uint32_t)x);
+	if (magic.shift > 0) q >>= magic.shift;
+	return (int32_t)((uint32_t)q + ((uint32_t)q >> 31));
+}
+
+int shapeOf(int32_t d, SDivMagic magic) {
+	if (d == 1) return 0;
+	if (d == -1) return 1;
+	if (d == INT32_MIN) return 2;
+	uint32_t ad = d < 0 ? 0u - (uint32_t)d : (uint32_t)d;
+	if ((ad & (ad - 1)) == 0) {
+		int k = 0;
+		while ((1u << k) != ad) k++;
+		return 3 + (d < 0) * 31 + k;
+	}
+	return 128 + ((d < 0) * 2 + (magic.multiplier < 0)) * 32 + magic.shift;
+}
+
+// Edge cases around 0, the ends of the range and the multiples of d, then random dividends
+int dividendsFor(int32_t d, uint64_t& random, int32_t* out) {
+	int n = 0;
+	int32_t fixed[] = { 0, 1, -1, 2, -2, INT32_MAX, INT32_MAX - 1, INT32_MIN, INT32_MIN + 1 };
+	for (int32_t x : fixed) out[n++] = x;
+	int64_t multiples[] = { d, -(int64_t)d, (int64_t)INT32_MAX / d * d, (int64_t)INT32_MIN / d * d };
+	for (int64_t m : multiples) {
+		for (int64_t delta = -1; delta <= 1; delta++) {
+			if (m + delta >= INT32_MIN && m + delta <= INT32_MAX) out[n++] = (int32_t)(m + delta);
+		}
+	}
+	for (int i = 0; i < 4; i++) {
+		random ^= random << 13;
+		random ^= random >> 7;
+		random ^= random << 17;
+		out[n++] = (int32_t)random;
+	}
+	return n;
+}
+
+bool expected(int32_t x, int32_t d, int32_t& q) {
+	if (d == -1 && x == INT32_MIN) return false; // sdiv overflows
+	q = (int32_t)((int64_t)x / d);
+	return true;
+}
+
+struct RangeResult {
+	long failures = 0;
+	vector<string> reports;
+	vector<int64_t> representatives = vector<int64_t>(NUM_SHAPES, INT64_MAX);
+};
+
+void checkRange(int64_t first, int64_t last, RangeResult* result) {
+	uint64_t random = 0x9E3779B97F4A7C15ull ^ (uint64_t)first;
+	int32_t dividends[32];
+	for (int64_t d64 = first; d64 <= last; d64++) {
+		if (d64 == 0) continue;
+		int32_t d = (int32_t)d64;
+		uint32_t ad = d < 0 ? 0u - (uint32_t)d : (uint32_t)d;
+		SDivMagic magic = { 0, 0 };
+		if ((ad & (ad - 1)) != 0) magic = signedDivisionMagic(d);
+		int shape = shapeOf(d, magic);
+		if (result->representatives[shape] == INT64_MAX) result->representatives[shape] = d;
+		int n = dividendsFor(d, random, dividends);
+		for (int i = 0; i < n; i++) {
+			int32_t q;
+			if (!expected(dividends[i], d, q) || modelSDiv(dividends[i], d, magic) == q) continue;
+			if (result->failures++ < MAX_REPORTED) {
+				result->reports.push_back(to_string(dividends[i]) + " / " + to_string(d) + " = " +
+					to_string(modelSDiv(dividends[i], d, magic)) + ", expected " + to_string(q));
+			}
+		}
+	}
+}
+
+// Builds x / d as IR and runs it on the dividends; returns the number of wrong results
+long checkEmittedIR(LLVMContextRef context, int32_t d) {
+	LLVMModuleRef module = LLVMModuleCreateWithNameInContext("sdiv_check", context);
+	LLVMTypeRef i32 = LLVMInt32TypeInContext(context);
+	LLVMValueRef function = LLVMAddFunction(module, "divide", LLVMFunctionType(i32, &i32, 1, 0));
+	LLVMBuilderRef builder = LLVMCreateBuilderInContext(context);
+	LLVMPositionBuilderAtEnd(builder, LLVMAppendBasicBlockInContext(context, function, "entry"));
+	LLVMBuildRet(builder, buildSDivByConstant(builder, LLVMGetParam(function, 0), d));
+	LLVMDisposeBuilder(builder);
+
+	uint32_t ad = d < 0 ? 0u - (uint32_t)d : (uint32_t)d;
+	SDivMagic magic = { 0, 0 };
+	if ((ad & (ad - 1)) != 0) magic = signedDivisionMagic(d);
+
+	long failures = 0;
+	uint64_t random = 0x2545F4914F6CDD1Dull ^ (uint32_t)d;
+	int32_t dividends[32];
+	int n = dividendsFor(d, random, dividends);
+	for (int i = 0; i < n; i++) {
+		int32_t q;
+		if (!expected(dividends[i], d, q)) continue;
+		Evaluation evaluation = { 0, 0, {} };
+		vector<LLVMValueRef> args(1, LLVMConstInt(i32, (uint32_t)dividends[i], 0));
+		uint64_t bits;
+		if (!evaluateCall(evaluation, function, args, bits) || (int32_t)(uint32_t)bits != q ||
+				modelSDiv(dividends[i], d, magic) != q) {
+			if (failures++ < MAX_REPORTED) {
+				printf("IR for d = %d: %d / %d is wrong\n", d, dividends[i], d);
+			}
+		}
+	}
+	LLVMDisposeModule(module);
+	return failures;
+}
+
+// Checks the model and the emitted IR for the quickDivisors only
+int quickCheck() {
+	LLVMContextRef context = LLVMContextCreate();
+	RangeResult result;
+	long irFailures = 0;
+	int count = sizeof(quickDivisors) / sizeof(quickDivisors[0]);
+	for (int i = 0; i < count; i++) {
+		checkRange(quickDivisors[i], quickDivisors[i], &result);
+		irFailures += checkEmittedIR(context, quickDivisors[i]);
+	}
+	LLVMContextDispose(context);
+
+	for (string& report : result.reports) printf("%s\n", report.c_str());
+	int shapes = 0;
+	for (int64_t representative : result.representatives) shapes += representative != INT64_MAX;
+	printf("Quick check of %d divisors in %d sequence shapes: %ld wrong quotients in the model, %ld in the IR\n",
+		count, shapes, result.failures, irFailures);
+	return result.failures == 0 && irFailures == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+	int64_t first = INT32_MIN, last = INT32_MAX;
+	if (argc == 2 && strcmp(argv[1], "-quick") == 0) {
+		return quickCheck();
+	} else if (argc == 3) {
+		first = max<int64_t>(INT32_MIN, atoll(argv[1]));
+		last = min<int64_t>(INT32_MAX, atoll(argv[2]));
+	} else if (argc != 1) {
+		fprintf(stderr, "Usage: %s [first last | -quick]\n", argv[0]);
+		return 1;
+	}
+
+	// Part 1: the model on every divisor in the range, split over the hardware threads
+	int jobs = max(1u, thread::hardware_concurrency());
+	vector<RangeResult> results(jobs);
+	vector<thread> workers;
+	int64_t chunk = (last - first + jobs) / jobs;
+	for (int k = 0; k < jobs; k++) {
+		int64_t from = first + k * chunk, to = min(last, from + chunk - 1);
+		workers.push_back(thread(checkRange, from, to, &results[k]));
+	}
+	for (thread& worker : workers) worker.join();
+
+	long modelFailures = 0;
+	vector<int64_t> representatives(NUM_SHAPES, INT64_MAX);
+	for (RangeResult& result : results) {
+		modelFailures += result.failures;
+		for (string& report : result.reports) printf("%s\n", report.c_str());
+		for (int shape = 0; shape < NUM_SHAPES; shape++) {
+			representatives[shape] = min(representatives[shape], result.representatives[shape]);
+		}
+	}
+
+	// Part 2: the emitted IR for one divisor of every shape
+	LLVMContextRef context = LLVMContextCreate();
+	long irFailures = 0;
+	int shapes = 0;
+	for (int shape = 0; shape < NUM_SHAPES; shape++) {
+		if (representatives[shape] == INT64_MAX) continue;
+		irFailures += checkEmittedIR(context, (int32_t)representatives[shape]);
+		shapes++;
+	}
+	LLVMContextDispose(context);
+
+	printf("Divisors %lld to %lld: %ld wrong quotients; IR of %d sequence shapes: %ld wrong quotients\n",
+		(long long)first, (long long)last, modelFailures, shapes, irFailures);
+	return modelFailures == 0 && irFailures == 0 ? 0 : 1;
+}
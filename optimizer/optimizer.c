@@ -1,23 +1,199 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <time.h>
 #include <llvm-c/Core.h>
 #include <llvm-c/IRReader.h>
+#include <llvm-c/BitReader.h>
+#include <llvm-c/BitWriter.h>
 #include <llvm-c/Types.h>
 
 #include <unordered_set>
 #include <unordered_map>
 #include <list>
+#include <map>
 #include <vector>
 #include <string>
+#include <algorithm>
+#include <thread>
+#include <atomic>
 using namespace std;
 
-#define DEBUGGING 1
+// Tracing is selected at run time with -trace=<level>; IR is only formatted when its level is enabled
+#define TRACE_PASSES 1   // a summary line from each pass that changed something
+#define TRACE_CHANGES 2  // every individual change
+#define TRACE_IR 3       // also the basic blocks after each change
+#define TRACING(level) (traceLevel >= (level))
 
-/* This function reads the given llvm file and loads the LLVM IR into
-	 data-structures that we can works on for optimization phase.
+int traceLevel = 0;
+
+// Named counters of the pass that is running, e.g. "instructions folded"; owned by the pass manager.
+// Like the rest of the state passes keep between runs, it is per thread (see "Parallel optimization").
+thread_local map<string, long>* passCounters = NULL;
+
+void countStatistic(const char* name, long n = 1) {
+	if (passCounters != NULL && n != 0) (*passCounters)[name] += n;
+}
+
+// ---- Change tracking ----
+
+// Every change a pass makes is recorded against the function it is in (or, for passes that work block by block,
+// against the blocks it affects) with a stamp from a global clock. For every pass, the pass manager keeps the
+// stamp each function and block had when the pass last visited it; if that is still the latest stamp, the pass
+// changed nothing there and nothing else did since, so running it there again cannot do anything either and
+// it is skipped. Block stamps only count when they are newer than the last change to the function as a whole.
+// The interprocedural passes, which add and delete functions, mark the whole module changed instead, which
+// makes everything dirty.
+
+struct FunctionChanges {
+	unsigned version;      // latest change anywhere in the function
+	unsigned wholeVersion; // latest change that was not narrowed down to blocks
+	unordered_map<LLVMBasicBlockRef, unsigned> blockVersions;
+};
+
+struct FunctionStamp {
+	unsigned version;
+	unsigned size; // instructions, which stay the same while the version does
+};
+
+// The stamps of the functions and blocks a pass visited, as they were when it started on them
+struct CleanRecord {
+	unsigned epoch; // moduleEpoch the stamps belong to
+	unordered_map<LLVMValueRef, FunctionStamp> functions;
+	unordered_map<LLVMBasicBlockRef, unsigned> blocks;
+};
+
+thread_local unsigned changeClock = 0;
+thread_local unsigned moduleEpoch = 0; // bumped when the whole module changed
+thread_local unordered_map<LLVMValueRef, FunctionChanges> functionChanges;
+thread_local CleanRecord* passCleanRecord = NULL; // of the running pass; NULL visits everything
+thread_local LLVMValueRef focusFunction = NULL;    // if set, the only function the function passes go over
+
+// The functions a function pass goes over: all of them, or just focusFunction
+LLVMValueRef firstFunction(LLVMModuleRef module) {
+	return focusFunction != NULL ? focusFunction : LLVMGetFirstFunction(module);
+}
+
+LLVMValueRef nextFunction(LLVMValueRef function) {
+	return focusFunction != NULL ? NULL : LLVMGetNextFunction(function);
+}
+
+unsigned countBlockInstructions(LLVMBasicBlockRef bb) {
+	unsigned count = 0;
+	for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) count++;
+	return count;
+}
+
+unsigned blockVersion(LLVMBasicBlockRef bb) {
+	FunctionChanges& changes = functionChanges[LLVMGetBasicBlockParent(bb)];
+	auto it = changes.blockVersions.find(bb);
+	return it == changes.blockVersions.end() ? changes.wholeVersion : max(changes.wholeVersion, it->second);
+}
+
+// Whether the running pass has to look at function, counting the instructions it visits or skips. The pass
+// must mark whatever it then changes in the function.
+void forgetStaleRecord() {
+	if (passCleanRecord == NULL || passCleanRecord->epoch == moduleEpoch) return;
+	passCleanRecord->functions.clear();
+	passCleanRecord->blocks.clear();
+	passCleanRecord->epoch = moduleEpoch;
+}
+
+bool needsVisit(LLVMValueRef function) {
+	forgetStaleRecord();
+	unsigned version = 0;
+	if (passCleanRecord != NULL) {
+		version = functionChanges[function].version;
+		auto it = passCleanRecord->functions.find(function);
+		if (it != passCleanRecord->functions.end() && it->second.version == version) {
+			countStatistic("instructions skipped", it->second.size);
+			return false;
+		}
+	}
+	unsigned size = 0;
+	for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+		size += countBlockInstructions(bb);
+	}
+	if (passCleanRecord != NULL) passCleanRecord->functions[function] = { version, size };
+	countStatistic("instructions visited", size);
+	return true;
+}
+
+bool needsVisit(LLVMBasicBlockRef bb) {
+	forgetStaleRecord();
+	unsigned size = countBlockInstructions(bb);
+	if (passCleanRecord != NULL) {
+		unsigned version = blockVersion(bb);
+		auto it = passCleanRecord->blocks.find(bb);
+		if (it != passCleanRecord->blocks.end() && it->second == version) {
+			countStatistic("instructions skipped", size);
+			return false;
+		}
+		passCleanRecord->blocks[bb] = version;
+	}
+	countStatistic("instructions visited", size);
+	return true;
+}
+
+void markFunctionChanged(LLVMValueRef function) {
+	FunctionChanges& changes = functionChanges[function];
+	changes.version = changes.wholeVersion = ++changeClock;
+}
+
+void markBlockChanged(LLVMBasicBlockRef bb) {
+	FunctionChanges& changes = functionChanges[LLVMGetBasicBlockParent(bb)];
+	changes.version = changes.blockVersions[bb] = ++changeClock;
+}
+
+// Functions and blocks may have been deleted and their addresses reused
+void markModuleChanged() {
+	functionChanges.clear();
+	moduleEpoch++;
+}
+
+// A change to inst also concerns the blocks that use it and the blocks that define its operands
+void markInstructionChanged(LLVMValueRef inst) {
+	markBlockChanged(LLVMGetInstructionParent(inst));
+	for (LLVMUseRef use = LLVMGetFirstUse(inst); use; use = LLVMGetNextUse(use)) {
+		LLVMValueRef user = LLVMGetUser(use);
+		if (LLVMIsAInstruction(user)) markBlockChanged(LLVMGetInstructionParent(user));
+	}
+	int numOperands = LLVMGetNumOperands(inst);
+	for (int i = 0; i < numOperands; i++) {
+		LLVMValueRef operand = LLVMGetOperand(inst, i);
+		if (LLVMIsAInstruction(operand)) markBlockChanged(LLVMGetInstructionParent(operand));
+	}
+}
+
+// Whether a file starts with the bitcode magic number (or that of the bitcode wrapper header)
+bool isBitcode(const unsigned char* start, size_t size) {
+	if (size < 4) return false;
+	if (start[0] == 'B' && start[1] == 'C' && start[2] == 0xC0 && start[3] == 0xDE) return true;
+	return start[0] == 0xDE && start[1] == 0xC0 && start[2] == 0x17 && start[3] == 0x0B;
+}
+
+bool isBitcode(LLVMMemoryBufferRef buffer) {
+	return isBitcode((const unsigned char*) LLVMGetBufferStart(buffer), LLVMGetBufferSize(buffer));
+}
+
+bool isBitcodeFile(const char* filename) {
+	unsigned char start[4];
+	FILE* in = fopen(filename, "rb");
+	if (in == NULL) return false;
+	size_t size = fread(start, 1, sizeof(start), in);
+	fclose(in);
+	return isBitcode(start, size);
+}
+
+/* This function reads the given llvm file (textual IR or bitcode, told apart by
+	 the magic number) and loads the LLVM IR into data-structures that we can works
+	 on for optimization phase.
 */
-LLVMModuleRef createLLVMModel(char * filename){
+LLVMModuleRef createLLVMModel(const char * filename, LLVMContextRef context){
 	char *err = 0;
 
 	LLVMMemoryBufferRef ll_f = 0;
@@ -26,14 +202,23 @@ LLVMModuleRef createLLVMModel(char * filename){
 	LLVMCreateMemoryBufferWithContentsOfFile(filename, &ll_f, &err);
 
 	if (err != NULL) { 
-		printf("%s\n", err);
+		printf("%s: %s\n", filename, err);
+		LLVMDisposeMessage(err);
 		return NULL;
 	}
+
+	// The bitcode reader reports malformed input through the context, which exits
+	if (isBitcode(ll_f)) {
+		LLVMParseBitcodeInContext2(context, ll_f, &m);
+		LLVMDisposeMemoryBuffer(ll_f);
+		return m;
+	}
 	
-	LLVMParseIRInContext(LLVMGetGlobalContext(), ll_f, &m, &err);
+	LLVMParseIRInContext(context, ll_f, &m, &err);
 
 	if (err != NULL) {
 		printf("%s\n", err);
+		LLVMDisposeMessage(err);
 	}
 
 	return m;
@@ -73,6 +258,58 @@ void walkFunctions(LLVMModuleRef module){
  	}
 }
 
+// ---- Cached analyses ----
+
+// Interface of the analysis manager (see "Analysis manager" below): per-function results computed on first
+// request and kept until a pass that does not preserve them changes the function.
+
+enum AnalysisKind {
+	ANALYSIS_PREDECESSORS = 1 << 0,
+	ANALYSIS_RPO = 1 << 1,
+	ANALYSIS_DOMINATORS = 1 << 2,
+	ANALYSIS_LOOPS = 1 << 3,
+	ANALYSIS_ADDRESSES = 1 << 4,
+	ANALYSIS_REACHING_STORES = 1 << 5,
+	ANALYSIS_LIVE_LOADS = 1 << 6,
+	ANALYSIS_MEMORY_SSA = 1 << 7,
+};
+
+// Reaching stores and live loads are brought up to date with the loads and stores when asked for again, so
+// they only go with the CFG
+#define PRESERVE_NONE 0
+#define PRESERVE_CFG (ANALYSIS_PREDECESSORS | ANALYSIS_RPO | ANALYSIS_DOMINATORS | ANALYSIS_LOOPS | \
+	ANALYSIS_REACHING_STORES | ANALYSIS_LIVE_LOADS)
+#define PRESERVE_ALL (PRESERVE_CFG | ANALYSIS_ADDRESSES | ANALYSIS_MEMORY_SSA)
+
+// The loads and stores of a function by the address they access
+struct AddressIndex {
+	unordered_map<LLVMValueRef, vector<LLVMValueRef>> loads;
+	unordered_map<LLVMValueRef, vector<LLVMValueRef>> stores;
+};
+
+// Structure to hold all dataflow sets for a basic block
+struct BBDataflow {
+    unordered_set<LLVMValueRef> genSet;
+    unordered_set<LLVMValueRef> killSet;
+    unordered_set<LLVMValueRef> inSet;
+    unordered_set<LLVMValueRef> outSet;
+};
+
+unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>>& cachedPredecessors(LLVMValueRef function);
+vector<LLVMBasicBlockRef>& cachedReversePostOrder(LLVMValueRef function);
+AddressIndex& cachedAddresses(LLVMValueRef function);
+unordered_map<LLVMBasicBlockRef, BBDataflow>& cachedReachingStores(LLVMValueRef function);
+unordered_map<LLVMBasicBlockRef, BBDataflow>& cachedLiveLoads(LLVMValueRef function);
+
+// Memory SSA of the local variables (see "Memory SSA" below)
+struct MemorySSA;
+MemorySSA& cachedMemorySSA(LLVMValueRef function);
+bool memoryTracks(MemorySSA& memory, LLVMValueRef access);
+bool sameMemoryVersion(MemorySSA& memory, LLVMValueRef load1, LLVMValueRef load2);
+LLVMValueRef storedValue(MemorySSA& memory, LLVMValueRef load);
+bool storeIsDead(MemorySSA& memory, LLVMValueRef store);
+void invalidateAnalyses(LLVMValueRef function, unsigned preserved = PRESERVE_NONE);
+
 // ---- Subexpression elimination ----
 
 bool operandsEqual(LLVMValueRef op1, LLVMValueRef op2) {
@@ -88,352 +325,584 @@ bool operandsEqual(LLVMValueRef op1, LLVMValueRef op2) {
     return false;
 }
 
-int subexprElimination(LLVMModuleRef module){
+int subexprEliminationInFunction(LLVMValueRef function){
 	bool changed = false;
+	MemorySSA* memory = NULL; // Loads of local variables are equal when they read the same version
 
-    // Walk through functions, basic blocks, and instructions
-    for (LLVMValueRef function =  LLVMGetFirstFunction(module); 
-			function; 
-			function = LLVMGetNextFunction(function)) {
-
-        if (DEBUGGING) {
-            const char* funcName = LLVMGetValueName(function);	
+    if (TRACING(TRACE_CHANGES)) {
+        const char* funcName = LLVMGetValueName(function);	
 
-            printf("Function Name: %s\n", funcName);
-        }
+        printf("Function Name: %s\n", funcName);
+    }
 
-		// Walk through basic blocks
-        for (LLVMBasicBlockRef basicBlock = LLVMGetFirstBasicBlock(function);
+	// Walk through basic blocks
+    for (LLVMBasicBlockRef basicBlock = LLVMGetFirstBasicBlock(function);
  			 basicBlock;
   			 basicBlock = LLVMGetNextBasicBlock(basicBlock)) {
 
-            // if (DEBUGGING) {
-            //     printf("In basic block\n");
-            // }
+        // if (TRACING(TRACE_CHANGES)) {
+        //     printf("In basic block\n");
+        // }
+		if (!needsVisit(basicBlock)) continue;
 
-            // Walk through instructions
-            for (LLVMValueRef inst = LLVMGetFirstInstruction(basicBlock); inst;
+        // Walk through instructions
+        for (LLVMValueRef inst = LLVMGetFirstInstruction(basicBlock); inst;
   					inst = LLVMGetNextInstruction(inst)) {
 
-				if (LLVMIsACmpInst(inst) || LLVMIsACallInst(inst) || LLVMIsAAllocaInst(inst)
-					|| LLVMIsATerminatorInst(inst) || LLVMIsAStoreInst(inst)) {
-					// Note all these instruction types have side effects or are control flow instructions, 
-					// so we cannot eliminate them.
-					// Note, cmp instructions are always followed by a branch instruction, so we cannot eliminate them either.
-					continue; // Skip comparisons, calls, allocas, and terminator instructions
-				}
+			if (LLVMIsACmpInst(inst) || LLVMIsACallInst(inst) || LLVMIsAAllocaInst(inst)
+				|| LLVMIsATerminatorInst(inst) || LLVMIsAStoreInst(inst)) {
+				// Note all these instruction types have side effects or are control flow instructions, 
+				// so we cannot eliminate them.
+				// Note, cmp instructions are always followed by a branch instruction, so we cannot eliminate them either.
+				continue; // Skip comparisons, calls, allocas, and terminator instructions
+			}
 
-				LLVMOpcode op = LLVMGetInstructionOpcode(inst);
+			LLVMOpcode op = LLVMGetInstructionOpcode(inst);
+			if (op == LLVMLoad && memory == NULL) memory = &cachedMemorySSA(function);
+			bool trackedLoad = op == LLVMLoad && memoryTracks(*memory, inst);
 
-				// Inner loop to check if will see the same instruction again later in the basic block
-				// O(n^2) :(
-				for (LLVMValueRef otherInst = LLVMGetNextInstruction(inst); otherInst;
+			// Inner loop to check if will see the same instruction again later in the basic block
+			// O(n^2) :(
+			for (LLVMValueRef otherInst = LLVMGetNextInstruction(inst); otherInst;
   					otherInst = LLVMGetNextInstruction(otherInst)) {
-					
-					// Check if the two instructions are the same (same opcode and same operands)
-					if (LLVMGetInstructionOpcode(otherInst) == op) {
-						// Check if operands are the same
-						unsigned numOperands = LLVMGetNumOperands(inst);
-						bool sameOperands = true;
-						if (numOperands != LLVMGetNumOperands(otherInst)) {
-							sameOperands = false;
-							continue; // Skip if different number of operands
-						} else {
+				
+				// Check if the two instructions are the same (same opcode and same operands)
+				if (LLVMGetInstructionOpcode(otherInst) == op) {
+					// Check if operands are the same
+					unsigned numOperands = LLVMGetNumOperands(inst);
+					bool sameOperands = true;
+					if (numOperands != LLVMGetNumOperands(otherInst)) {
+						sameOperands = false;
+						continue; // Skip if different number of operands
+					} else {
+						for (unsigned i = 0; i < numOperands; i++) {
+							LLVMValueRef thisOperand = LLVMGetOperand(inst, i);
+							LLVMValueRef otherOperand = LLVMGetOperand(otherInst, i);
+							if (!operandsEqual(thisOperand, otherOperand)) {
+								sameOperands = false;
+								break;
+							}
+						}
+
+						// Edge case: commutative operations (add, mul)
+						if (!sameOperands && (op == LLVMAdd || op == LLVMMul)) {
+							sameOperands = true;
 							for (unsigned i = 0; i < numOperands; i++) {
+								// Check if operands are the same in reverse order
 								LLVMValueRef thisOperand = LLVMGetOperand(inst, i);
-								LLVMValueRef otherOperand = LLVMGetOperand(otherInst, i);
+								LLVMValueRef otherOperand = LLVMGetOperand(otherInst, numOperands - 1 - i);
 								if (!operandsEqual(thisOperand, otherOperand)) {
 									sameOperands = false;
 									break;
 								}
 							}
-
-							// Edge case: commutative operations (add, mul)
-							if (!sameOperands && (op == LLVMAdd || op == LLVMMul)) {
-								sameOperands = true;
-								for (unsigned i = 0; i < numOperands; i++) {
-									// Check if operands are the same in reverse order
-									LLVMValueRef thisOperand = LLVMGetOperand(inst, i);
-									LLVMValueRef otherOperand = LLVMGetOperand(otherInst, numOperands - 1 - i);
-									if (!operandsEqual(thisOperand, otherOperand)) {
-										sameOperands = false;
-										break;
-									}
-								}
-							}
 						}
+					}
 
-						if (sameOperands) {
-							changed = true;
-							// Found a common subexpression
-							LLVMReplaceAllUsesWith(otherInst, inst);
-
-							if (DEBUGGING) {
-								printf("Found common subexpression:\n");
-								LLVMDumpValue(inst);
-								printf("\n Eliminating duplicate:\n");
-								LLVMDumpValue(otherInst);
-								printf("\n");
-								printf("New Basic Block after elimination:\n");
-								LLVMDumpValue(LLVMBasicBlockAsValue(basicBlock));
-							}
+					if (sameOperands && trackedLoad && !sameMemoryVersion(*memory, inst, otherInst)) {
+						sameOperands = false; // A store to the variable lies in between
+					}
+
+					if (sameOperands) {
+						changed = true;
+						// Found a common subexpression
+						markInstructionChanged(otherInst);
+						LLVMReplaceAllUsesWith(otherInst, inst);
+						countStatistic("subexpressions eliminated");
+
+						if (TRACING(TRACE_CHANGES)) {
+							printf("Found common subexpression:\n");
+							LLVMDumpValue(inst);
+							printf("\n Eliminating duplicate:\n");
+							LLVMDumpValue(otherInst);
+							printf("\n");
 						}
-					} else if (op == LLVMLoad && LLVMGetInstructionOpcode(otherInst) == LLVMStore) {
-						// All loads after a store to the same address cannot be eliminated
-						LLVMValueRef loadAddr = LLVMGetOperand(inst, 0);
-						LLVMValueRef storeAddr = LLVMGetOperand(otherInst, 1); // Store
-						if (operandsEqual(loadAddr, storeAddr)) {
-							// Cannot eliminate any following load after store to same address
-							break;
+						if (TRACING(TRACE_IR)) {
+							printf("New Basic Block after elimination:\n");
+							LLVMDumpValue(LLVMBasicBlockAsValue(basicBlock));
 						}
 					}
+				} else if (op == LLVMLoad && !trackedLoad && LLVMGetInstructionOpcode(otherInst) == LLVMStore) {
+					// All loads after a store to the same address cannot be eliminated
+					LLVMValueRef loadAddr = LLVMGetOperand(inst, 0);
+					LLVMValueRef storeAddr = LLVMGetOperand(otherInst, 1); // Store
+					if (operandsEqual(loadAddr, storeAddr)) {
+						// Cannot eliminate any following load after store to same address
+						break;
+					}
 				}
-            }
+			}
         }
- 	}
+    }
 
     if (changed) return 1; // Indicate that we made changes
 	else return 0; // No changes made
 }
 
-// ---- Dead code elimination ----
-
-int deadcodeElimination(LLVMModuleRef module) {
+int subexprElimination(LLVMModuleRef module){
 	bool changed = false;
 
-	// Walk through functions, basic blocks, and instructions
-	for (LLVMValueRef function =  LLVMGetFirstFunction(module); 
+    // Walk through functions, basic blocks, and instructions
+    for (LLVMValueRef function =  firstFunction(module); 
 			function; 
-			function = LLVMGetNextFunction(function)) {
+			function = nextFunction(function)) {
 
-		// Walk through basic blocks
-		for (LLVMBasicBlockRef basicBlock = LLVMGetFirstBasicBlock(function);
+		if (subexprEliminationInFunction(function)) changed = true;
+	}
+
+    if (changed) return 1; // Indicate that we made changes
+	else return 0; // No changes made
+}
+
+// ---- Dead code elimination ----
+
+int deadcodeEliminationInFunction(LLVMValueRef function) {
+	bool changed = false;
+
+	// Walk through basic blocks
+	for (LLVMBasicBlockRef basicBlock = LLVMGetFirstBasicBlock(function);
  			 basicBlock;
   			 basicBlock = LLVMGetNextBasicBlock(basicBlock)) {
 
-			list<LLVMValueRef> toDelete; // List of instructions to delete after iteration
+		if (!needsVisit(basicBlock)) continue;
+		list<LLVMValueRef> toDelete; // List of instructions to delete after iteration
 
-			// Walk through instructions
-			for (LLVMValueRef inst = LLVMGetFirstInstruction(basicBlock); inst;
+		// Walk through instructions
+		for (LLVMValueRef inst = LLVMGetFirstInstruction(basicBlock); inst;
   					inst = LLVMGetNextInstruction(inst)) {
 
-				// If the instruction has no uses and is not a terminator, store, call, or alloca, it is dead code
-				if (LLVMGetFirstUse(inst) == NULL && !LLVMIsATerminatorInst(inst) && !LLVMIsAStoreInst(inst) 
-						&& !LLVMIsACallInst(inst) && !LLVMIsAAllocaInst(inst)) {
-					
-					changed = true;
-					toDelete.push_back(inst); 
-					if (DEBUGGING) {
-						printf("Found dead code:\n");
-						LLVMDumpValue(inst);
-						printf("\n");
-					}
+			// If the instruction has no uses and is not a terminator, store, call, or alloca, it is dead code
+			if (LLVMGetFirstUse(inst) == NULL && !LLVMIsATerminatorInst(inst) && !LLVMIsAStoreInst(inst) 
+					&& !LLVMIsACallInst(inst) && !LLVMIsAAllocaInst(inst)) {
+				
+				changed = true;
+				toDelete.push_back(inst); 
+				countStatistic("instructions deleted");
+				if (TRACING(TRACE_CHANGES)) {
+					printf("Found dead code:\n");
+					LLVMDumpValue(inst);
+					printf("\n");
 				}
 			}
-			// Delete instructions
-			for (LLVMValueRef inst : toDelete) {
-				LLVMInstructionEraseFromParent(inst);
-			}
-			if (DEBUGGING && !toDelete.empty()) {
-				printf("New Basic Block after dead code elimination:\n");
-				LLVMDumpValue(LLVMBasicBlockAsValue(basicBlock));
-			}
 		}
- 	}
+		// Delete instructions; their operands may be dead now
+		for (LLVMValueRef inst : toDelete) {
+			markInstructionChanged(inst);
+			LLVMInstructionEraseFromParent(inst);
+		}
+		if (TRACING(TRACE_IR) && !toDelete.empty()) {
+			printf("New Basic Block after dead code elimination:\n");
+			LLVMDumpValue(LLVMBasicBlockAsValue(basicBlock));
+		}
+	}
 
 	if (changed) return 1; // Indicate that we made changes
 	else return 0; // No changes made
 }
 
-// ---- Constant folding ----
-
-int constantFolding(LLVMModuleRef module) {
+int deadcodeElimination(LLVMModuleRef module) {
 	bool changed = false;
 
-	for (LLVMValueRef function =  LLVMGetFirstFunction(module); 
+	// Walk through functions, basic blocks, and instructions
+	for (LLVMValueRef function =  firstFunction(module); 
 			function; 
-			function = LLVMGetNextFunction(function)) {
-
-		for (LLVMBasicBlockRef basicBlock = LLVMGetFirstBasicBlock(function);
- 			 basicBlock;
-  			 basicBlock = LLVMGetNextBasicBlock(basicBlock)) {
-
-			for (LLVMValueRef inst = LLVMGetFirstInstruction(basicBlock); inst;
-  					inst = LLVMGetNextInstruction(inst)) {
-
-				// check if the instruction involves only constants and is a binary operator
-				if (LLVMIsABinaryOperator(inst) && LLVMGetFirstUse(inst) != NULL) {
-					LLVMValueRef op1 = LLVMGetOperand(inst, 0);
-					LLVMValueRef op2 = LLVMGetOperand(inst, 1);
-
-					if (LLVMIsAConstantInt(op1) && LLVMIsAConstantInt(op2)) {
-						LLVMValueRef foldedConst = NULL;
-
-						LLVMOpcode opcode = LLVMGetInstructionOpcode(inst);
-
-						switch (opcode) {
-							case LLVMAdd:
-								foldedConst = LLVMConstAdd(op1, op2);
-								break;
-							case LLVMSub:
-								foldedConst = LLVMConstSub(op1, op2);
-								break;
-							case LLVMMul:
-								foldedConst = LLVMConstMul(op1, op2);
-								break;
-							default:
-								// Not a supported binary operator for folding
-								printf("Unsupported opcode for constant folding: %u\n", opcode);
-								break;
-						}
+			function = nextFunction(function)) {
 
-						if (foldedConst != NULL) {
-							LLVMReplaceAllUsesWith(inst, foldedConst);
-							changed = true;
-							if (DEBUGGING) {
-								printf("Folded constant expression:\n");
-								LLVMDumpValue(inst);
-								printf("\n into:\n");
-								LLVMDumpValue(foldedConst);
-								printf("\n");
-								printf("New Basic Block after constant folding:\n");
-								LLVMDumpValue(LLVMBasicBlockAsValue(basicBlock));
-							}
-						}
-					}
-				}		
-			}
-		}
- 	}
+		if (deadcodeEliminationInFunction(function)) changed = true;
+	}
 
 	if (changed) return 1; // Indicate that we made changes
 	else return 0; // No changes made
 }
 
-// ---- Global constant propagation ----
+// ---- Value range queries ----
 
-// Structure to hold all dataflow sets for a basic block
-struct BBDataflow {
-    unordered_set<LLVMValueRef> genSet;
-    unordered_set<LLVMValueRef> killSet;
-    unordered_set<LLVMValueRef> inSet;
-    unordered_set<LLVMValueRef> outSet;
+// Interface of the value range analysis (see "Value range analysis" below for how the ranges are computed),
+// consulted by constant folding and branch simplification.
+
+struct ValueRange {
+	long long lo; // signed bounds, inclusive
+	long long hi;
+	bool empty;   // no value at all: not reached (yet)
 };
 
-int constantPropagation(LLVMModuleRef module) {
-	bool changed = false;
+struct VariableRanges {
+	bool reached;                                 // false while no path is known to reach the program point
+	unordered_map<LLVMValueRef, ValueRange> vars; // local variable -> range; a variable not listed may hold anything
+};
 
-	for (LLVMValueRef function =  LLVMGetFirstFunction(module); 
-			function; 
-			function = LLVMGetNextFunction(function)) {
+struct RangeAnalysis {
+	unordered_set<LLVMValueRef> variables;                     // integer local variables that are tracked
+	unordered_map<LLVMValueRef, ValueRange> values;            // instruction results
+	unordered_map<LLVMBasicBlockRef, VariableRanges> blockIn;  // local variables on entry to each block
+	unordered_map<LLVMBasicBlockRef, VariableRanges> blockOut; // and at its branch, before the condition narrows them
+};
 
-		// set of all store instructions in the function
-		unordered_set<LLVMValueRef> allStores;
-		for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function);
-			bb;
-			bb = LLVMGetNextBasicBlock(bb)) {
-			
-			for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); 
-				inst;
-				inst = LLVMGetNextInstruction(inst)) {
-				
-				if (LLVMIsAStoreInst(inst)) {
-					allStores.insert(inst);
-				}
-			}
-		}
+RangeAnalysis computeRanges(LLVMValueRef function);
+ValueRange rangeOf(RangeAnalysis& ranges, LLVMValueRef value);
+LLVMValueRef foldComparison(RangeAnalysis& ranges, LLVMValueRef icmp);
+bool edgeFeasible(RangeAnalysis& ranges, LLVMBasicBlockRef pred, LLVMBasicBlockRef succ);
+VariableRanges edgeRanges(RangeAnalysis& ranges, LLVMBasicBlockRef pred, LLVMBasicBlockRef succ);
+ValueRange rangeThroughEdge(RangeAnalysis& ranges, LLVMBasicBlockRef pred, LLVMBasicBlockRef bb, VariableRanges state,
+	LLVMValueRef value);
 
-		unordered_map<LLVMBasicBlockRef, BBDataflow> bbDataflows; // map from basic block to its dataflow sets
+// ---- Constant folding ----
 
-		// Create GEN and KILL sets for each basic block
-		for (LLVMBasicBlockRef basicBlock = LLVMGetFirstBasicBlock(function);
+int constantFoldingInFunction(LLVMValueRef function) {
+	bool changed = false;
+	RangeAnalysis ranges; // computed on the first comparison
+	bool haveRanges = false;
+
+	for (LLVMBasicBlockRef basicBlock = LLVMGetFirstBasicBlock(function);
  			 basicBlock;
   			 basicBlock = LLVMGetNextBasicBlock(basicBlock)) {
 
-			BBDataflow& dataflow = bbDataflows[basicBlock];
-			
-			for (LLVMValueRef inst = LLVMGetFirstInstruction(basicBlock); inst;
+		for (LLVMValueRef inst = LLVMGetFirstInstruction(basicBlock); inst;
   					inst = LLVMGetNextInstruction(inst)) {
 
-				if (LLVMIsAStoreInst(inst)) {
-					LLVMValueRef storeAddr = LLVMGetOperand(inst, 1); // Store
+			// check if the instruction involves only constants and is a binary operator
+			if (LLVMIsABinaryOperator(inst) && LLVMGetFirstUse(inst) != NULL) {
+				LLVMValueRef op1 = LLVMGetOperand(inst, 0);
+				LLVMValueRef op2 = LLVMGetOperand(inst, 1);
 
-					// Check if this store kills any previous stores in the gen set, if so, remove them from gen set
-					for (auto it = dataflow.genSet.begin(); it != dataflow.genSet.end(); ) {
-						LLVMValueRef genStore = *it;
-						LLVMValueRef genStoreAddr = LLVMGetOperand(genStore, 1);
-						if (operandsEqual(storeAddr, genStoreAddr)) {
-							it = dataflow.genSet.erase(it);  // erase returns iterator to next element
-						} else {
-							++it;  // only increment if we didn't erase
+				if (LLVMIsAConstantInt(op1) && LLVMIsAConstantInt(op2)) {
+					LLVMValueRef foldedConst = NULL;
+
+					LLVMOpcode opcode = LLVMGetInstructionOpcode(inst);
+
+					switch (opcode) {
+						case LLVMAdd:
+							foldedConst = LLVMConstAdd(op1, op2);
+							break;
+						case LLVMSub:
+							foldedConst = LLVMConstSub(op1, op2);
+							break;
+						case LLVMMul:
+							foldedConst = LLVMConstMul(op1, op2);
+							break;
+						case LLVMSDiv: {
+							// Division by zero and MIN / -1 are undefined behavior, so they are left alone
+							unsigned width = LLVMGetIntTypeWidth(LLVMTypeOf(inst));
+							if (width > 64) break;
+							long long dividend = LLVMConstIntGetSExtValue(op1);
+							long long divisor = LLVMConstIntGetSExtValue(op2);
+							long long minValue = width == 64 ? LLONG_MIN : -(1LL << (width - 1));
+							if (divisor != 0 && !(divisor == -1 && dividend == minValue)) {
+								foldedConst = LLVMConstInt(LLVMTypeOf(inst), (unsigned long long)(dividend / divisor), 1);
+							}
+							break;
 						}
+						default:
+							// Not a supported binary operator for folding
+							if (TRACING(TRACE_CHANGES)) printf("Unsupported opcode for constant folding: %u\n", opcode);
+							break;
 					}
 
-					// Check if this store kills any previous stores to the same address
-					for (LLVMValueRef prevStore : allStores) {
-						LLVMValueRef prevStoreAddr = LLVMGetOperand(prevStore, 1);
-						if (prevStore != inst && operandsEqual(storeAddr, prevStoreAddr)) {
-							dataflow.killSet.insert(prevStore);
+					if (foldedConst != NULL) {
+						LLVMReplaceAllUsesWith(inst, foldedConst);
+						changed = true;
+						countStatistic("instructions folded");
+						if (TRACING(TRACE_CHANGES)) {
+							printf("Folded constant expression:\n");
+							LLVMDumpValue(inst);
+							printf("\n into:\n");
+							LLVMDumpValue(foldedConst);
+							printf("\n");
+						}
+						if (TRACING(TRACE_IR)) {
+							printf("New Basic Block after constant folding:\n");
+							LLVMDumpValue(LLVMBasicBlockAsValue(basicBlock));
 						}
 					}
+				}
+			} else if (LLVMIsAICmpInst(inst) && LLVMGetFirstUse(inst) != NULL) {
+				// Comparisons fold when the operand ranges decide them
+				if (!haveRanges) {
+					ranges = computeRanges(function);
+					haveRanges = true;
+				}
+				LLVMValueRef folded = foldComparison(ranges, inst);
+				if (folded != NULL) {
+					LLVMReplaceAllUsesWith(inst, folded);
+					changed = true;
+					countStatistic("instructions folded");
+					if (TRACING(TRACE_CHANGES)) {
+						printf("Folded comparison:\n");
+						LLVMDumpValue(inst);
+						printf("\n into:\n");
+						LLVMDumpValue(folded);
+						printf("\n");
+					}
+				}
+			} else if (LLVMIsASelectInst(inst) && LLVMGetFirstUse(inst) != NULL) {
+				// A select with a known condition or two equal arms is just one of its arms
+				LLVMValueRef cond = LLVMGetOperand(inst, 0);
+				LLVMValueRef trueValue = LLVMGetOperand(inst, 1);
+				LLVMValueRef falseValue = LLVMGetOperand(inst, 2);
+				LLVMValueRef folded = NULL;
+				if (operandsEqual(trueValue, falseValue)) folded = trueValue;
+				else if (LLVMIsAConstantInt(cond)) folded = LLVMConstIntGetZExtValue(cond) ? trueValue : falseValue;
 
-					dataflow.genSet.insert(inst);
+				if (folded != NULL) {
+					LLVMReplaceAllUsesWith(inst, folded);
+					changed = true;
+					countStatistic("instructions folded");
+					if (TRACING(TRACE_CHANGES)) {
+						printf("Folded select:\n");
+						LLVMDumpValue(inst);
+						printf("\n");
+					}
 				}
 			}
 		}
+	}
 
-		// Iteratively compute IN and OUT sets until convergence
-		bool setsChanged = true;
-		while (setsChanged) {
-			setsChanged = false;
+	if (changed) return 1; // Indicate that we made changes
+	else return 0; // No changes made
+}
 
-			for (LLVMBasicBlockRef basicBlock = LLVMGetFirstBasicBlock(function);
- 			 basicBlock;
-  			 basicBlock = LLVMGetNextBasicBlock(basicBlock)) {
+int constantFolding(LLVMModuleRef module) {
+	bool changed = false;
 
-				BBDataflow& dataflow = bbDataflows[basicBlock];
+	for (LLVMValueRef function =  firstFunction(module); 
+			function; 
+			function = nextFunction(function)) {
 
-				unordered_set<LLVMValueRef> oldOutSet = dataflow.outSet;
+		if (!needsVisit(function)) continue;
+		if (constantFoldingInFunction(function)) {
+			markFunctionChanged(function);
+			changed = true;
+		}
+	}
 
-				// OUT[B] = GEN[B] U (IN[B] - KILL[B])
-				unordered_set<LLVMValueRef> newOutSet = dataflow.genSet;
-				for (LLVMValueRef inStore : dataflow.inSet) {
-					if (dataflow.killSet.find(inStore) == dataflow.killSet.end()) {
-						newOutSet.insert(inStore);
-					}
-				}
-				dataflow.outSet = newOutSet;
+	if (changed) return 1; // Indicate that we made changes
+	else return 0; // No changes made
+}
 
-				if (dataflow.outSet != oldOutSet) {
-					setsChanged = true;
+// ---- Global constant propagation ----
 
-					// Push change to successors: IN[S] = U OUT[P] for all predecessors P of successor S
-					LLVMValueRef terminator = LLVMGetBasicBlockTerminator(basicBlock);
-					unsigned numSuccessors = LLVMGetNumSuccessors(terminator);
-					for (unsigned i = 0; i < numSuccessors; i++) {
-						LLVMBasicBlockRef succ = LLVMGetSuccessor(terminator, i);
+// Reaching stores and live loads are solved by the same worklist algorithm, and their solutions stay in the
+// analysis cache from one pass to the next. The facts are loads and stores, and whether a block generates or
+// kills one only depends on the accesses to the same variable. So when the loads and stores of some blocks
+// change, only the facts about the variables those accesses touch can change: they are withdrawn from every
+// IN and OUT set, the GEN and KILL sets of the blocks accessing those variables are recomputed, and only these
+// blocks are put on the worklist. A change that leaves the loads and stores alone costs just the walk over the
+// instructions that finds out.
 
-						BBDataflow& succDataflow = bbDataflows[succ];
-						succDataflow.inSet.insert(dataflow.outSet.begin(), dataflow.outSet.end()); // Union with STL magic
-					}
-				}
-			}
-		}
+// A load or store a dataflow solution was computed from
+struct MemoryAccess {
+	LLVMValueRef inst;
+	LLVMValueRef address;
+	bool isStore;
 
-		// Replace loads with constants
-		for (LLVMBasicBlockRef basicBlock = LLVMGetFirstBasicBlock(function);
- 			 basicBlock;
-  			 basicBlock = LLVMGetNextBasicBlock(basicBlock)) {
+	bool operator==(const MemoryAccess& other) const {
+		return inst == other.inst && address == other.address && isStore == other.isStore;
+	}
+};
 
-			BBDataflow& dataflow = bbDataflows[basicBlock];
-			unordered_set<LLVMValueRef> R = dataflow.inSet;
+struct DataflowSolution {
+	unordered_map<LLVMBasicBlockRef, BBDataflow> blocks;
+	unordered_map<LLVMBasicBlockRef, vector<MemoryAccess>> accesses; // the ones GEN and KILL were computed from
+};
 
-			list<LLVMValueRef> toDelete; // List of instructions to delete after iteration
+struct DataflowProblem {
+	bool forward;      // OUT[B] = GEN[B] U (IN[B] - KILL[B]), IN[B] = U OUT[P]; otherwise the other way round
+	bool factsAreLoads; // the facts are stores otherwise
+	void (*computeGenKill)(LLVMBasicBlockRef bb, AddressIndex& addresses, BBDataflow& dataflow);
+};
+
+void eraseFacts(unordered_set<LLVMValueRef>& set, const unordered_set<LLVMValueRef>& facts) {
+	for (auto it = set.begin(); it != set.end(); ) {
+		if (facts.count(*it)) it = set.erase(it);
+		else ++it;
+	}
+}
+
+// Brings solution up to date with the loads and stores of function; fresh solves it from scratch
+void updateDataflow(LLVMValueRef function, const DataflowProblem& problem, DataflowSolution& solution, bool fresh) {
+	// The accesses each block has now (loads only matter when they are the facts)
+	vector<LLVMBasicBlockRef> blocks;
+	unordered_map<LLVMBasicBlockRef, vector<MemoryAccess>> accesses;
+	for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+		blocks.push_back(bb);
+		vector<MemoryAccess>& blockAccesses = accesses[bb];
+		for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+			if (LLVMIsAStoreInst(inst)) blockAccesses.push_back({ inst, LLVMGetOperand(inst, 1), true });
+			else if (problem.factsAreLoads && LLVMIsALoadInst(inst)) {
+				blockAccesses.push_back({ inst, LLVMGetOperand(inst, 0), false });
+			}
+		}
+		if (!fresh && solution.accesses.count(bb) == 0) fresh = true; // The blocks are not the ones solved for
+	}
+	if (fresh || solution.accesses.size() != accesses.size()) {
+		fresh = true;
+		solution.blocks.clear();
+	}
+
+	// The variables whose accesses changed, and the facts about them
+	unordered_set<LLVMValueRef> affected;
+	if (!fresh) {
+		for (LLVMBasicBlockRef bb : blocks) {
+			vector<MemoryAccess>& old = solution.accesses[bb];
+			if (accesses[bb] == old) continue;
+			for (MemoryAccess& access : old) affected.insert(access.address);
+			for (MemoryAccess& access : accesses[bb]) affected.insert(access.address);
+		}
+		if (affected.empty()) return;
+
+		unordered_set<LLVMValueRef> withdrawn;
+		for (auto& entry : solution.accesses) {
+			for (MemoryAccess& access : entry.second) {
+				if (access.isStore != problem.factsAreLoads && affected.count(access.address)) withdrawn.insert(access.inst);
+			}
+		}
+		for (auto& entry : solution.blocks) {
+			eraseFacts(entry.second.inSet, withdrawn);
+			eraseFacts(entry.second.outSet, withdrawn);
+		}
+	}
+
+	// New GEN and KILL sets for the blocks that access those variables; they seed the worklist
+	AddressIndex& addresses = cachedAddresses(function);
+	vector<LLVMBasicBlockRef> worklist;
+	unordered_set<LLVMBasicBlockRef> queued;
+	for (LLVMBasicBlockRef bb : blocks) {
+		bool seed = fresh;
+		for (MemoryAccess& access : accesses[bb]) {
+			if (affected.count(access.address)) seed = true;
+		}
+		for (MemoryAccess& access : solution.accesses[bb]) {
+			if (affected.count(access.address)) seed = true;
+		}
+		if (!seed) continue;
+
+		BBDataflow& dataflow = solution.blocks[bb];
+		dataflow.genSet.clear();
+		dataflow.killSet.clear();
+		problem.computeGenKill(bb, addresses, dataflow);
+		worklist.push_back(bb);
+		queued.insert(bb);
+	}
+	solution.accesses.swap(accesses);
+	countStatistic("dataflow blocks seeded", worklist.size());
+
+	// The sets only grow from here, since the withdrawn facts are the only ones that can have gone
+	unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>>* preds = NULL;
+	if (!problem.forward) preds = &cachedPredecessors(function);
+	while (!worklist.empty()) {
+		LLVMBasicBlockRef bb = worklist.back();
+		worklist.pop_back();
+		queued.erase(bb);
+
+		BBDataflow& dataflow = solution.blocks[bb];
+		unordered_set<LLVMValueRef>& source = problem.forward ? dataflow.inSet : dataflow.outSet;
+		unordered_set<LLVMValueRef>& result = problem.forward ? dataflow.outSet : dataflow.inSet;
+		size_t oldSize = result.size();
+		result.insert(dataflow.genSet.begin(), dataflow.genSet.end());
+		for (LLVMValueRef fact : source) {
+			if (dataflow.killSet.find(fact) == dataflow.killSet.end()) result.insert(fact);
+		}
+		if (result.size() == oldSize) continue;
+
+		// Push the change to the neighbours the facts flow to
+		vector<LLVMBasicBlockRef> next;
+		if (problem.forward) {
+			LLVMValueRef terminator = LLVMGetBasicBlockTerminator(bb);
+			unsigned numSuccessors = LLVMGetNumSuccessors(terminator);
+			for (unsigned i = 0; i < numSuccessors; i++) next.push_back(LLVMGetSuccessor(terminator, i));
+		} else {
+			next = (*preds)[bb];
+		}
+		for (LLVMBasicBlockRef other : next) {
+			BBDataflow& otherDataflow = solution.blocks[other];
+			unordered_set<LLVMValueRef>& target = problem.forward ? otherDataflow.inSet : otherDataflow.outSet;
+			target.insert(result.begin(), result.end()); // Union with STL magic
+			if (queued.insert(other).second) worklist.push_back(other);
+		}
+	}
+}
+
+// Reaching stores of a function: the IN and OUT sets of each block hold the store instructions that may
+// have written the value a local variable has on entry to and on exit from the block
+void reachingStoresGenKill(LLVMBasicBlockRef basicBlock, AddressIndex& addresses, BBDataflow& dataflow) {
+	for (LLVMValueRef inst = LLVMGetFirstInstruction(basicBlock); inst;
+				inst = LLVMGetNextInstruction(inst)) {
+
+		if (LLVMIsAStoreInst(inst)) {
+			LLVMValueRef storeAddr = LLVMGetOperand(inst, 1); // Store
+
+			// Check if this store kills any previous stores in the gen set, if so, remove them from gen set
+			for (auto it = dataflow.genSet.begin(); it != dataflow.genSet.end(); ) {
+				LLVMValueRef genStore = *it;
+				LLVMValueRef genStoreAddr = LLVMGetOperand(genStore, 1);
+				if (operandsEqual(storeAddr, genStoreAddr)) {
+					it = dataflow.genSet.erase(it);  // erase returns iterator to next element
+				} else {
+					++it;  // only increment if we didn't erase
+				}
+			}
+
+			// This store kills all other stores to the same address
+			for (LLVMValueRef prevStore : addresses.stores[storeAddr]) {
+				if (prevStore != inst) dataflow.killSet.insert(prevStore);
+			}
+
+			dataflow.genSet.insert(inst);
+		}
+	}
+}
+
+const DataflowProblem reachingStoresProblem = { true, false, reachingStoresGenKill };
+
+// The constant that every store in stores to address writes, or NULL if one of them stores something else
+// (or none of them stores to address)
+LLVMValueRef reachingConstant(const unordered_set<LLVMValueRef>& stores, LLVMValueRef address) {
+	LLVMValueRef constant = NULL;
+	for (LLVMValueRef store : stores) {
+		if (!operandsEqual(address, LLVMGetOperand(store, 1))) continue;
+
+		LLVMValueRef value = LLVMGetOperand(store, 0);
+		if (!LLVMIsAConstantInt(value)) return NULL;
+		if (constant && !operandsEqual(value, constant)) return NULL;
+		constant = value;
+	}
+	return constant;
+}
+
+int constantPropagation(LLVMModuleRef module) {
+	bool changed = false;
+
+	for (LLVMValueRef function =  firstFunction(module); 
+			function; 
+			function = nextFunction(function)) {
+
+		if (!needsVisit(function)) continue;
+
+		// Loads of local variables follow their Memory SSA chains; the reaching stores are only needed for the rest
+		MemorySSA& memory = cachedMemorySSA(function);
+		bool untrackedLoads = false;
+		for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+			for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+				if (LLVMIsALoadInst(inst) && !memoryTracks(memory, inst)) untrackedLoads = true;
+			}
+		}
+		unordered_map<LLVMBasicBlockRef, BBDataflow>* bbDataflows = NULL;
+		if (untrackedLoads) bbDataflows = &cachedReachingStores(function);
+
+		// Replace loads with constants
+		for (LLVMBasicBlockRef basicBlock = LLVMGetFirstBasicBlock(function);
+ 			 basicBlock;
+  			 basicBlock = LLVMGetNextBasicBlock(basicBlock)) {
+
+			unordered_set<LLVMValueRef> R;
+			if (bbDataflows) R = (*bbDataflows)[basicBlock].inSet;
+
+			list<LLVMValueRef> toDelete; // List of instructions to delete after iteration
 
 			for (LLVMValueRef inst = LLVMGetFirstInstruction(basicBlock); inst;
   					inst = LLVMGetNextInstruction(inst)) {
 
-				if (LLVMIsAStoreInst(inst)) {
+				if (LLVMIsAStoreInst(inst) && bbDataflows) {
 					LLVMValueRef storeAddr = LLVMGetOperand(inst, 1); // Store
 
 					// Remove any store to the same address from R
@@ -452,52 +921,26 @@ int constantPropagation(LLVMModuleRef module) {
 				} else if (LLVMIsALoadInst(inst)) {
 					LLVMValueRef loadAddr = LLVMGetOperand(inst, 0); // Load
 
-					// Find all stores in R that store to the same address
-					vector<LLVMValueRef> matchingStores;
-					for (LLVMValueRef store : R) {
-						LLVMValueRef storeAddr = LLVMGetOperand(store, 1);
-						if (operandsEqual(loadAddr, storeAddr)) {
-							matchingStores.push_back(store);
-						}
+					// If all stores in R to the same address store the same constant, replace load with that constant
+					LLVMValueRef constant;
+					if (memoryTracks(memory, inst)) {
+						constant = storedValue(memory, inst);
+						if (constant && !LLVMIsAConstantInt(constant)) constant = NULL;
+					} else {
+						constant = reachingConstant(R, loadAddr);
 					}
-
-					if (matchingStores.size() > 0) {
-						// check that all stores are a constant
-						bool allConstant = true;
-						vector<LLVMValueRef> constValues;
-						for (LLVMValueRef store : matchingStores) {
-							LLVMValueRef value = LLVMGetOperand(store, 0);
-							if (LLVMIsAConstantInt(value)) {
-								constValues.push_back(value);
-							} else {
-								allConstant = false;
-								break;
-							}
-						}
-
-						// If all matching stores are constants and have the same value, replace load with that constant
-						if (allConstant) {
-							bool allSameValue = true;
-							LLVMValueRef firstValue = constValues[0]; // Guaranteed to exist since matchingStores is not empty
-							for (LLVMValueRef value : constValues) {
-								if (!operandsEqual(value, firstValue)) {
-									allSameValue = false;
-									break;
-								}
-							}
-
-							if (allSameValue) {
-								changed = true;
-								toDelete.push_back(inst); // Mark instruction for deletion
-								LLVMReplaceAllUsesWith(inst, firstValue);
-								if (DEBUGGING) {
-									printf("Propagated constant value:\n");
-									LLVMDumpValue(firstValue);
-									printf("\n into:\n");
-									LLVMDumpValue(inst);
-									printf("\n");
-								}
-							}
+					if (constant) {
+						changed = true;
+						markFunctionChanged(function);
+						toDelete.push_back(inst); // Mark instruction for deletion
+						LLVMReplaceAllUsesWith(inst, constant);
+						countStatistic("loads replaced");
+						if (TRACING(TRACE_CHANGES)) {
+							printf("Propagated constant value:\n");
+							LLVMDumpValue(constant);
+							printf("\n into:\n");
+							LLVMDumpValue(inst);
+							printf("\n");
 						}
 					}
 				}
@@ -507,7 +950,7 @@ int constantPropagation(LLVMModuleRef module) {
 			for (LLVMValueRef inst : toDelete) {
 				LLVMInstructionEraseFromParent(inst);
 			}
-			if (DEBUGGING && !toDelete.empty()) {
+			if (TRACING(TRACE_IR) && !toDelete.empty()) {
 				printf("New Basic Block after constant propagation:\n");
 				LLVMDumpValue(LLVMBasicBlockAsValue(basicBlock));
 			}
@@ -532,21 +975,18 @@ int constantPropagation(LLVMModuleRef module) {
 // 	If so, remove those loads from GEN set. Note that a store can only kill loads to the same address.
 
 // KILL set:
-// - Compute a global allLoads set for the entire function (can be done in the same iteration as GEN set computation)
+// - Look up the loads of the function by address in its address index (cached by the analysis manager)
 // - Iterate through instructions in the block in order
-// - For every store instruction "I", add all loads in allLoads that get killed by "I" (i.e. both refer to the same address)
+// - For every store instruction "I", add all loads from the address "I" stores to (they get killed by "I")
 
-// Iteratively compute IN and OUT sets until convergence:
+// Compute IN and OUT sets until convergence (updateDataflow under "Global constant propagation", which keeps
+// the solution cached and only redoes the variables whose loads or stores changed since):
 // - Initialize OUT[B] = empty, and IN[B] = GEN[B] for every block B
-// - change = true (until fixed-point reached)
-// - while (change):
-// 	- change = false
-// 	- for each block B:
-// 		- OUT[B] = U IN[S] for all successors S of B
-// 		- oldIn = IN[B]
-// 		- IN[B] = GEN[B] U (OUT[B] - KILL[B])
-// 		- if IN[B] != oldIn:
-// 			- change = true
+// - Whenever IN[B] grows, add it to OUT[P] for every predecessor P of B, and recompute
+// 	IN[P] = GEN[P] U (OUT[P] - KILL[P])
+
+// Stores to local variables that Memory SSA tracks are decided without the sets: such a store is dead when no
+// load reads the version it defines, directly or through memory phis.
 
 // After convergence, delete dead stores:
 // - For each block B:
@@ -560,121 +1000,65 @@ int constantPropagation(LLVMModuleRef module) {
 // 					Remove from L any load that gets killed by "I" (the store satisfies those loads, so they are no longer live after this store)
 // 	- Delete all instructions marked for deletion
 
+void liveLoadsGenKill(LLVMBasicBlockRef basicBlock, AddressIndex& addresses, BBDataflow& dataflow) {
+	// Walk through instructions in reverse order to compute GEN and KILL sets
+	for (LLVMValueRef inst = LLVMGetLastInstruction(basicBlock); inst;
+				inst = LLVMGetPreviousInstruction(inst)) {
 
-int liveVarAnalysis(LLVMModuleRef module) {
-	bool changed = false;
-
-	// Walk through functions, basic blocks, and instructions
-	for (LLVMValueRef function =  LLVMGetFirstFunction(module); 
-			function; 
-			function = LLVMGetNextFunction(function)) {
+		if (LLVMIsALoadInst(inst)) {
+			dataflow.genSet.insert(inst); // GEN set
+		} else if (LLVMIsAStoreInst(inst)) {
+			LLVMValueRef storeAddr = LLVMGetOperand(inst, 1); // Store
 
-		unordered_set<LLVMValueRef> allLoads; // set of all load instructions in the function
-		unordered_map<LLVMBasicBlockRef, unordered_set<LLVMBasicBlockRef>> succToPreds; // map from successor block to its predecessor blocks (for reverse traversal)
-		for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function);
-			bb;
-			bb = LLVMGetNextBasicBlock(bb)) {
-			
-			for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); 
-				inst;
-				inst = LLVMGetNextInstruction(inst)) {
-				
-				if (LLVMIsALoadInst(inst)) {
-					allLoads.insert(inst);
+			// Check if this store kills any previous loads in the gen set, if so, remove them from gen set
+			for (auto it = dataflow.genSet.begin(); it != dataflow.genSet.end(); ) {
+				LLVMValueRef genLoad = *it;
+				LLVMValueRef genLoadAddr = LLVMGetOperand(genLoad, 0);
+				if (operandsEqual(storeAddr, genLoadAddr)) {
+					it = dataflow.genSet.erase(it);  // erase returns iterator to next element
+				} else {
+					++it;  // only increment if we didn't erase
 				}
 			}
 
-			// Populate succToPreds map. Important 
-			LLVMValueRef terminator = LLVMGetBasicBlockTerminator(bb);
-			unsigned numSuccessors = LLVMGetNumSuccessors(terminator);
-			for (unsigned i = 0; i < numSuccessors; i++) {
-				LLVMBasicBlockRef succ = LLVMGetSuccessor(terminator, i);
-				succToPreds[succ].insert(bb);
-			}
-		}
-
-		unordered_map<LLVMBasicBlockRef, BBDataflow> bbDataflows; // map from basic block to its dataflow sets
-
-		// Compute GEN and KILL sets for each basic block
-		for (LLVMBasicBlockRef basicBlock = LLVMGetFirstBasicBlock(function);
- 			 basicBlock;
-  			 basicBlock = LLVMGetNextBasicBlock(basicBlock)) {
-			
-			BBDataflow& dataflow = bbDataflows[basicBlock];
-
-			// Walk through instructions in reverse order to compute GEN and KILL sets
-			for (LLVMValueRef inst = LLVMGetLastInstruction(basicBlock); inst;
-  					inst = LLVMGetPreviousInstruction(inst)) {
-
-				if (LLVMIsALoadInst(inst)) {
-					dataflow.genSet.insert(inst); // GEN set
-				} else if (LLVMIsAStoreInst(inst)) {
-					LLVMValueRef storeAddr = LLVMGetOperand(inst, 1); // Store
-
-					// Check if this store kills any previous loads in the gen set, if so, remove them from gen set
-					for (auto it = dataflow.genSet.begin(); it != dataflow.genSet.end(); ) {
-						LLVMValueRef genLoad = *it;
-						LLVMValueRef genLoadAddr = LLVMGetOperand(genLoad, 0);
-						if (operandsEqual(storeAddr, genLoadAddr)) {
-							it = dataflow.genSet.erase(it);  // erase returns iterator to next element
-						} else {
-							++it;  // only increment if we didn't erase
-						}
-					}
-
-					// Check if this store kills any loads to the same address
-					for (LLVMValueRef load : allLoads) {
-						LLVMValueRef loadAddr = LLVMGetOperand(load, 0);
-						if (operandsEqual(storeAddr, loadAddr)) {
-							dataflow.killSet.insert(load); // KILL set
-						}
-					}
-				}
+			// This store kills all loads from the same address
+			for (LLVMValueRef load : addresses.loads[storeAddr]) {
+				dataflow.killSet.insert(load); // KILL set
 			}
 		}
+	}
+}
 
-		// Iteratively compute IN and OUT sets until convergence
-		bool setsChanged = true;
-		while (setsChanged) {
-			setsChanged = false;
-
-			// Traverse basic block in any order
-			for (LLVMBasicBlockRef basicBlock = LLVMGetFirstBasicBlock(function);
- 			 basicBlock;
-  			 basicBlock = LLVMGetNextBasicBlock(basicBlock)) {
-
-				BBDataflow& dataflow = bbDataflows[basicBlock];
+const DataflowProblem liveLoadsProblem = { false, true, liveLoadsGenKill };
 
-				unordered_set<LLVMValueRef> oldInSet = dataflow.inSet;
+int liveVarAnalysis(LLVMModuleRef module) {
+	bool changed = false;
 
-				// IN[B] = GEN[B] U (OUT[B] - KILL[B])
-				unordered_set<LLVMValueRef> newInSet = dataflow.genSet;
-				for (LLVMValueRef outLoad : dataflow.outSet) {
-					if (dataflow.killSet.find(outLoad) == dataflow.killSet.end()) {
-						newInSet.insert(outLoad);
-					}
-				}
-				dataflow.inSet = newInSet;
+	// Walk through functions, basic blocks, and instructions
+	for (LLVMValueRef function =  firstFunction(module); 
+			function; 
+			function = nextFunction(function)) {
 
-				if (dataflow.inSet != oldInSet) {
-					setsChanged = true;
+		if (!needsVisit(function)) continue;
 
-					// Push change to predecessors: OUT[P] = U IN[S] for all successors S of predecessor P
-					for (LLVMBasicBlockRef pred : succToPreds[basicBlock]) {
-						BBDataflow& predDataflow = bbDataflows[pred];
-						predDataflow.outSet.insert(dataflow.inSet.begin(), dataflow.inSet.end()); // Union with STL magic
-					}
-				}
+		// Stores to local variables follow their Memory SSA chains; the live loads are only needed for the rest
+		MemorySSA& memory = cachedMemorySSA(function);
+		bool untrackedStores = false;
+		for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+			for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+				if (LLVMIsAStoreInst(inst) && !memoryTracks(memory, inst)) untrackedStores = true;
 			}
 		}
+		unordered_map<LLVMBasicBlockRef, BBDataflow>* bbDataflows = NULL;
+		if (untrackedStores) bbDataflows = &cachedLiveLoads(function);
 
 		// After convergence, delete dead stores
 		for (LLVMBasicBlockRef basicBlock = LLVMGetFirstBasicBlock(function);
 			 basicBlock;
 			 basicBlock = LLVMGetNextBasicBlock(basicBlock)) {
 			
-			BBDataflow& dataflow = bbDataflows[basicBlock];
-			unordered_set<LLVMValueRef> L = dataflow.outSet;
+			unordered_set<LLVMValueRef> L;
+			if (bbDataflows) L = (*bbDataflows)[basicBlock].outSet;
 
 			list<LLVMValueRef> toDelete; // List of instructions to delete after iteration
 
@@ -683,7 +1067,19 @@ int liveVarAnalysis(LLVMModuleRef module) {
 				inst = LLVMGetPreviousInstruction(inst)) {
 
 				if (LLVMIsALoadInst(inst)) {
-					L.insert(inst); // Add load to L
+					if (bbDataflows) L.insert(inst); // Add load to L
+				} else if (LLVMIsAStoreInst(inst) && memoryTracks(memory, inst)) {
+					if (storeIsDead(memory, inst)) {
+						changed = true;
+						markFunctionChanged(function);
+						toDelete.push_back(inst);
+						countStatistic("stores deleted");
+						if (TRACING(TRACE_CHANGES)) {
+							printf("Found dead store:\n");
+							LLVMDumpValue(inst);
+							printf("\n");
+						}
+					}
 				} else if (LLVMIsAStoreInst(inst)) {
 					LLVMValueRef storeAddr = LLVMGetOperand(inst, 1); // Store
 
@@ -699,8 +1095,10 @@ int liveVarAnalysis(LLVMModuleRef module) {
 
 					if (!hasMatchingLoad) {
 						changed = true;
+						markFunctionChanged(function);
 						toDelete.push_back(inst); // Mark store for deletion
-						if (DEBUGGING) {
+						countStatistic("stores deleted");
+						if (TRACING(TRACE_CHANGES)) {
 							printf("Found dead store:\n");
 							LLVMDumpValue(inst);
 							printf("\n");
@@ -724,7 +1122,7 @@ int liveVarAnalysis(LLVMModuleRef module) {
 			for (LLVMValueRef inst : toDelete) {
 				LLVMInstructionEraseFromParent(inst);
 			}
-			if (DEBUGGING && !toDelete.empty()) {
+			if (TRACING(TRACE_IR) && !toDelete.empty()) {
 				printf("New Basic Block after live variable analysis:\n");
 				LLVMDumpValue(LLVMBasicBlockAsValue(basicBlock));
 			}
@@ -736,57 +1134,5708 @@ int liveVarAnalysis(LLVMModuleRef module) {
 }
 		
 
-int main(int argc, char** argv)
-{
-	LLVMModuleRef m;
+// ---- Division by constant ----
+
+// A signed division by a constant becomes a multiplication by a fixed-point reciprocal ("magic number") and
+// shifts, so no hardware divide is left (Hacker's Delight, chapter 10). For q = x / d on 32 bits:
+// - d = 1: q = x, d = -1: q = -x, d = INT_MIN: q = (x == INT_MIN)
+// - |d| = 2^k: q = (x + ((x >> (k-1)) >>> (32-k))) >> k, negated when d < 0. The added bias is 2^k - 1 for
+//   negative x, which makes the shift round toward zero like sdiv (for k = 1, x >>> 31 alone is the bias).
+// - otherwise: q = mulhs(M, x), plus x when d > 0 and M < 0, minus x when d < 0 and M > 0, then q = q >> s and
+//   q = q + (q >>> 31). mulhs (the high half of the 64-bit product) is emitted as sext/mul/ashr/trunc, which the
+//   backend selects as a single multiply.
+
+struct SDivMagic {
+	int32_t multiplier;
+	int shift;
+};
+
+// Magic multiplier and shift for a divisor with |d| >= 2 (Hacker's Delight, figure 10-1)
+SDivMagic signedDivisionMagic(int32_t d) {
+	const uint32_t two31 = 0x80000000u;
+	uint32_t ad = d < 0 ? 0u - (uint32_t)d : (uint32_t)d;
+	uint32_t t = two31 + ((uint32_t)d >> 31);
+	uint32_t anc = t - 1 - t % ad;                    // |nc|, the largest dividend with the worst remainder
+	int p = 31;
+	uint32_t q1 = two31 / anc, r1 = two31 - q1 * anc; // 2^p / |nc| and its remainder
+	uint32_t q2 = two31 / ad, r2 = two31 - q2 * ad;   // 2^p / |d| and its remainder
+	uint32_t delta;
+	do {
+		p++;
+		q1 = 2 * q1;
+		r1 = 2 * r1;
+		if (r1 >= anc) {
+			q1++;
+			r1 -= anc;
+		}
+		q2 = 2 * q2;
+		r2 = 2 * r2;
+		if (r2 >= ad) {
+			q2++;
+			r2 -= ad;
+		}
+		delta = ad - r2;
+	} while (q1 < delta || (q1 == delta && r1 == 0));
+
+	SDivMagic magic;
+	magic.multiplier = (int32_t)(d < 0 ? 0u - (q2 + 1) : q2 + 1);
+	magic.shift = p - 32;
+	return magic;
+}
 
-	if (argc == 2){
-		m = createLLVMModel(argv[1]);
+// Emits x / d for an i32 x and a non-zero constant d at the builder position
+LLVMValueRef buildSDivByConstant(LLVMBuilderRef builder, LLVMValueRef x, int32_t d) {
+	LLVMTypeRef i32 = LLVMTypeOf(x);
+
+	if (d == 1) return x;
+	if (d == -1) return LLVMBuildNeg(builder, x, "");
+	if (d == INT32_MIN) {
+		LLVMValueRef isMin = LLVMBuildICmp(builder, LLVMIntEQ, x, LLVMConstInt(i32, (uint32_t)INT32_MIN, 0), "");
+		return LLVMBuildZExt(builder, isMin, i32, "");
 	}
-	else{
-		m = NULL;
-		return 1;
+
+	uint32_t ad = d < 0 ? 0u - (uint32_t)d : (uint32_t)d;
+	if ((ad & (ad - 1)) == 0) {
+		int k = 0;
+		while ((1u << k) != ad) k++;
+
+		LLVMValueRef sign = k == 1 ? x : LLVMBuildAShr(builder, x, LLVMConstInt(i32, k - 1, 0), "");
+		LLVMValueRef bias = LLVMBuildLShr(builder, sign, LLVMConstInt(i32, 32 - k, 0), "");
+		LLVMValueRef q = LLVMBuildAShr(builder, LLVMBuildAdd(builder, x, bias, ""), LLVMConstInt(i32, k, 0), "");
+		return d < 0 ? LLVMBuildNeg(builder, q, "") : q;
 	}
 
-	if (m != NULL){
-		// Loop until no more changes
-		int changed = 1;
-		while (changed) {
-			changed = 0;
-			printf("Starting optimization iteration...\n");
-			int subexprChanged = subexprElimination(m);
-			printf("Subexpression elimination made changes: %s\n", subexprChanged ? "Yes" : "No");
-			int deadcodeChanged = deadcodeElimination(m);
-			printf("Dead code elimination made changes: %s\n", deadcodeChanged ? "Yes" : "No");
-			int constantFoldingChanged = 1;
-			int constantPropagationChanged = 1;
-			while (constantFoldingChanged || constantPropagationChanged) {
-				constantFoldingChanged = constantFolding(m);
-				printf("Constant folding made changes: %s\n", constantFoldingChanged ? "Yes" : "No");
-				constantPropagationChanged = constantPropagation(m);
-				printf("Constant propagation made changes: %s\n", constantPropagationChanged ? "Yes" : "No");
-				if (constantFoldingChanged || constantPropagationChanged) {
-					changed = 1; // If either made changes, we need to check again for more opportunities
-				}
-			}
-			changed = changed || subexprChanged || deadcodeChanged;
-		}
-		int liveVarAnalysisChanged = liveVarAnalysis(m);
-		printf("Live variable analysis made changes: %s\n", liveVarAnalysisChanged ? "Yes" : "No");
-
-		LLVMDumpModule(m);
-
-		// Build output filename: strip .ll extension, append _optimized.ll
-		string inputName(argv[1]);
-		string outputName;
-		size_t extPos = inputName.rfind(".ll");
-		if (extPos != string::npos) {
-			outputName = inputName.substr(0, extPos) + "_optimized.ll";
-		} else {
-			outputName = inputName + "_optimized.ll";
+	SDivMagic magic = signedDivisionMagic(d);
+	LLVMTypeRef i64 = LLVMInt64TypeInContext(LLVMGetTypeContext(i32));
+
+	LLVMValueRef product = LLVMBuildMul(builder, LLVMBuildSExt(builder, x, i64, ""),
+		LLVMConstInt(i64, (unsigned long long)(long long)magic.multiplier, 1), "");
+	LLVMValueRef q = LLVMBuildTrunc(builder, LLVMBuildAShr(builder, product, LLVMConstInt(i64, 32, 0), ""), i32, "");
+	if (d > 0 && magic.multiplier < 0) q = LLVMBuildAdd(builder, q, x, "");
+	if (d < 0 && magic.multiplier > 0) q = LLVMBuildSub(builder, q, x, "");
+	if (magic.shift > 0) q = LLVMBuildAShr(builder, q, LLVMConstInt(i32, magic.shift, 0), "");
+	return LLVMBuildAdd(builder, q, LLVMBuildLShr(builder, q, LLVMConstInt(i32, 31, 0), ""), "");
+}
+
+int sdivStrengthReduction(LLVMModuleRef module) {
+	bool changed = false;
+	LLVMBuilderRef builder = LLVMCreateBuilderInContext(LLVMGetModuleContext(module));
+
+	for (LLVMValueRef function =  firstFunction(module); 
+			function; 
+			function = nextFunction(function)) {
+
+		for (LLVMBasicBlockRef basicBlock = LLVMGetFirstBasicBlock(function);
+ 			 basicBlock;
+  			 basicBlock = LLVMGetNextBasicBlock(basicBlock)) {
+
+			if (!needsVisit(basicBlock)) continue;
+			list<LLVMValueRef> toDelete; // List of instructions to delete after iteration
+
+			for (LLVMValueRef inst = LLVMGetFirstInstruction(basicBlock); inst;
+  					inst = LLVMGetNextInstruction(inst)) {
+
+				if (LLVMGetInstructionOpcode(inst) != LLVMSDiv || LLVMGetIntTypeWidth(LLVMTypeOf(inst)) != 32) continue;
+
+				LLVMValueRef divisor = LLVMGetOperand(inst, 1);
+				if (!LLVMIsAConstantInt(divisor) || LLVMConstIntGetSExtValue(divisor) == 0) continue;
+
+				LLVMPositionBuilderBefore(builder, inst);
+				LLVMValueRef quotient = buildSDivByConstant(builder, LLVMGetOperand(inst, 0),
+					(int32_t)LLVMConstIntGetSExtValue(divisor));
+				markInstructionChanged(inst);
+				LLVMReplaceAllUsesWith(inst, quotient);
+				toDelete.push_back(inst);
+				countStatistic("divisions replaced");
+				changed = true;
+
+				if (TRACING(TRACE_CHANGES)) {
+					printf("Replaced division by constant:\n");
+					LLVMDumpValue(inst);
+					printf("\n with:\n");
+					LLVMDumpValue(quotient);
+					printf("\n");
+				}
+			}
+
+			// Delete instructions
+			for (LLVMValueRef inst : toDelete) {
+				LLVMInstructionEraseFromParent(inst);
+			}
 		}
-		LLVMPrintModuleToFile(m, outputName.c_str(), NULL);
-    }
+	}
+
+	LLVMDisposeBuilder(builder);
+
+	if (changed) return 1; // Indicate that we made changes
+	else return 0; // No changes made
+}
+
+// ---- CFG utilities ----
+
+LLVMContextRef blockContext(LLVMBasicBlockRef bb) {
+	return LLVMGetModuleContext(LLVMGetGlobalParent(LLVMGetBasicBlockParent(bb)));
+}
+
+string valueName(LLVMValueRef value) {
+	size_t nameLen;
+	const char* name = LLVMGetValueName2(value, &nameLen);
+	return string(name, nameLen);
+}
+
+// The names of the parameters, blocks and instructions of function
+unordered_set<string> localNames(LLVMValueRef function) {
+	unordered_set<string> names;
+	unsigned numParams = LLVMCountParams(function);
+	for (unsigned i = 0; i < numParams; i++) names.insert(valueName(LLVMGetParam(function, i)));
+	for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+		names.insert(valueName(LLVMBasicBlockAsValue(bb)));
+		for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+			names.insert(valueName(inst));
+		}
+	}
+	return names;
+}
+
+// A name for a copy of value that is not among taken (the names of the function the copy goes into), which it
+// joins. LLVM numbers a clashing name itself, but its count starts over when a function is read from bitcode,
+// so a parallel shard would name the copies differently from a serial run.
+string copyName(LLVMValueRef value, unordered_set<string>& taken) {
+	string name = valueName(value);
+	if (name.empty()) return name;
+	string fresh = name;
+	for (int n = 1; taken.count(fresh); n++) fresh = name + to_string(n);
+	taken.insert(fresh);
+	return fresh;
+}
+
+// Distinct successors of a block, in terminator order
+vector<LLVMBasicBlockRef> getSuccessors(LLVMBasicBlockRef bb) {
+	vector<LLVMBasicBlockRef> succs;
+	LLVMValueRef terminator = LLVMGetBasicBlockTerminator(bb);
+	if (terminator == NULL) return succs;
+
+	unsigned numSuccessors = LLVMGetNumSuccessors(terminator);
+	for (unsigned i = 0; i < numSuccessors; i++) {
+		LLVMBasicBlockRef succ = LLVMGetSuccessor(terminator, i);
+		if (find(succs.begin(), succs.end(), succ) == succs.end()) {
+			succs.push_back(succ);
+		}
+	}
+	return succs;
+}
+
+// Map from every basic block of the function to its distinct predecessors (every block gets an entry)
+unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>> computePredecessors(LLVMValueRef function) {
+	unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>> preds;
+	for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function);
+		bb;
+		bb = LLVMGetNextBasicBlock(bb)) {
+
+		preds[bb];
+		for (LLVMBasicBlockRef succ : getSuccessors(bb)) {
+			preds[succ].push_back(bb);
+		}
+	}
+	return preds;
+}
+
+// Moves an instruction (keeping its name) to the builder position
+void moveInstruction(LLVMBuilderRef builder, LLVMValueRef inst) {
+	string name = valueName(inst);
+	LLVMInstructionRemoveFromParent(inst);
+	LLVMInsertIntoBuilderWithName(builder, inst, name.c_str());
+}
+
+LLVMValueRef firstNonPhi(LLVMBasicBlockRef bb) {
+	LLVMValueRef inst = LLVMGetFirstInstruction(bb);
+	while (inst && LLVMIsAPHINode(inst)) {
+		inst = LLVMGetNextInstruction(inst);
+	}
+	return inst;
+}
+
+// An alloca whose address is only used directly as the pointer of loads and stores.
+// Nothing but those loads and stores can read or write it (calls included).
+bool isLocalVariable(LLVMValueRef alloca) {
+	if (!LLVMIsAAllocaInst(alloca)) return false;
+
+	for (LLVMUseRef use = LLVMGetFirstUse(alloca); use; use = LLVMGetNextUse(use)) {
+		LLVMValueRef user = LLVMGetUser(use);
+		if (LLVMIsALoadInst(user)) continue;
+		if (LLVMIsAStoreInst(user) && LLVMGetOperand(user, 1) == alloca && LLVMGetOperand(user, 0) != alloca) continue;
+		return false;
+	}
+	return true;
+}
 
-	return 0;
-}
\ No newline at end of file
+// The C API cannot change the incoming block of a phi in place, so every phi of bb that has
+// oldPred as an incoming block is rebuilt with newPred in its place.
+void replacePhiIncomingBlock(LLVMBasicBlockRef bb, LLVMBasicBlockRef oldPred, LLVMBasicBlockRef newPred) {
+	LLVMBuilderRef builder = LLVMCreateBuilderInContext(blockContext(bb));
+
+	LLVMValueRef phi = LLVMGetFirstInstruction(bb);
+	while (phi && LLVMIsAPHINode(phi)) {
+		LLVMValueRef next = LLVMGetNextInstruction(phi);
+
+		unsigned numIncoming = LLVMCountIncoming(phi);
+		bool usesOldPred = false;
+		for (unsigned i = 0; i < numIncoming; i++) {
+			if (LLVMGetIncomingBlock(phi, i) == oldPred) {
+				usesOldPred = true;
+				break;
+			}
+		}
+
+		if (usesOldPred) {
+			LLVMPositionBuilderBefore(builder, phi);
+			LLVMValueRef newPhi = LLVMBuildPhi(builder, LLVMTypeOf(phi), "");
+			bool addedNewPred = false;
+			for (unsigned i = 0; i < numIncoming; i++) {
+				LLVMValueRef value = LLVMGetIncomingValue(phi, i);
+				LLVMBasicBlockRef block = LLVMGetIncomingBlock(phi, i);
+				if (block == oldPred) block = newPred;
+				if (block == newPred) {
+					// A conditional branch with both arms to bb has two entries for one edge
+					if (addedNewPred) continue;
+					addedNewPred = true;
+				}
+				LLVMAddIncoming(newPhi, &value, &block, 1);
+			}
+
+			string name = valueName(phi);
+			LLVMReplaceAllUsesWith(phi, newPhi);
+			LLVMInstructionEraseFromParent(phi);
+			LLVMSetValueName2(newPhi, name.c_str(), name.size());
+		}
+		phi = next;
+	}
+
+	LLVMDisposeBuilder(builder);
+}
+
+// Drops the phi entries of bb for the edge from pred, which is going away
+void removePhiIncomingBlock(LLVMBasicBlockRef bb, LLVMBasicBlockRef pred) {
+	LLVMBuilderRef builder = LLVMCreateBuilderInContext(blockContext(bb));
+
+	LLVMValueRef phi = LLVMGetFirstInstruction(bb);
+	while (phi && LLVMIsAPHINode(phi)) {
+		LLVMValueRef next = LLVMGetNextInstruction(phi);
+
+		LLVMPositionBuilderBefore(builder, phi);
+		LLVMValueRef newPhi = LLVMBuildPhi(builder, LLVMTypeOf(phi), "");
+		unsigned numIncoming = LLVMCountIncoming(phi);
+		for (unsigned i = 0; i < numIncoming; i++) {
+			LLVMValueRef value = LLVMGetIncomingValue(phi, i);
+			LLVMBasicBlockRef block = LLVMGetIncomingBlock(phi, i);
+			if (block != pred) LLVMAddIncoming(newPhi, &value, &block, 1);
+		}
+
+		string name = valueName(phi);
+		LLVMReplaceAllUsesWith(phi, newPhi);
+		LLVMInstructionEraseFromParent(phi);
+		LLVMSetValueName2(newPhi, name.c_str(), name.size());
+		phi = next;
+	}
+
+	LLVMDisposeBuilder(builder);
+}
+
+// Places a new block on the edge pred -> succ and returns it
+LLVMBasicBlockRef splitEdge(LLVMBasicBlockRef pred, LLVMBasicBlockRef succ) {
+	invalidateAnalyses(LLVMGetBasicBlockParent(succ));
+	markFunctionChanged(LLVMGetBasicBlockParent(succ));
+	LLVMBasicBlockRef mid = LLVMInsertBasicBlockInContext(blockContext(succ), succ, "");
+
+	LLVMBuilderRef builder = LLVMCreateBuilderInContext(blockContext(succ));
+	LLVMPositionBuilderAtEnd(builder, mid);
+	LLVMBuildBr(builder, succ);
+	LLVMDisposeBuilder(builder);
+
+	LLVMValueRef terminator = LLVMGetBasicBlockTerminator(pred);
+	unsigned numSuccessors = LLVMGetNumSuccessors(terminator);
+	for (unsigned i = 0; i < numSuccessors; i++) {
+		if (LLVMGetSuccessor(terminator, i) == succ) {
+			LLVMSetSuccessor(terminator, i, mid);
+		}
+	}
+	replacePhiIncomingBlock(succ, pred, mid);
+
+	return mid;
+}
+
+LLVMValueRef mapValue(unordered_map<LLVMValueRef, LLVMValueRef>& valueMap, LLVMValueRef value) {
+	auto it = valueMap.find(value);
+	return it == valueMap.end() ? value : it->second;
+}
+
+// Copies blocks (in order) into function, before insertBefore. valueMap holds the replacements for values
+// defined outside the copied blocks (e.g. parameters); on return it also maps every copied block and
+// instruction to its copy. Operands without a mapping are kept, so the copies may refer to values outside
+// the region. Returns the copies in order.
+vector<LLVMBasicBlockRef> copyBlocks(vector<LLVMBasicBlockRef>& blocks, LLVMValueRef function,
+		LLVMBasicBlockRef insertBefore, unordered_map<LLVMValueRef, LLVMValueRef>& valueMap) {
+	LLVMContextRef context = LLVMGetModuleContext(LLVMGetGlobalParent(function));
+	LLVMBuilderRef builder = LLVMCreateBuilderInContext(context);
+	invalidateAnalyses(function);
+	markFunctionChanged(function);
+
+	vector<LLVMBasicBlockRef> copies;
+	for (LLVMBasicBlockRef bb : blocks) {
+		LLVMBasicBlockRef copy = insertBefore ? LLVMInsertBasicBlockInContext(context, insertBefore, "")
+			: LLVMAppendBasicBlockInContext(context, function, "");
+		valueMap[LLVMBasicBlockAsValue(bb)] = LLVMBasicBlockAsValue(copy);
+		copies.push_back(copy);
+	}
+
+	// Copy the instructions, then remap their operands once every copy exists
+	vector<LLVMValueRef> clones;
+	vector<LLVMValueRef> phis;
+	unordered_set<string> names = localNames(function);
+	for (size_t b = 0; b < blocks.size(); b++) {
+		LLVMPositionBuilderAtEnd(builder, copies[b]);
+		for (LLVMValueRef inst = LLVMGetFirstInstruction(blocks[b]); inst; inst = LLVMGetNextInstruction(inst)) {
+			string name = copyName(inst, names);
+
+			if (LLVMIsAPHINode(inst)) {
+				// Incoming blocks are not operands, so phis are rebuilt instead of cloned
+				valueMap[inst] = LLVMBuildPhi(builder, LLVMTypeOf(inst), name.c_str());
+				phis.push_back(inst);
+			} else {
+				LLVMValueRef clone = LLVMInstructionClone(inst);
+				LLVMInsertIntoBuilderWithName(builder, clone, name.c_str());
+				valueMap[inst] = clone;
+				clones.push_back(clone);
+			}
+		}
+	}
+
+	for (LLVMValueRef clone : clones) {
+		int numOperands = LLVMGetNumOperands(clone);
+		for (int i = 0; i < numOperands; i++) {
+			LLVMValueRef operand = LLVMGetOperand(clone, i);
+			LLVMValueRef mapped = mapValue(valueMap, operand);
+			if (mapped != operand) {
+				LLVMSetOperand(clone, i, mapped);
+			}
+		}
+	}
+	for (LLVMValueRef phi : phis) {
+		unsigned numIncoming = LLVMCountIncoming(phi);
+		for (unsigned i = 0; i < numIncoming; i++) {
+			LLVMValueRef value = mapValue(valueMap, LLVMGetIncomingValue(phi, i));
+			LLVMBasicBlockRef block = LLVMValueAsBasicBlock(mapValue(valueMap, LLVMBasicBlockAsValue(LLVMGetIncomingBlock(phi, i))));
+			LLVMAddIncoming(valueMap[phi], &value, &block, 1);
+		}
+	}
+
+	LLVMDisposeBuilder(builder);
+	return copies;
+}
+
+// Whether bb's results are only used inside bb or by phis of its successors, so a copy needs no new phis
+bool blockValuesStayInside(LLVMBasicBlockRef bb) {
+	for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+		for (LLVMUseRef use = LLVMGetFirstUse(inst); use; use = LLVMGetNextUse(use)) {
+			LLVMValueRef user = LLVMGetUser(use);
+			if (LLVMGetInstructionParent(user) == bb) {
+				// A phi reading a phi of the same block would see the copy's value too early
+				if (LLVMIsAPHINode(user) && LLVMIsAPHINode(inst)) return false;
+				continue;
+			}
+			if (!LLVMIsAPHINode(user)) return false;
+			unsigned numIncoming = LLVMCountIncoming(user);
+			for (unsigned i = 0; i < numIncoming; i++) {
+				if (LLVMGetIncomingValue(user, i) == inst && LLVMGetIncomingBlock(user, i) != bb) return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Redirects the edge pred -> bb to a copy of bb of its own and returns the copy. The copy branches where bb
+// does; its phis become the values coming from pred. bb must satisfy blockValuesStayInside (its successors'
+// phis get entries for the copy).
+LLVMBasicBlockRef copyBlockForPredecessor(LLVMBasicBlockRef pred, LLVMBasicBlockRef bb) {
+	unordered_map<LLVMValueRef, LLVMValueRef> valueMap;
+	vector<LLVMBasicBlockRef> blocks(1, bb);
+	LLVMBasicBlockRef copy = copyBlocks(blocks, LLVMGetBasicBlockParent(bb), LLVMGetNextBasicBlock(bb), valueMap)[0];
+
+	for (LLVMValueRef phi = LLVMGetFirstInstruction(bb); phi && LLVMIsAPHINode(phi); phi = LLVMGetNextInstruction(phi)) {
+		LLVMValueRef copied = valueMap[phi];
+		unsigned numIncoming = LLVMCountIncoming(phi);
+		for (unsigned i = 0; i < numIncoming; i++) {
+			if (LLVMGetIncomingBlock(phi, i) == pred) {
+				LLVMReplaceAllUsesWith(copied, LLVMGetIncomingValue(phi, i));
+				break;
+			}
+		}
+		LLVMInstructionEraseFromParent(copied);
+		valueMap.erase(phi);
+	}
+
+	for (LLVMBasicBlockRef succ : getSuccessors(bb)) {
+		for (LLVMValueRef phi = LLVMGetFirstInstruction(succ); phi && LLVMIsAPHINode(phi); phi = LLVMGetNextInstruction(phi)) {
+			unsigned numIncoming = LLVMCountIncoming(phi);
+			for (unsigned i = 0; i < numIncoming; i++) {
+				if (LLVMGetIncomingBlock(phi, i) != bb) continue;
+				LLVMValueRef value = mapValue(valueMap, LLVMGetIncomingValue(phi, i));
+				LLVMAddIncoming(phi, &value, &copy, 1);
+				break;
+			}
+		}
+	}
+
+	LLVMValueRef predTerminator = LLVMGetBasicBlockTerminator(pred);
+	unsigned numSuccessors = LLVMGetNumSuccessors(predTerminator);
+	for (unsigned i = 0; i < numSuccessors; i++) {
+		if (LLVMGetSuccessor(predTerminator, i) == bb) LLVMSetSuccessor(predTerminator, i, copy);
+	}
+	removePhiIncomingBlock(bb, pred);
+	return copy;
+}
+
+// Folds bb into its predecessor when they form a straight line: the predecessor branches only to bb
+// and bb has no other predecessor. Returns whether the blocks were merged.
+bool mergeIntoPredecessor(LLVMBasicBlockRef bb) {
+	LLVMValueRef function = LLVMGetBasicBlockParent(bb);
+	LLVMBasicBlockRef pred = NULL;
+	for (LLVMBasicBlockRef other = LLVMGetFirstBasicBlock(function); other; other = LLVMGetNextBasicBlock(other)) {
+		vector<LLVMBasicBlockRef> succs = getSuccessors(other);
+		if (find(succs.begin(), succs.end(), bb) == succs.end()) continue;
+		if (pred != NULL || succs.size() != 1) return false;
+		pred = other;
+	}
+	LLVMValueRef predTerminator = pred ? LLVMGetBasicBlockTerminator(pred) : NULL;
+	if (pred == NULL || pred == bb || LLVMGetNumSuccessors(predTerminator) != 1) return false;
+
+	invalidateAnalyses(function);
+	markFunctionChanged(function);
+
+	// Phis of a block with a single predecessor have a single incoming value
+	LLVMValueRef inst = LLVMGetFirstInstruction(bb);
+	while (inst && LLVMIsAPHINode(inst)) {
+		LLVMValueRef next = LLVMGetNextInstruction(inst);
+		LLVMReplaceAllUsesWith(inst, LLVMGetIncomingValue(inst, 0));
+		LLVMInstructionEraseFromParent(inst);
+		inst = next;
+	}
+
+	LLVMInstructionEraseFromParent(predTerminator);
+	LLVMBuilderRef builder = LLVMCreateBuilderInContext(blockContext(bb));
+	LLVMPositionBuilderAtEnd(builder, pred);
+	while (inst) {
+		LLVMValueRef next = LLVMGetNextInstruction(inst);
+		moveInstruction(builder, inst);
+		inst = next;
+	}
+	LLVMDisposeBuilder(builder);
+
+	for (LLVMBasicBlockRef succ : getSuccessors(pred)) {
+		replacePhiIncomingBlock(succ, bb, pred);
+	}
+	LLVMDeleteBasicBlock(bb);
+	return true;
+}
+
+// Merges every block that is the only successor of its only predecessor into it, such as the pieces left
+// behind when a conditional branch loses one of its edges
+void mergeStraightLines(LLVMValueRef function) {
+	for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; ) {
+		LLVMBasicBlockRef next = LLVMGetNextBasicBlock(bb);
+		mergeIntoPredecessor(bb);
+		bb = next;
+	}
+}
+
+// ---- Dominators and loops ----
+
+// Blocks reachable from the entry, in reverse post-order
+vector<LLVMBasicBlockRef> reversePostOrder(LLVMValueRef function) {
+	vector<LLVMBasicBlockRef> postOrder;
+	unordered_set<LLVMBasicBlockRef> visited;
+	vector<pair<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>>> stack; // (block, successors left to visit)
+
+	LLVMBasicBlockRef entry = LLVMGetEntryBasicBlock(function);
+	visited.insert(entry);
+	vector<LLVMBasicBlockRef> entrySuccs = getSuccessors(entry);
+	stack.push_back(make_pair(entry, vector<LLVMBasicBlockRef>(entrySuccs.rbegin(), entrySuccs.rend())));
+	while (!stack.empty()) {
+		vector<LLVMBasicBlockRef>& pending = stack.back().second;
+		if (pending.empty()) {
+			postOrder.push_back(stack.back().first);
+			stack.pop_back();
+			continue;
+		}
+		LLVMBasicBlockRef succ = pending.back();
+		pending.pop_back();
+		if (visited.insert(succ).second) {
+			vector<LLVMBasicBlockRef> succs = getSuccessors(succ);
+			stack.push_back(make_pair(succ, vector<LLVMBasicBlockRef>(succs.rbegin(), succs.rend())));
+		}
+	}
+	return vector<LLVMBasicBlockRef>(postOrder.rbegin(), postOrder.rend());
+}
+
+// Deletes the blocks that cannot be reached from the entry and returns how many there were
+int deleteUnreachableBlocks(LLVMValueRef function) {
+	vector<LLVMBasicBlockRef> rpo = reversePostOrder(function);
+	unordered_set<LLVMBasicBlockRef> reachable(rpo.begin(), rpo.end());
+
+	vector<LLVMBasicBlockRef> dead;
+	for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+		if (!reachable.count(bb)) dead.push_back(bb);
+	}
+	if (!dead.empty()) {
+		invalidateAnalyses(function);
+		markFunctionChanged(function);
+	}
+
+	for (LLVMBasicBlockRef bb : dead) {
+		for (LLVMBasicBlockRef succ : getSuccessors(bb)) {
+			if (reachable.count(succ)) removePhiIncomingBlock(succ, bb);
+		}
+	}
+	// Dead blocks may still refer to each other, so their instructions are detached before any block goes
+	for (LLVMBasicBlockRef bb : dead) {
+		LLVMInstructionEraseFromParent(LLVMGetBasicBlockTerminator(bb));
+		for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+			if (LLVMGetFirstUse(inst) != NULL) LLVMReplaceAllUsesWith(inst, LLVMGetUndef(LLVMTypeOf(inst)));
+		}
+	}
+	for (LLVMBasicBlockRef bb : dead) {
+		LLVMDeleteBasicBlock(bb);
+	}
+	return dead.size();
+}
+
+struct DominatorTree {
+	vector<LLVMBasicBlockRef> rpo;                            // reachable blocks in reverse post-order
+	unordered_map<LLVMBasicBlockRef, int> rpoIndex;
+	unordered_map<LLVMBasicBlockRef, LLVMBasicBlockRef> idom; // immediate dominator, the entry maps to itself
+};
+
+// Iterative algorithm of Cooper, Harvey and Kennedy over the reverse post-order
+DominatorTree computeDominators(LLVMValueRef function) {
+	DominatorTree dom;
+	dom.rpo = reversePostOrder(function);
+	for (size_t i = 0; i < dom.rpo.size(); i++) {
+		dom.rpoIndex[dom.rpo[i]] = i;
+	}
+	unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>> preds = computePredecessors(function);
+
+	LLVMBasicBlockRef entry = dom.rpo[0];
+	dom.idom[entry] = entry;
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (size_t i = 1; i < dom.rpo.size(); i++) {
+			LLVMBasicBlockRef bb = dom.rpo[i];
+			LLVMBasicBlockRef newIdom = NULL;
+			for (LLVMBasicBlockRef pred : preds[bb]) {
+				if (!dom.idom.count(pred)) continue; // unreachable or not processed yet
+				if (newIdom == NULL) {
+					newIdom = pred;
+					continue;
+				}
+				// Intersect: walk both up the tree until they meet
+				LLVMBasicBlockRef a = pred, b = newIdom;
+				while (a != b) {
+					while (dom.rpoIndex[a] > dom.rpoIndex[b]) a = dom.idom[a];
+					while (dom.rpoIndex[b] > dom.rpoIndex[a]) b = dom.idom[b];
+				}
+				newIdom = a;
+			}
+			if (dom.idom[bb] != newIdom) {
+				dom.idom[bb] = newIdom;
+				changed = true;
+			}
+		}
+	}
+	return dom;
+}
+
+// Whether block a dominates block b (false when b is unreachable)
+bool dominates(DominatorTree& dom, LLVMBasicBlockRef a, LLVMBasicBlockRef b) {
+	if (!dom.idom.count(b)) return false;
+	while (true) {
+		if (a == b) return true;
+		LLVMBasicBlockRef up = dom.idom[b];
+		if (up == b) return false;
+		b = up;
+	}
+}
+
+// The deepest block dominating both a and b (both reachable)
+LLVMBasicBlockRef nearestCommonDominator(DominatorTree& dom, LLVMBasicBlockRef a, LLVMBasicBlockRef b) {
+	while (a != b) {
+		while (dom.rpoIndex[a] > dom.rpoIndex[b]) a = dom.idom[a];
+		while (dom.rpoIndex[b] > dom.rpoIndex[a]) b = dom.idom[b];
+	}
+	return a;
+}
+
+struct Loop {
+	LLVMBasicBlockRef header;
+	vector<LLVMBasicBlockRef> blocks;          // in function order
+	unordered_set<LLVMBasicBlockRef> contains;
+	vector<LLVMBasicBlockRef> latches;         // blocks with a back edge to the header
+	int parent;                                // innermost enclosing loop, -1 for an outermost loop
+	int depth;                                 // 1 for an outermost loop
+};
+
+// Natural loops of the function, one per header (back edges to the same header are merged).
+// Inner loops come before the loops that contain them.
+vector<Loop> findLoops(LLVMValueRef function, DominatorTree& dom) {
+	unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>> preds = computePredecessors(function);
+	vector<Loop> loops;
+
+	for (LLVMBasicBlockRef header : dom.rpo) {
+		Loop loop;
+		loop.header = header;
+		for (LLVMBasicBlockRef pred : preds[header]) {
+			if (dominates(dom, header, pred)) loop.latches.push_back(pred);
+		}
+		if (loop.latches.empty()) continue;
+
+		// Everything that reaches a latch without going through the header
+		loop.contains.insert(header);
+		vector<LLVMBasicBlockRef> worklist(loop.latches.begin(), loop.latches.end());
+		while (!worklist.empty()) {
+			LLVMBasicBlockRef bb = worklist.back();
+			worklist.pop_back();
+			if (!loop.contains.insert(bb).second) continue;
+			for (LLVMBasicBlockRef pred : preds[bb]) {
+				if (dom.idom.count(pred)) worklist.push_back(pred);
+			}
+		}
+		for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+			if (loop.contains.count(bb)) loop.blocks.push_back(bb);
+		}
+		loops.push_back(loop);
+	}
+
+	stable_sort(loops.begin(), loops.end(), [](const Loop& a, const Loop& b) {
+		return a.blocks.size() < b.blocks.size();
+	});
+	for (size_t i = 0; i < loops.size(); i++) {
+		loops[i].parent = -1;
+		for (size_t j = i + 1; j < loops.size(); j++) {
+			if (loops[j].contains.count(loops[i].header)) {
+				loops[i].parent = j;
+				break;
+			}
+		}
+	}
+	for (int i = loops.size() - 1; i >= 0; i--) {
+		loops[i].depth = loops[i].parent < 0 ? 1 : loops[loops[i].parent].depth + 1;
+	}
+	return loops;
+}
+
+// Number of loops containing the block
+int loopDepth(vector<Loop>& loops, LLVMBasicBlockRef bb) {
+	int depth = 0;
+	for (Loop& loop : loops) {
+		if (loop.contains.count(bb)) depth = max(depth, loop.depth);
+	}
+	return depth;
+}
+
+// The only block outside loop that branches to its header, split off into a block that does nothing but jump
+// to the header if it branches elsewhere too. NULL when the loop is entered from several places.
+LLVMBasicBlockRef loopPreheader(Loop& loop, unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>>& preds) {
+	LLVMBasicBlockRef outside = NULL;
+	for (LLVMBasicBlockRef pred : preds[loop.header]) {
+		if (loop.contains.count(pred)) continue;
+		if (outside != NULL) return NULL;
+		outside = pred;
+	}
+	if (outside == NULL) return NULL;
+	if (LLVMGetNumSuccessors(LLVMGetBasicBlockTerminator(outside)) == 1) return outside;
+	return splitEdge(outside, loop.header);
+}
+
+// ---- Memory SSA ----
+
+// The local variables of a function (see isLocalVariable) in SSA form as far as their memory goes: every store
+// is a new version (a definition) of the variable it writes, a memory phi merges the versions coming in where
+// control flow joins, and every load is linked to the version it reads, its clobbering definition. Which stores
+// a load can see, whether two loads see the same contents and whether anything reads a store then become walks
+// along these def-use chains, instead of dataflow sets over every block. Other memory, and the loads and stores
+// of unreachable blocks, are not tracked; the passes fall back to the reaching stores and live loads for them.
+//
+// Construction follows Cytron et al.: phis go on the iterated dominance frontier of the blocks that store to a
+// variable, and a block without a phi for a variable sees the version leaving its immediate dominator.
+
+struct MemoryDef {
+	LLVMValueRef variable;
+	LLVMValueRef store;          // NULL for phis and for the contents on entry
+	LLVMBasicBlockRef phiBlock;  // the join of a phi, NULL otherwise
+	vector<MemoryDef*> incoming; // of a phi, the versions leaving its reachable predecessors
+	vector<LLVMValueRef> loads;  // that read this version
+	vector<MemoryDef*> phiUsers; // phis this version flows into
+};
+
+struct MemorySSA {
+	list<MemoryDef> defs;
+	unordered_map<LLVMValueRef, MemoryDef*> storeDefs;
+	unordered_map<LLVMValueRef, MemoryDef*> clobbers; // of every tracked load
+};
+
+// Dominance frontiers of the reachable blocks (Cooper, Harvey and Kennedy)
+unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>> dominanceFrontiers(DominatorTree& dom,
+		unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>>& preds) {
+	unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>> frontiers;
+	for (LLVMBasicBlockRef bb : dom.rpo) {
+		if (preds[bb].size() < 2) continue;
+		for (LLVMBasicBlockRef pred : preds[bb]) {
+			if (!dom.idom.count(pred)) continue;
+			for (LLVMBasicBlockRef runner = pred; runner != dom.idom[bb]; runner = dom.idom[runner]) {
+				vector<LLVMBasicBlockRef>& frontier = frontiers[runner];
+				if (find(frontier.begin(), frontier.end(), bb) == frontier.end()) frontier.push_back(bb);
+			}
+		}
+	}
+	return frontiers;
+}
+
+void computeMemorySSA(LLVMValueRef function, DominatorTree& dom,
+		unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>>& preds, MemorySSA& memory) {
+	memory.defs.clear();
+	memory.storeDefs.clear();
+	memory.clobbers.clear();
+
+	LLVMBasicBlockRef entry = LLVMGetEntryBasicBlock(function);
+	vector<LLVMValueRef> variables;
+	unordered_map<LLVMValueRef, MemoryDef*> onEntry;
+	unordered_map<LLVMValueRef, vector<LLVMBasicBlockRef>> storeBlocks;
+	for (LLVMBasicBlockRef bb : dom.rpo) {
+		for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+			if (LLVMIsAAllocaInst(inst) && isLocalVariable(inst)) {
+				variables.push_back(inst);
+				memory.defs.push_back({ inst, NULL, NULL, {}, {}, {} });
+				onEntry[inst] = &memory.defs.back();
+			}
+		}
+	}
+	for (LLVMBasicBlockRef bb : dom.rpo) {
+		for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+			if (!LLVMIsAStoreInst(inst) || !onEntry.count(LLVMGetOperand(inst, 1))) continue;
+			vector<LLVMBasicBlockRef>& blocks = storeBlocks[LLVMGetOperand(inst, 1)];
+			if (blocks.empty() || blocks.back() != bb) blocks.push_back(bb);
+		}
+	}
+
+	// Phis on the iterated dominance frontiers
+	unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>> frontiers = dominanceFrontiers(dom, preds);
+	unordered_map<LLVMBasicBlockRef, unordered_map<LLVMValueRef, MemoryDef*>> phis;
+	for (LLVMValueRef variable : variables) {
+		vector<LLVMBasicBlockRef> worklist = storeBlocks[variable];
+		while (!worklist.empty()) {
+			LLVMBasicBlockRef bb = worklist.back();
+			worklist.pop_back();
+			for (LLVMBasicBlockRef join : frontiers[bb]) {
+				if (phis[join].count(variable)) continue;
+				memory.defs.push_back({ variable, NULL, join, {}, {}, {} });
+				phis[join][variable] = &memory.defs.back();
+				worklist.push_back(join);
+			}
+		}
+	}
+
+	// Renaming, in reverse post-order so that immediate dominators come first
+	unordered_map<LLVMBasicBlockRef, unordered_map<LLVMValueRef, MemoryDef*>> lastStores;
+	// Only looks up, never inserts: it also runs while the phis are linked below, and an insertion into phis
+	// could rehash it under that loop
+	auto lookUp = [](unordered_map<LLVMBasicBlockRef, unordered_map<LLVMValueRef, MemoryDef*>>& versions,
+			LLVMBasicBlockRef bb, LLVMValueRef variable) -> MemoryDef* {
+		auto block = versions.find(bb);
+		if (block == versions.end()) return NULL;
+		auto version = block->second.find(variable);
+		return version != block->second.end() ? version->second : NULL;
+	};
+	auto versionOnEntry = [&](LLVMBasicBlockRef bb, LLVMValueRef variable) {
+		while (true) {
+			if (MemoryDef* phi = lookUp(phis, bb, variable)) return phi;
+			if (bb == entry) return onEntry[variable];
+			bb = dom.idom[bb];
+			if (MemoryDef* last = lookUp(lastStores, bb, variable)) return last;
+		}
+	};
+	for (LLVMBasicBlockRef bb : dom.rpo) {
+		unordered_map<LLVMValueRef, MemoryDef*>& current = lastStores[bb];
+		for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+			if (LLVMIsALoadInst(inst) && onEntry.count(LLVMGetOperand(inst, 0))) {
+				LLVMValueRef variable = LLVMGetOperand(inst, 0);
+				auto it = current.find(variable);
+				MemoryDef* version = it != current.end() ? it->second : versionOnEntry(bb, variable);
+				version->loads.push_back(inst);
+				memory.clobbers[inst] = version;
+			} else if (LLVMIsAStoreInst(inst) && onEntry.count(LLVMGetOperand(inst, 1))) {
+				LLVMValueRef variable = LLVMGetOperand(inst, 1);
+				memory.defs.push_back({ variable, inst, NULL, {}, {}, {} });
+				current[variable] = memory.storeDefs[inst] = &memory.defs.back();
+			}
+		}
+	}
+	for (auto& join : phis) {
+		for (auto& entryPhi : join.second) {
+			MemoryDef* phi = entryPhi.second;
+			for (LLVMBasicBlockRef pred : preds[join.first]) {
+				if (!dom.idom.count(pred)) continue;
+				MemoryDef* version = lookUp(lastStores, pred, phi->variable);
+				if (!version) version = versionOnEntry(pred, phi->variable);
+				phi->incoming.push_back(version);
+				version->phiUsers.push_back(phi);
+			}
+		}
+	}
+	countStatistic("memory phis", memory.defs.size() - variables.size() - memory.storeDefs.size());
+}
+
+bool memoryTracks(MemorySSA& memory, LLVMValueRef access) {
+	return memory.clobbers.count(access) || memory.storeDefs.count(access);
+}
+
+// Whether two tracked loads read the same version of their variable
+bool sameMemoryVersion(MemorySSA& memory, LLVMValueRef load1, LLVMValueRef load2) {
+	auto it1 = memory.clobbers.find(load1);
+	auto it2 = memory.clobbers.find(load2);
+	return it1 != memory.clobbers.end() && it2 != memory.clobbers.end() && it1->second == it2->second;
+}
+
+// The value every store that load can see writes, or NULL if they disagree (or there are none, or load is not
+// tracked). Paths on which the variable was never written are ignored, like the reaching stores do.
+LLVMValueRef storedValue(MemorySSA& memory, LLVMValueRef load) {
+	auto it = memory.clobbers.find(load);
+	if (it == memory.clobbers.end()) return NULL;
+
+	LLVMValueRef value = NULL;
+	vector<MemoryDef*> worklist = { it->second };
+	unordered_set<MemoryDef*> seen = { it->second };
+	while (!worklist.empty()) {
+		MemoryDef* def = worklist.back();
+		worklist.pop_back();
+		if (def->store) {
+			LLVMValueRef stored = LLVMGetOperand(def->store, 0);
+			if (value && !operandsEqual(value, stored)) return NULL;
+			value = stored;
+		}
+		for (MemoryDef* in : def->incoming) {
+			if (seen.insert(in).second) worklist.push_back(in);
+		}
+	}
+	return value;
+}
+
+// Whether no load reads the version a tracked store defines, directly or through phis
+bool storeIsDead(MemorySSA& memory, LLVMValueRef store) {
+	auto it = memory.storeDefs.find(store);
+	if (it == memory.storeDefs.end()) return false;
+
+	vector<MemoryDef*> worklist = { it->second };
+	unordered_set<MemoryDef*> seen = { it->second };
+	while (!worklist.empty()) {
+		MemoryDef* def = worklist.back();
+		worklist.pop_back();
+		if (!def->loads.empty()) return false;
+		for (MemoryDef* phi : def->phiUsers) {
+			if (seen.insert(phi).second) worklist.push_back(phi);
+		}
+	}
+	return true;
+}
+
+// ---- Analysis manager ----
+
+// Analyses of each function are computed when a pass first asks for them and cached until they go stale.
+// After a pass reports changes, the pass manager drops the analyses that pass does not declare to preserve
+// (PRESERVE_CFG: it leaves the blocks and branches alone, PRESERVE_ALL: it does not add or remove loads and
+// stores either). The CFG utilities drop the analyses of the function they change right away, since passes
+// also use them on the way to deciding that there is nothing to do. Invalidating only clears the valid bits,
+// so references a pass still holds stay usable (though stale) until it asks again. Reaching stores and live
+// loads that are still valid are brought up to date with the loads and stores rather than reused as they are.
+
+struct FunctionAnalyses {
+	unsigned valid; // AnalysisKind bits
+	unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>> preds;
+	vector<LLVMBasicBlockRef> rpo;
+	DominatorTree dom;
+	vector<Loop> loops;
+	AddressIndex addresses;
+	DataflowSolution reachingStores;
+	DataflowSolution liveLoads;
+	MemorySSA memory;
+};
+
+thread_local unordered_map<LLVMValueRef, FunctionAnalyses> analysisCache;
+
+// The cache entry of function, with kind valid; returns whether it has to be computed
+bool analysisMissing(LLVMValueRef function, AnalysisKind kind, FunctionAnalyses*& analyses) {
+	auto it = analysisCache.find(function);
+	if (it == analysisCache.end()) {
+		it = analysisCache.insert(make_pair(function, FunctionAnalyses())).first;
+		it->second.valid = 0;
+	}
+	analyses = &it->second;
+	if (analyses->valid & kind) {
+		countStatistic("analyses reused");
+		return false;
+	}
+	countStatistic("analyses computed");
+	analyses->valid |= kind;
+	return true;
+}
+
+unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>>& cachedPredecessors(LLVMValueRef function) {
+	FunctionAnalyses* analyses;
+	if (analysisMissing(function, ANALYSIS_PREDECESSORS, analyses)) analyses->preds = computePredecessors(function);
+	return analyses->preds;
+}
+
+vector<LLVMBasicBlockRef>& cachedReversePostOrder(LLVMValueRef function) {
+	FunctionAnalyses* analyses;
+	if (analysisMissing(function, ANALYSIS_RPO, analyses)) analyses->rpo = reversePostOrder(function);
+	return analyses->rpo;
+}
+
+DominatorTree& cachedDominators(LLVMValueRef function) {
+	FunctionAnalyses* analyses;
+	if (analysisMissing(function, ANALYSIS_DOMINATORS, analyses)) analyses->dom = computeDominators(function);
+	return analyses->dom;
+}
+
+vector<Loop>& cachedLoops(LLVMValueRef function) {
+	DominatorTree& dom = cachedDominators(function);
+	FunctionAnalyses* analyses;
+	if (analysisMissing(function, ANALYSIS_LOOPS, analyses)) analyses->loops = findLoops(function, dom);
+	return analyses->loops;
+}
+
+AddressIndex& cachedAddresses(LLVMValueRef function) {
+	FunctionAnalyses* analyses;
+	if (analysisMissing(function, ANALYSIS_ADDRESSES, analyses)) {
+		AddressIndex& index = analyses->addresses;
+		index.loads.clear();
+		index.stores.clear();
+		for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+			for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+				if (LLVMIsALoadInst(inst)) index.loads[LLVMGetOperand(inst, 0)].push_back(inst);
+				else if (LLVMIsAStoreInst(inst)) index.stores[LLVMGetOperand(inst, 1)].push_back(inst);
+			}
+		}
+	}
+	return analyses->addresses;
+}
+
+unordered_map<LLVMBasicBlockRef, BBDataflow>& cachedReachingStores(LLVMValueRef function) {
+	FunctionAnalyses* analyses;
+	bool fresh = analysisMissing(function, ANALYSIS_REACHING_STORES, analyses);
+	updateDataflow(function, reachingStoresProblem, analyses->reachingStores, fresh);
+	return analyses->reachingStores.blocks;
+}
+
+unordered_map<LLVMBasicBlockRef, BBDataflow>& cachedLiveLoads(LLVMValueRef function) {
+	FunctionAnalyses* analyses;
+	bool fresh = analysisMissing(function, ANALYSIS_LIVE_LOADS, analyses);
+	updateDataflow(function, liveLoadsProblem, analyses->liveLoads, fresh);
+	return analyses->liveLoads.blocks;
+}
+
+// Empty for a declaration
+MemorySSA& cachedMemorySSA(LLVMValueRef function) {
+	FunctionAnalyses* analyses;
+	if (analysisMissing(function, ANALYSIS_MEMORY_SSA, analyses) && LLVMGetFirstBasicBlock(function)) {
+		computeMemorySSA(function, cachedDominators(function), cachedPredecessors(function), analyses->memory);
+	}
+	return analyses->memory;
+}
+
+void invalidateAnalyses(LLVMValueRef function, unsigned preserved) {
+	auto it = analysisCache.find(function);
+	if (it != analysisCache.end()) it->second.valid &= preserved;
+}
+
+// Called between passes only: without anything preserved, functions may have been deleted, so the whole
+// cache goes
+void invalidateAllAnalyses(unsigned preserved) {
+	if (preserved == PRESERVE_NONE) {
+		analysisCache.clear();
+		return;
+	}
+	for (auto& entry : analysisCache) {
+		entry.second.valid &= preserved;
+	}
+}
+
+// ---- Partial redundancy elimination (lazy code motion) ----
+
+// Expressions are matched lexically, as they are written in the source. An operand of an expression is a value
+// that never changes inside the function (a constant or an argument), the current contents of a local variable
+// (a load from an alloca, see isLocalVariable), or another expression. An expression is killed by any store to
+// one of the variables it reads.
+//
+// Per block we compute:
+// - ANTLOC: the expression is computed before any kill in the block (upward exposed)
+// - COMP: the expression is computed after the last kill in the block (downward exposed)
+// - TRANSP: the block does not kill the expression
+//
+// Then the edge based formulation of lazy code motion (Drechsler & Stadel):
+// - ANTOUT[B] = ∩ ANTIN[S] for all successors S (empty at exits)
+//   ANTIN[B] = ANTLOC[B] U (TRANSP[B] ∩ ANTOUT[B])
+// - AVIN[B] = ∩ AVOUT[P] for all predecessors P (empty at the entry)
+//   AVOUT[B] = COMP[B] U (TRANSP[B] ∩ AVIN[B])
+// - EARLIEST(P,S) = ANTIN[S] ∩ ¬AVOUT[P] ∩ (¬TRANSP[P] U ¬ANTOUT[P])
+// - LATER(P,S) = EARLIEST(P,S) U (LATERIN[P] ∩ ¬ANTLOC[P])
+//   LATERIN[B] = ∩ LATER(P,B) for all predecessors P (ANTIN at the entry)
+// - INSERT(P,S) = LATER(P,S) ∩ ¬LATERIN[S]
+// - DELETE[B] = ANTLOC[B] ∩ ¬LATERIN[B]
+//
+// Each transformed expression gets a temporary alloca. Inserted computations and the computations that are kept
+// store into it, and the deleted (fully redundant) computations become a load of it. Every path evaluates each
+// expression at most as often as before. The leftover loads and stores are cleaned up by the other passes.
+
+enum PRETermKind { PRE_VALUE, PRE_VARIABLE, PRE_EXPR };
+
+struct PRETerm {
+	PRETermKind kind;
+	LLVMValueRef value; // the constant or argument for PRE_VALUE, the alloca for PRE_VARIABLE
+	LLVMTypeRef type;   // loaded type for PRE_VARIABLE
+	int expr;           // expression index for PRE_EXPR
+};
+
+struct PREExpr {
+	LLVMOpcode opcode;
+	LLVMTypeRef type;
+	PRETerm operands[2];
+	unordered_set<LLVMValueRef> variables; // local variables read by the expression
+	vector<LLVMValueRef> occurrences;      // instructions computing the expression
+	LLVMValueRef temp;
+};
+
+struct PREBlock {
+	vector<pair<int, LLVMValueRef>> events; // in order: (expr, instruction) for a computation, (-1, alloca) for a store
+	vector<bool> antloc, comp, transp;
+	vector<bool> antIn, antOut, avIn, avOut, laterIn;
+	unordered_map<int, LLVMValueRef> firstOccurrence; // upward exposed occurrence of each ANTLOC expression
+};
+
+string preTermKey(PRETerm& term) {
+	char buf[64];
+	snprintf(buf, sizeof(buf), "%d:%p:%p:%d", term.kind, (void*)term.value, (void*)term.type, term.expr);
+	return string(buf);
+}
+
+// Builds the term for an operand at the current point of the block walk. Loads and expressions must come
+// from the same block and must not be stale (a store to one of their variables happened since).
+bool preBuildTerm(LLVMValueRef operand, LLVMBasicBlockRef bb, unordered_map<LLVMValueRef, int>& instExpr,
+		unordered_set<LLVMValueRef>& stale, PRETerm& term) {
+	term.value = NULL;
+	term.type = NULL;
+	term.expr = -1;
+
+	if (LLVMIsAConstantInt(operand) || LLVMIsAArgument(operand)) {
+		term.kind = PRE_VALUE;
+		term.value = operand;
+		return true;
+	}
+
+	if (!LLVMIsAInstruction(operand) || LLVMGetInstructionParent(operand) != bb || stale.count(operand)) {
+		return false;
+	}
+
+	if (LLVMIsALoadInst(operand) && isLocalVariable(LLVMGetOperand(operand, 0))) {
+		term.kind = PRE_VARIABLE;
+		term.value = LLVMGetOperand(operand, 0);
+		term.type = LLVMTypeOf(operand);
+		return true;
+	}
+
+	auto it = instExpr.find(operand);
+	if (it != instExpr.end()) {
+		term.kind = PRE_EXPR;
+		term.expr = it->second;
+		return true;
+	}
+
+	return false;
+}
+
+// Emits a fresh computation of the expression at the builder position
+LLVMValueRef preMaterialize(LLVMBuilderRef builder, vector<PREExpr>& exprs, int e) {
+	LLVMValueRef operands[2];
+	for (int i = 0; i < 2; i++) {
+		PRETerm& term = exprs[e].operands[i];
+		if (term.kind == PRE_VALUE) {
+			operands[i] = term.value;
+		} else if (term.kind == PRE_VARIABLE) {
+			operands[i] = LLVMBuildLoad2(builder, term.type, term.value, "");
+		} else {
+			operands[i] = preMaterialize(builder, exprs, term.expr);
+		}
+	}
+	return LLVMBuildBinOp(builder, exprs[e].opcode, operands[0], operands[1], "");
+}
+
+int partialRedundancyElimination(LLVMModuleRef module) {
+	bool changed = false;
+
+	for (LLVMValueRef function =  firstFunction(module); 
+			function; 
+			function = nextFunction(function)) {
+
+		if (LLVMGetFirstBasicBlock(function) == NULL || !needsVisit(function)) continue;
+
+		vector<PREExpr> exprs;
+		unordered_map<string, int> exprIndex;
+		unordered_map<LLVMValueRef, int> instExpr; // instruction -> expression it computes
+		vector<LLVMBasicBlockRef> blocks;
+		unordered_map<LLVMBasicBlockRef, PREBlock> info;
+
+		// Find the expressions and the order of computations and kills in each block
+		for (LLVMBasicBlockRef basicBlock = LLVMGetFirstBasicBlock(function);
+ 			 basicBlock;
+  			 basicBlock = LLVMGetNextBasicBlock(basicBlock)) {
+
+			blocks.push_back(basicBlock);
+			PREBlock& block = info[basicBlock];
+
+			unordered_map<LLVMValueRef, vector<LLVMValueRef>> readers; // variable -> loads/expressions of this block reading it
+			unordered_set<LLVMValueRef> stale;
+
+			for (LLVMValueRef inst = LLVMGetFirstInstruction(basicBlock); inst;
+  					inst = LLVMGetNextInstruction(inst)) {
+
+				if (LLVMIsAStoreInst(inst)) {
+					LLVMValueRef storeAddr = LLVMGetOperand(inst, 1);
+					if (isLocalVariable(storeAddr)) {
+						block.events.push_back(make_pair(-1, storeAddr));
+						for (LLVMValueRef reader : readers[storeAddr]) {
+							stale.insert(reader);
+						}
+						readers[storeAddr].clear();
+					}
+				} else if (LLVMIsALoadInst(inst)) {
+					readers[LLVMGetOperand(inst, 0)].push_back(inst);
+				} else if (LLVMIsABinaryOperator(inst)) {
+					PRETerm terms[2];
+					if (!preBuildTerm(LLVMGetOperand(inst, 0), basicBlock, instExpr, stale, terms[0])
+							|| !preBuildTerm(LLVMGetOperand(inst, 1), basicBlock, instExpr, stale, terms[1])) {
+						continue;
+					}
+
+					LLVMOpcode op = LLVMGetInstructionOpcode(inst);
+					string key = to_string(op) + "|" + preTermKey(terms[0]) + "|" + preTermKey(terms[1]);
+					if (op == LLVMAdd || op == LLVMMul || op == LLVMAnd || op == LLVMOr || op == LLVMXor) {
+						// Commutative: reuse the expression if it was first seen with the operands swapped
+						string swapped = to_string(op) + "|" + preTermKey(terms[1]) + "|" + preTermKey(terms[0]);
+						if (exprIndex.count(swapped)) key = swapped;
+					}
+
+					int e;
+					auto it = exprIndex.find(key);
+					if (it != exprIndex.end()) {
+						e = it->second;
+					} else {
+						e = exprs.size();
+						exprIndex[key] = e;
+						PREExpr expr;
+						expr.opcode = op;
+						expr.type = LLVMTypeOf(inst);
+						expr.temp = NULL;
+						for (int i = 0; i < 2; i++) {
+							expr.operands[i] = terms[i];
+							if (terms[i].kind == PRE_VARIABLE) {
+								expr.variables.insert(terms[i].value);
+							} else if (terms[i].kind == PRE_EXPR) {
+								unordered_set<LLVMValueRef>& nested = exprs[terms[i].expr].variables;
+								expr.variables.insert(nested.begin(), nested.end());
+							}
+						}
+						exprs.push_back(expr);
+					}
+
+					instExpr[inst] = e;
+					exprs[e].occurrences.push_back(inst);
+					for (LLVMValueRef var : exprs[e].variables) {
+						readers[var].push_back(inst);
+					}
+					block.events.push_back(make_pair(e, inst));
+				}
+			}
+		}
+
+		size_t numExprs = exprs.size();
+		if (numExprs == 0) continue;
+
+		unordered_map<LLVMValueRef, vector<int>> exprsReading; // variable -> expressions it kills
+		for (size_t e = 0; e < numExprs; e++) {
+			for (LLVMValueRef var : exprs[e].variables) {
+				exprsReading[var].push_back(e);
+			}
+		}
+
+		// Local properties
+		for (LLVMBasicBlockRef bb : blocks) {
+			PREBlock& block = info[bb];
+			block.antloc.assign(numExprs, false);
+			block.comp.assign(numExprs, false);
+			block.transp.assign(numExprs, true);
+
+			for (pair<int, LLVMValueRef>& event : block.events) {
+				if (event.first >= 0) {
+					int e = event.first;
+					if (block.transp[e] && !block.antloc[e]) {
+						block.antloc[e] = true;
+						block.firstOccurrence[e] = event.second;
+					}
+					block.comp[e] = true;
+				} else {
+					for (int e : exprsReading[event.second]) {
+						block.transp[e] = false;
+						block.comp[e] = false;
+					}
+				}
+			}
+		}
+
+		unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>>& preds = cachedPredecessors(function);
+		unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>> succs;
+		for (LLVMBasicBlockRef bb : blocks) {
+			succs[bb] = getSuccessors(bb);
+		}
+
+		// Anticipability (backward, greatest fixpoint)
+		for (LLVMBasicBlockRef bb : blocks) {
+			info[bb].antIn.assign(numExprs, true);
+			info[bb].antOut.assign(numExprs, false);
+		}
+		bool setsChanged = true;
+		while (setsChanged) {
+			setsChanged = false;
+			for (auto it = blocks.rbegin(); it != blocks.rend(); ++it) {
+				PREBlock& block = info[*it];
+
+				vector<bool> antOut(numExprs, !succs[*it].empty());
+				for (LLVMBasicBlockRef succ : succs[*it]) {
+					vector<bool>& succIn = info[succ].antIn;
+					for (size_t e = 0; e < numExprs; e++) antOut[e] = antOut[e] && succIn[e];
+				}
+				block.antOut = antOut;
+
+				for (size_t e = 0; e < numExprs; e++) {
+					bool antIn = block.antloc[e] || (block.transp[e] && antOut[e]);
+					if (antIn != block.antIn[e]) {
+						block.antIn[e] = antIn;
+						setsChanged = true;
+					}
+				}
+			}
+		}
+
+		// Availability (forward, greatest fixpoint)
+		for (LLVMBasicBlockRef bb : blocks) {
+			info[bb].avIn.assign(numExprs, false);
+			info[bb].avOut.assign(numExprs, true);
+		}
+		setsChanged = true;
+		while (setsChanged) {
+			setsChanged = false;
+			for (LLVMBasicBlockRef bb : blocks) {
+				PREBlock& block = info[bb];
+
+				vector<bool> avIn(numExprs, !preds[bb].empty() && bb != blocks[0]);
+				for (LLVMBasicBlockRef pred : preds[bb]) {
+					vector<bool>& predOut = info[pred].avOut;
+					for (size_t e = 0; e < numExprs; e++) avIn[e] = avIn[e] && predOut[e];
+				}
+				block.avIn = avIn;
+
+				for (size_t e = 0; e < numExprs; e++) {
+					bool avOut = block.comp[e] || (block.transp[e] && avIn[e]);
+					if (avOut != block.avOut[e]) {
+						block.avOut[e] = avOut;
+						setsChanged = true;
+					}
+				}
+			}
+		}
+
+		// Later (forward, greatest fixpoint). The entry block and unreachable blocks have only the
+		// virtual entry edge, on which EARLIEST = ANTIN.
+		for (LLVMBasicBlockRef bb : blocks) {
+			if (bb == blocks[0] || preds[bb].empty()) {
+				info[bb].laterIn = info[bb].antIn;
+			} else {
+				info[bb].laterIn.assign(numExprs, true);
+			}
+		}
+		auto later = [&](LLVMBasicBlockRef p, LLVMBasicBlockRef s, size_t e) {
+			PREBlock& pb = info[p];
+			bool earliest = info[s].antIn[e] && !pb.avOut[e] && (!pb.transp[e] || !pb.antOut[e]);
+			return earliest || (pb.laterIn[e] && !pb.antloc[e]);
+		};
+		setsChanged = true;
+		while (setsChanged) {
+			setsChanged = false;
+			for (LLVMBasicBlockRef bb : blocks) {
+				if (bb == blocks[0] || preds[bb].empty()) continue;
+				PREBlock& block = info[bb];
+
+				for (size_t e = 0; e < numExprs; e++) {
+					bool laterIn = true;
+					for (LLVMBasicBlockRef pred : preds[bb]) {
+						if (!later(pred, bb, e)) {
+							laterIn = false;
+							break;
+						}
+					}
+					if (laterIn != block.laterIn[e]) {
+						block.laterIn[e] = laterIn;
+						setsChanged = true;
+					}
+				}
+			}
+		}
+
+		// Collect the deletions and edge insertions. Expressions without a deletion are left alone.
+		vector<bool> transformed(numExprs, false);
+		vector<LLVMValueRef> toDelete;
+		for (LLVMBasicBlockRef bb : blocks) {
+			PREBlock& block = info[bb];
+			for (size_t e = 0; e < numExprs; e++) {
+				if (block.antloc[e] && !block.laterIn[e]) {
+					transformed[e] = true;
+					toDelete.push_back(block.firstOccurrence[e]);
+				}
+			}
+		}
+		if (toDelete.empty()) continue;
+
+		vector<pair<pair<LLVMBasicBlockRef, LLVMBasicBlockRef>, vector<int>>> insertions;
+		for (LLVMBasicBlockRef bb : blocks) {
+			for (LLVMBasicBlockRef pred : preds[bb]) {
+				vector<int> edgeExprs;
+				for (size_t e = 0; e < numExprs; e++) {
+					if (transformed[e] && later(pred, bb, e) && !info[bb].laterIn[e]) {
+						edgeExprs.push_back(e);
+					}
+				}
+				if (!edgeExprs.empty()) {
+					insertions.push_back(make_pair(make_pair(pred, bb), edgeExprs));
+				}
+			}
+		}
+
+		LLVMBuilderRef builder = LLVMCreateBuilderInContext(LLVMGetModuleContext(module));
+		unordered_set<LLVMValueRef> deleted(toDelete.begin(), toDelete.end());
+
+		// A temporary per transformed expression, updated by every computation that is kept
+		LLVMValueRef entryFirst = LLVMGetFirstInstruction(blocks[0]);
+		for (size_t e = 0; e < numExprs; e++) {
+			if (!transformed[e]) continue;
+
+			LLVMPositionBuilderBefore(builder, entryFirst);
+			exprs[e].temp = LLVMBuildAlloca(builder, exprs[e].type, "");
+
+			for (LLVMValueRef occurrence : exprs[e].occurrences) {
+				if (deleted.count(occurrence)) continue;
+				LLVMPositionBuilderBefore(builder, LLVMGetNextInstruction(occurrence));
+				LLVMBuildStore(builder, occurrence, exprs[e].temp);
+			}
+		}
+
+		int numInserted = 0;
+		for (auto& insertion : insertions) {
+			LLVMBasicBlockRef pred = insertion.first.first;
+			LLVMBasicBlockRef succ = insertion.first.second;
+
+			// Insert at the end of the predecessor or the start of the successor when that is equivalent
+			// to the edge, otherwise split the edge
+			if (getSuccessors(pred).size() == 1) {
+				LLVMPositionBuilderBefore(builder, LLVMGetBasicBlockTerminator(pred));
+			} else if (preds[succ].size() == 1) {
+				LLVMPositionBuilderBefore(builder, firstNonPhi(succ));
+			} else {
+				LLVMPositionBuilderBefore(builder, LLVMGetBasicBlockTerminator(splitEdge(pred, succ)));
+			}
+
+			for (int e : insertion.second) {
+				LLVMValueRef value = preMaterialize(builder, exprs, e);
+				LLVMBuildStore(builder, value, exprs[e].temp);
+				numInserted++;
+			}
+		}
+
+		for (LLVMValueRef inst : toDelete) {
+			int e = instExpr[inst];
+			LLVMPositionBuilderBefore(builder, inst);
+			LLVMValueRef reload = LLVMBuildLoad2(builder, exprs[e].type, exprs[e].temp, "");
+			LLVMReplaceAllUsesWith(inst, reload);
+			if (TRACING(TRACE_CHANGES)) {
+				printf("Partially redundant expression:\n");
+				LLVMDumpValue(inst);
+				printf("\n replaced by:\n");
+				LLVMDumpValue(reload);
+				printf("\n");
+			}
+			LLVMInstructionEraseFromParent(inst);
+		}
+
+		LLVMDisposeBuilder(builder);
+		changed = true;
+		markFunctionChanged(function);
+
+		countStatistic("computations inserted", numInserted);
+		countStatistic("computations deleted", toDelete.size());
+		if (TRACING(TRACE_PASSES)) {
+			printf("Partial redundancy elimination in %s: %d computations inserted, %zu deleted\n",
+				LLVMGetValueName(function), numInserted, toDelete.size());
+		}
+ 	}
+
+	if (changed) return 1; // Indicate that we made changes
+	else return 0; // No changes made
+}
+
+// ---- Call graph ----
+
+bool isDefinedFunction(LLVMValueRef value) {
+	return value != NULL && LLVMIsAFunction(value) && !LLVMIsDeclaration(value);
+}
+
+// The function a call instruction calls directly, or NULL for indirect calls and calls
+// whose type does not match the callee (e.g. a call through a K&R `int read()` declaration)
+LLVMValueRef getCalledFunction(LLVMValueRef call) {
+	LLVMValueRef callee = LLVMGetCalledValue(call);
+	if (!LLVMIsAFunction(callee)) return NULL;
+	if (LLVMGetCalledFunctionType(call) != LLVMGlobalGetValueType(callee)) return NULL;
+	return callee;
+}
+
+unsigned countInstructions(LLVMValueRef function) {
+	unsigned count = 0;
+	for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+		for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+			count++;
+		}
+	}
+	return count;
+}
+
+unsigned countInstructions(LLVMModuleRef module) {
+	unsigned count = 0;
+	for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+		count += countInstructions(function);
+	}
+	return count;
+}
+
+struct CallGraph {
+	vector<LLVMValueRef> functions;                            // defined functions, in module order
+	unordered_map<LLVMValueRef, vector<LLVMValueRef>> callees; // distinct defined callees of each function
+};
+
+CallGraph buildCallGraph(LLVMModuleRef module) {
+	CallGraph graph;
+	for (LLVMValueRef function =  LLVMGetFirstFunction(module); 
+			function; 
+			function = LLVMGetNextFunction(function)) {
+
+		if (!isDefinedFunction(function)) continue;
+		graph.functions.push_back(function);
+
+		vector<LLVMValueRef>& callees = graph.callees[function];
+		for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+			for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+				if (!LLVMIsACallInst(inst)) continue;
+				LLVMValueRef callee = getCalledFunction(inst);
+				if (isDefinedFunction(callee) && find(callees.begin(), callees.end(), callee) == callees.end()) {
+					callees.push_back(callee);
+				}
+			}
+		}
+	}
+	return graph;
+}
+
+// Tarjan's algorithm. An SCC is completed only after every SCC reachable from it, so the
+// result is bottom-up: callees come before their callers.
+void tarjanVisit(LLVMValueRef function, CallGraph& graph, unordered_map<LLVMValueRef, int>& index,
+		unordered_map<LLVMValueRef, int>& lowlink, vector<LLVMValueRef>& stack,
+		unordered_set<LLVMValueRef>& onStack, vector<vector<LLVMValueRef>>& sccs) {
+	int id = index.size();
+	index[function] = id;
+	lowlink[function] = id;
+	stack.push_back(function);
+	onStack.insert(function);
+
+	for (LLVMValueRef callee : graph.callees[function]) {
+		if (!index.count(callee)) {
+			tarjanVisit(callee, graph, index, lowlink, stack, onStack, sccs);
+			lowlink[function] = min(lowlink[function], lowlink[callee]);
+		} else if (onStack.count(callee)) {
+			lowlink[function] = min(lowlink[function], index[callee]);
+		}
+	}
+
+	if (lowlink[function] == index[function]) {
+		vector<LLVMValueRef> scc;
+		LLVMValueRef member;
+		do {
+			member = stack.back();
+			stack.pop_back();
+			onStack.erase(member);
+			scc.push_back(member);
+		} while (member != function);
+		sccs.push_back(scc);
+	}
+}
+
+vector<vector<LLVMValueRef>> callGraphSCCs(CallGraph& graph) {
+	unordered_map<LLVMValueRef, int> index, lowlink;
+	vector<LLVMValueRef> stack;
+	unordered_set<LLVMValueRef> onStack;
+	vector<vector<LLVMValueRef>> sccs;
+
+	for (LLVMValueRef function : graph.functions) {
+		if (!index.count(function)) {
+			tarjanVisit(function, graph, index, lowlink, stack, onStack, sccs);
+		}
+	}
+	return sccs;
+}
+
+// ---- Compile-time evaluation ----
+
+// A call whose result and output are fully determined at compile time is run by an interpreter for the IR,
+// and replaced by the print calls it made followed by its return value. Arguments that are not constants
+// are unknown to the interpreter; so are the variables they are stored into, and using an unknown value for
+// anything but copying it gives up. A function that never needs its parameters at all gets its whole body
+// replaced by the straight-line sequence. Calls to read() (or any function besides print without a body)
+// also give up, as does running more than EVAL_STEP_BUDGET instructions, printing more than
+// EVAL_MAX_PRINTS values, or nesting calls deeper than EVAL_MAX_DEPTH; the code is then left to the other passes.
+
+#define EVAL_STEP_BUDGET 200000 // instructions one evaluation may run
+#define EVAL_MAX_PRINTS 64      // longest print sequence emitted in place of the code
+#define EVAL_MAX_DEPTH 64       // nested calls
+
+struct EvalFrame {
+	unordered_map<LLVMValueRef, uint64_t> values; // known instruction results and parameters, zero-extended
+	unordered_map<LLVMValueRef, uint64_t> memory; // allocas of the function holding a known value
+};
+
+struct Evaluation {
+	long steps;
+	int depth;
+	vector<pair<LLVMValueRef, LLVMValueRef>> prints; // (print function, constant argument) in order
+};
+
+bool isPrintFunction(LLVMValueRef function) {
+	return function && !isDefinedFunction(function) && string(LLVMGetValueName(function)) == "print";
+}
+
+uint64_t truncateBits(uint64_t bits, unsigned width) {
+	return width >= 64 ? bits : bits & ((1ULL << width) - 1);
+}
+
+long long signedBits(uint64_t bits, unsigned width) {
+	if (width < 64 && (bits >> (width - 1)) & 1) bits |= ~0ULL << width;
+	return (long long)bits;
+}
+
+bool knownValue(EvalFrame& frame, LLVMValueRef value, uint64_t& bits) {
+	if (LLVMIsAConstantInt(value)) {
+		if (LLVMGetIntTypeWidth(LLVMTypeOf(value)) > 64) return false;
+		bits = LLVMConstIntGetZExtValue(value);
+		return true;
+	}
+	auto it = frame.values.find(value);
+	if (it == frame.values.end()) return false;
+	bits = it->second;
+	return true;
+}
+
+// Integer arithmetic, comparisons, selects and casts; false when an operand is unknown or the result undefined
+bool evaluatePure(EvalFrame& frame, LLVMValueRef inst, uint64_t& result) {
+	LLVMTypeRef type = LLVMTypeOf(inst);
+	if (LLVMGetTypeKind(type) != LLVMIntegerTypeKind || LLVMGetIntTypeWidth(type) > 64) return false;
+	unsigned width = LLVMGetIntTypeWidth(type);
+	LLVMOpcode opcode = LLVMGetInstructionOpcode(inst);
+
+	if (opcode == LLVMSelect) {
+		uint64_t cond, value;
+		if (!knownValue(frame, LLVMGetOperand(inst, 0), cond)) return false;
+		if (!knownValue(frame, LLVMGetOperand(inst, cond ? 1 : 2), value)) return false;
+		result = value;
+		return true;
+	}
+
+	uint64_t a, b = 0;
+	if (LLVMGetNumOperands(inst) < 1 || !knownValue(frame, LLVMGetOperand(inst, 0), a)) return false;
+	unsigned inWidth = LLVMGetIntTypeWidth(LLVMTypeOf(LLVMGetOperand(inst, 0)));
+	if (opcode == LLVMZExt || opcode == LLVMTrunc) {
+		result = truncateBits(a, width);
+		return true;
+	}
+	if (opcode == LLVMSExt) {
+		result = truncateBits(signedBits(a, inWidth), width);
+		return true;
+	}
+
+	if (LLVMGetNumOperands(inst) < 2 || !knownValue(frame, LLVMGetOperand(inst, 1), b)) return false;
+	long long sa = signedBits(a, inWidth), sb = signedBits(b, inWidth);
+	if (opcode == LLVMICmp) {
+		bool holds;
+		switch (LLVMGetICmpPredicate(inst)) {
+			case LLVMIntEQ: holds = a == b; break;
+			case LLVMIntNE: holds = a != b; break;
+			case LLVMIntSLT: holds = sa < sb; break;
+			case LLVMIntSLE: holds = sa <= sb; break;
+			case LLVMIntSGT: holds = sa > sb; break;
+			case LLVMIntSGE: holds = sa >= sb; break;
+			case LLVMIntULT: holds = a < b; break;
+			case LLVMIntULE: holds = a <= b; break;
+			case LLVMIntUGT: holds = a > b; break;
+			default: holds = a >= b; break; // LLVMIntUGE
+		}
+		result = holds;
+		return true;
+	}
+
+	long long minimum = signedBits(1ULL << (width - 1), width);
+	switch (opcode) {
+		case LLVMAdd: result = a + b; break;
+		case LLVMSub: result = a - b; break;
+		case LLVMMul: result = a * b; break;
+		case LLVMAnd: result = a & b; break;
+		case LLVMOr: result = a | b; break;
+		case LLVMXor: result = a ^ b; break;
+		case LLVMSDiv:
+		case LLVMSRem:
+			if (sb == 0 || (sa == minimum && sb == -1)) return false;
+			result = opcode == LLVMSDiv ? sa / sb : sa % sb;
+			break;
+		case LLVMUDiv:
+		case LLVMURem:
+			if (b == 0) return false;
+			result = opcode == LLVMUDiv ? a / b : a % b;
+			break;
+		case LLVMShl:
+		case LLVMLShr:
+		case LLVMAShr:
+			if (b >= width) return false;
+			result = opcode == LLVMShl ? a << b : opcode == LLVMLShr ? a >> b : (uint64_t)(sa >> b);
+			break;
+		default:
+			return false;
+	}
+	result = truncateBits(result, width);
+	return true;
+}
+
+// Runs function on args (NULL for unknown arguments); on success result holds the return value, if any
+bool evaluateCall(Evaluation& evaluation, LLVMValueRef function, vector<LLVMValueRef>& args, uint64_t& result) {
+	if (evaluation.depth >= EVAL_MAX_DEPTH) return false;
+	evaluation.depth++;
+
+	EvalFrame frame;
+	for (unsigned i = 0; i < args.size(); i++) {
+		uint64_t bits;
+		if (args[i] && knownValue(frame, args[i], bits)) frame.values[LLVMGetParam(function, i)] = bits;
+	}
+
+	LLVMBasicBlockRef bb = LLVMGetEntryBasicBlock(function);
+	LLVMBasicBlockRef prev = NULL;
+	while (true) {
+		// Phis all read the values from the edge just taken, before any of them changes
+		vector<pair<LLVMValueRef, LLVMValueRef>> incoming;
+		for (LLVMValueRef phi = LLVMGetFirstInstruction(bb); phi && LLVMIsAPHINode(phi); phi = LLVMGetNextInstruction(phi)) {
+			unsigned numIncoming = LLVMCountIncoming(phi);
+			for (unsigned i = 0; i < numIncoming; i++) {
+				if (LLVMGetIncomingBlock(phi, i) == prev) incoming.push_back(make_pair(phi, LLVMGetIncomingValue(phi, i)));
+			}
+		}
+		unordered_map<LLVMValueRef, uint64_t> phiValues;
+		for (auto& entry : incoming) {
+			uint64_t bits;
+			if (knownValue(frame, entry.second, bits)) phiValues[entry.first] = bits;
+		}
+		for (auto& entry : incoming) {
+			auto it = phiValues.find(entry.first);
+			if (it != phiValues.end()) frame.values[entry.first] = it->second;
+			else frame.values.erase(entry.first);
+		}
+
+		LLVMBasicBlockRef next = NULL;
+		for (LLVMValueRef inst = firstNonPhi(bb); inst && next == NULL; inst = LLVMGetNextInstruction(inst)) {
+			if (++evaluation.steps > EVAL_STEP_BUDGET) return false;
+			LLVMOpcode opcode = LLVMGetInstructionOpcode(inst);
+			uint64_t bits;
+
+			if (opcode == LLVMAlloca) continue;
+			if (opcode == LLVMStore || opcode == LLVMLoad) {
+				LLVMValueRef address = LLVMGetOperand(inst, opcode == LLVMStore ? 1 : 0);
+				if (!LLVMIsAAllocaInst(address)) return false;
+				if (opcode == LLVMStore) {
+					if (knownValue(frame, LLVMGetOperand(inst, 0), bits)) frame.memory[address] = bits;
+					else frame.memory.erase(address);
+				} else {
+					auto it = frame.memory.find(address);
+					if (it != frame.memory.end()) frame.values[inst] = it->second;
+					else frame.values.erase(inst);
+				}
+				continue;
+			}
+			if (opcode == LLVMBr) {
+				if (!LLVMIsConditional(inst)) {
+					next = LLVMGetSuccessor(inst, 0);
+				} else {
+					if (!knownValue(frame, LLVMGetCondition(inst), bits)) return false;
+					next = LLVMGetSuccessor(inst, bits ? 0 : 1);
+				}
+				continue;
+			}
+			if (opcode == LLVMRet) {
+				if (LLVMGetNumOperands(inst) > 0 && !knownValue(frame, LLVMGetOperand(inst, 0), result)) return false;
+				evaluation.depth--;
+				return true;
+			}
+			if (opcode == LLVMCall) {
+				LLVMValueRef callee = getCalledFunction(inst);
+				if (isPrintFunction(callee) && LLVMGetNumArgOperands(inst) == 1) {
+					LLVMValueRef arg = LLVMGetArgOperand(inst, 0);
+					if (!knownValue(frame, arg, bits) || evaluation.prints.size() >= EVAL_MAX_PRINTS) return false;
+					evaluation.prints.push_back(make_pair(callee, LLVMConstInt(LLVMTypeOf(arg), bits, 0)));
+					continue;
+				}
+				if (!isDefinedFunction(callee)) return false;
+
+				vector<LLVMValueRef> calleeArgs;
+				unsigned numArgs = LLVMGetNumArgOperands(inst);
+				for (unsigned i = 0; i < numArgs; i++) {
+					LLVMValueRef arg = LLVMGetArgOperand(inst, i);
+					bool known = LLVMGetTypeKind(LLVMTypeOf(arg)) == LLVMIntegerTypeKind && knownValue(frame, arg, bits);
+					calleeArgs.push_back(known ? LLVMConstInt(LLVMTypeOf(arg), bits, 0) : NULL);
+				}
+				if (!evaluateCall(evaluation, callee, calleeArgs, bits)) return false;
+				if (LLVMGetTypeKind(LLVMTypeOf(inst)) != LLVMVoidTypeKind) frame.values[inst] = bits;
+				continue;
+			}
+			if (!evaluatePure(frame, inst, bits)) return false;
+			frame.values[inst] = bits;
+		}
+		if (next == NULL) return false; // Fell off a block without a branch we understand
+		prev = bb;
+		bb = next;
+	}
+}
+
+// Puts the print calls of evaluation before builder's position
+void emitPrints(LLVMBuilderRef builder, Evaluation& evaluation) {
+	for (auto& print : evaluation.prints) {
+		LLVMValueRef arg = print.second;
+		LLVMBuildCall2(builder, LLVMGlobalGetValueType(print.first), print.first, &arg, 1, "");
+	}
+}
+
+int compileTimeEvaluation(LLVMModuleRef module) {
+	int numEvaluated = 0;
+	LLVMBuilderRef builder = LLVMCreateBuilderInContext(LLVMGetModuleContext(module));
+
+	// Calls that can be run now
+	for (LLVMValueRef function =  LLVMGetFirstFunction(module); 
+			function; 
+			function = LLVMGetNextFunction(function)) {
+
+		for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+			LLVMValueRef inst = LLVMGetFirstInstruction(bb);
+			while (inst) {
+				LLVMValueRef next = LLVMGetNextInstruction(inst);
+				LLVMValueRef callee = LLVMIsACallInst(inst) ? getCalledFunction(inst) : NULL;
+				if (!isDefinedFunction(callee)) {
+					inst = next;
+					continue;
+				}
+
+				vector<LLVMValueRef> args;
+				unsigned numArgs = LLVMGetNumArgOperands(inst);
+				for (unsigned i = 0; i < numArgs; i++) {
+					LLVMValueRef arg = LLVMGetArgOperand(inst, i);
+					args.push_back(LLVMIsAConstantInt(arg) ? arg : NULL);
+				}
+				Evaluation evaluation = { 0, 0, {} };
+				uint64_t result;
+				if (evaluateCall(evaluation, callee, args, result)) {
+					if (TRACING(TRACE_CHANGES)) {
+						printf("Evaluated call (%zu prints):\n", evaluation.prints.size());
+						LLVMDumpValue(inst);
+						printf("\n");
+					}
+					LLVMPositionBuilderBefore(builder, inst);
+					emitPrints(builder, evaluation);
+					LLVMTypeRef type = LLVMTypeOf(inst);
+					if (LLVMGetTypeKind(type) != LLVMVoidTypeKind) LLVMReplaceAllUsesWith(inst, LLVMConstInt(type, result, 0));
+					LLVMInstructionEraseFromParent(inst);
+					numEvaluated++;
+				}
+				inst = next;
+			}
+		}
+	}
+
+	// Functions that do not need their parameters
+	for (LLVMValueRef function =  LLVMGetFirstFunction(module); 
+			function; 
+			function = LLVMGetNextFunction(function)) {
+
+		if (!isDefinedFunction(function)) continue;
+
+		vector<LLVMValueRef> args(LLVMCountParams(function), NULL);
+		Evaluation evaluation = { 0, 0, {} };
+		uint64_t result;
+		if (!evaluateCall(evaluation, function, args, result)) continue;
+		if (countInstructions(function) == evaluation.prints.size() + 1) continue; // Already straight-line
+
+		if (TRACING(TRACE_CHANGES)) {
+			printf("Evaluated %s (%zu prints)\n", LLVMGetValueName(function), evaluation.prints.size());
+		}
+
+		// The new entry block leaves all others unreachable
+		LLVMBasicBlockRef body = LLVMInsertBasicBlockInContext(LLVMGetModuleContext(module),
+			LLVMGetEntryBasicBlock(function), "");
+		LLVMPositionBuilderAtEnd(builder, body);
+		emitPrints(builder, evaluation);
+		LLVMTypeRef returnType = LLVMGetReturnType(LLVMGlobalGetValueType(function));
+		if (LLVMGetTypeKind(returnType) == LLVMVoidTypeKind) LLVMBuildRetVoid(builder);
+		else LLVMBuildRet(builder, LLVMConstInt(returnType, result, 0));
+		deleteUnreachableBlocks(function);
+		numEvaluated++;
+	}
+
+	LLVMDisposeBuilder(builder);
+
+	countStatistic("calls evaluated", numEvaluated);
+
+	if (numEvaluated > 0) markModuleChanged();
+
+	if (numEvaluated > 0) return 1; // Indicate that we made changes
+	else return 0; // No changes made
+}
+
+// ---- Function inlining ----
+
+// Call sites are visited bottom-up over the SCCs of the call graph, so a callee has already had its own calls
+// inlined and been cleaned up by the local passes before its size is compared against the budget. Calls within
+// an SCC (recursion) are never inlined. The noinline/optnone attributes clang -O0 puts on every function are
+// ignored, like in every other pass.
+
+#define INLINE_THRESHOLD 60      // largest callee (in instructions) that gets inlined
+#define INLINE_CALLER_LIMIT 2000 // no more inlining into a caller that has grown past this size
+
+// Replaces a direct call by a copy of the callee's body
+void inlineCall(LLVMValueRef call) {
+	LLVMValueRef callee = getCalledFunction(call);
+	LLVMBasicBlockRef callBlock = LLVMGetInstructionParent(call);
+	LLVMValueRef caller = LLVMGetBasicBlockParent(callBlock);
+	LLVMContextRef context = blockContext(callBlock);
+	LLVMBuilderRef builder = LLVMCreateBuilderInContext(context);
+
+	// Everything after the call moves to a new block that the inlined returns branch to
+	LLVMBasicBlockRef after = LLVMAppendBasicBlockInContext(context, caller, "");
+	LLVMMoveBasicBlockAfter(after, callBlock);
+	LLVMPositionBuilderAtEnd(builder, after);
+	for (LLVMValueRef inst = LLVMGetNextInstruction(call); inst; ) {
+		LLVMValueRef next = LLVMGetNextInstruction(inst);
+		moveInstruction(builder, inst);
+		inst = next;
+	}
+	for (LLVMBasicBlockRef succ : getSuccessors(after)) {
+		replacePhiIncomingBlock(succ, callBlock, after);
+	}
+
+	unordered_map<LLVMValueRef, LLVMValueRef> valueMap; // callee values -> caller values
+	unsigned numParams = LLVMCountParams(callee);
+	for (unsigned i = 0; i < numParams; i++) {
+		valueMap[LLVMGetParam(callee, i)] = LLVMGetArgOperand(call, i);
+	}
+
+	vector<LLVMBasicBlockRef> calleeBlocks;
+	for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(callee); bb; bb = LLVMGetNextBasicBlock(bb)) {
+		calleeBlocks.push_back(bb);
+	}
+	vector<LLVMBasicBlockRef> copies = copyBlocks(calleeBlocks, caller, after, valueMap);
+
+	// Returns become branches to the rest of the caller
+	vector<pair<LLVMValueRef, LLVMBasicBlockRef>> returns; // (returned value, block)
+	for (LLVMBasicBlockRef copy : copies) {
+		LLVMValueRef terminator = LLVMGetBasicBlockTerminator(copy);
+		if (!LLVMIsAReturnInst(terminator)) continue;
+
+		returns.push_back(make_pair(LLVMGetNumOperands(terminator) ? LLVMGetOperand(terminator, 0) : NULL, copy));
+		LLVMInstructionEraseFromParent(terminator);
+		LLVMPositionBuilderAtEnd(builder, copy);
+		LLVMBuildBr(builder, after);
+	}
+
+	// Fixed-size allocas of the callee's entry block move to the caller's entry block
+	LLVMBasicBlockRef calleeEntryCopy = copies[0];
+	LLVMPositionBuilderBefore(builder, LLVMGetFirstInstruction(LLVMGetEntryBasicBlock(caller)));
+	for (LLVMValueRef inst = LLVMGetFirstInstruction(calleeEntryCopy); inst; ) {
+		LLVMValueRef next = LLVMGetNextInstruction(inst);
+		if (LLVMIsAAllocaInst(inst) && LLVMIsAConstant(LLVMGetOperand(inst, 0))) {
+			moveInstruction(builder, inst);
+		}
+		inst = next;
+	}
+
+	LLVMPositionBuilderAtEnd(builder, callBlock);
+	LLVMBuildBr(builder, calleeEntryCopy);
+
+	// The call's result is the returned value, merged with a phi when there are several returns
+	if (LLVMGetTypeKind(LLVMTypeOf(call)) != LLVMVoidTypeKind) {
+		LLVMValueRef result;
+		if (returns.empty()) {
+			result = LLVMGetUndef(LLVMTypeOf(call));
+		} else if (returns.size() == 1) {
+			result = returns[0].first;
+		} else {
+			LLVMPositionBuilderBefore(builder, LLVMGetFirstInstruction(after));
+			result = LLVMBuildPhi(builder, LLVMTypeOf(call), "");
+			for (auto& ret : returns) {
+				LLVMAddIncoming(result, &ret.first, &ret.second, 1);
+			}
+		}
+		LLVMReplaceAllUsesWith(call, result);
+	}
+	LLVMInstructionEraseFromParent(call);
+	LLVMDisposeBuilder(builder);
+
+	// Drop the branches that glue the copied body in when they are straight-line
+	mergeIntoPredecessor(after);
+	mergeIntoPredecessor(calleeEntryCopy);
+}
+
+int functionInlining(LLVMModuleRef module) {
+	CallGraph graph = buildCallGraph(module);
+	vector<vector<LLVMValueRef>> sccs = callGraphSCCs(graph);
+
+	unsigned sizeBefore = countInstructions(module);
+	int numInlined = 0;
+	unordered_set<LLVMValueRef> inlinedFrom;
+
+	for (vector<LLVMValueRef>& scc : sccs) {
+		unordered_set<LLVMValueRef> inSCC(scc.begin(), scc.end());
+
+		for (LLVMValueRef caller : scc) {
+			vector<LLVMValueRef> calls;
+			for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(caller); bb; bb = LLVMGetNextBasicBlock(bb)) {
+				for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+					if (!LLVMIsACallInst(inst)) continue;
+					LLVMValueRef callee = getCalledFunction(inst);
+					if (isDefinedFunction(callee) && !inSCC.count(callee)
+							&& !LLVMIsFunctionVarArg(LLVMGlobalGetValueType(callee))) {
+						calls.push_back(inst);
+					}
+				}
+			}
+
+			bool callerChanged = false;
+			for (LLVMValueRef call : calls) {
+				LLVMValueRef callee = getCalledFunction(call);
+				unsigned calleeSize = countInstructions(callee);
+				unsigned callerSize = countInstructions(caller);
+				if (calleeSize > INLINE_THRESHOLD || callerSize + calleeSize > INLINE_CALLER_LIMIT) {
+					continue;
+				}
+
+				if (TRACING(TRACE_CHANGES)) {
+					printf("Inlining call to %s (%u instructions) into %s (%u instructions)\n",
+						LLVMGetValueName(callee), calleeSize, LLVMGetValueName(caller), callerSize);
+				}
+				inlineCall(call);
+				inlinedFrom.insert(callee);
+				numInlined++;
+				callerChanged = true;
+			}
+
+			// Clean up the inlined bodies before this function is itself considered for inlining. The
+			// cleanup visits every block: the record of the inliner is no record of what they have done.
+			if (callerChanged) {
+				CleanRecord* inlinerRecord = passCleanRecord;
+				passCleanRecord = NULL;
+				int localChanged = 1;
+				while (localChanged) {
+					localChanged = constantFoldingInFunction(caller);
+					localChanged |= subexprEliminationInFunction(caller);
+					localChanged |= deadcodeEliminationInFunction(caller);
+				}
+				passCleanRecord = inlinerRecord;
+			}
+		}
+	}
+
+	// Internal functions whose every call site was inlined (e.g. specialized copies) are dead
+	for (LLVMValueRef function : graph.functions) {
+		LLVMLinkage linkage = LLVMGetLinkage(function);
+		if ((linkage == LLVMInternalLinkage || linkage == LLVMPrivateLinkage) && LLVMGetFirstUse(function) == NULL
+				&& inlinedFrom.count(function)) {
+			LLVMDeleteFunction(function);
+		}
+	}
+
+	unsigned sizeAfter = countInstructions(module);
+	if (TRACING(TRACE_PASSES)) {
+		printf("Inlined %d call sites, module size %u -> %u instructions (%+d)\n",
+			numInlined, sizeBefore, sizeAfter, (int)sizeAfter - (int)sizeBefore);
+	}
+
+	countStatistic("calls inlined", numInlined);
+
+	if (numInlined > 0) markModuleChanged();
+
+	if (numInlined > 0) return 1; // Indicate that we made changes
+	else return 0; // No changes made
+}
+
+// ---- Interprocedural constant propagation and specialization ----
+
+// A parameter that receives the same constant at every call site is replaced by that constant in the body. This
+// needs every call site to be known, so it is only done for functions with internal linkage whose address is
+// never taken. Other call sites that pass constants get a specialized copy of the callee with the constants
+// substituted. The hottest call sites (deepest in loops) are specialized first, as long as the copies fit in
+// SPECIALIZE_BUDGET instructions; call sites passing the same constants to the same callee share one copy.
+
+#define SPECIALIZE_BUDGET 400   // total instructions the module may grow by through specialized copies
+#define SPECIALIZE_MAX_SIZE 200 // largest function that gets specialized
+
+// Collects the direct calls to function. Fails when the function is used in any other way.
+bool collectCallSites(LLVMValueRef function, vector<LLVMValueRef>& calls) {
+	for (LLVMUseRef use = LLVMGetFirstUse(function); use; use = LLVMGetNextUse(use)) {
+		LLVMValueRef user = LLVMGetUser(use);
+		if (!LLVMIsACallInst(user) || getCalledFunction(user) != function) return false;
+
+		unsigned numArgs = LLVMGetNumArgOperands(user);
+		for (unsigned i = 0; i < numArgs; i++) {
+			if (LLVMGetArgOperand(user, i) == function) return false;
+		}
+		if (find(calls.begin(), calls.end(), user) == calls.end()) {
+			calls.push_back(user);
+		}
+	}
+	return true;
+}
+
+// Copies function into a new internal function in which the constant arguments of call are substituted
+// for the parameters. The copy keeps the signature, so the call only needs its callee replaced.
+LLVMValueRef specializeFunction(LLVMValueRef function, LLVMValueRef call) {
+	LLVMModuleRef module = LLVMGetGlobalParent(function);
+	unsigned numParams = LLVMCountParams(function);
+
+	string name = valueName(function) + ".spec";
+	for (unsigned i = 0; i < numParams; i++) {
+		LLVMValueRef arg = LLVMGetArgOperand(call, i);
+		name += LLVMIsAConstantInt(arg) ? "." + to_string(LLVMConstIntGetSExtValue(arg)) : ".x";
+	}
+	LLVMValueRef clone = LLVMAddFunction(module, name.c_str(), LLVMGlobalGetValueType(function));
+	LLVMSetLinkage(clone, LLVMInternalLinkage);
+
+	// Function, return and parameter attributes
+	for (int index = -1; index <= (int)numParams; index++) {
+		unsigned count = LLVMGetAttributeCountAtIndex(function, index);
+		vector<LLVMAttributeRef> attrs(count);
+		if (count) LLVMGetAttributesAtIndex(function, index, attrs.data());
+		for (LLVMAttributeRef attr : attrs) {
+			LLVMAddAttributeAtIndex(clone, index, attr);
+		}
+	}
+
+	unordered_map<LLVMValueRef, LLVMValueRef> valueMap;
+	for (unsigned i = 0; i < numParams; i++) {
+		LLVMValueRef arg = LLVMGetArgOperand(call, i);
+		valueMap[LLVMGetParam(function, i)] = LLVMIsAConstantInt(arg) ? arg : LLVMGetParam(clone, i);
+	}
+	vector<LLVMBasicBlockRef> blocks;
+	for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+		blocks.push_back(bb);
+	}
+	copyBlocks(blocks, clone, NULL, valueMap);
+
+	return clone;
+}
+
+struct SpecializationCandidate {
+	LLVMValueRef call;
+	LLVMValueRef callee;
+	int depth; // loop depth of the call site
+};
+
+int interproceduralConstantPropagation(LLVMModuleRef module) {
+	int numPropagated = 0;
+
+	// Parameters that are the same constant at every call site
+	for (LLVMValueRef function =  LLVMGetFirstFunction(module); 
+			function; 
+			function = LLVMGetNextFunction(function)) {
+
+		LLVMLinkage linkage = LLVMGetLinkage(function);
+		if (!isDefinedFunction(function) || (linkage != LLVMInternalLinkage && linkage != LLVMPrivateLinkage)) continue;
+
+		vector<LLVMValueRef> calls;
+		if (!collectCallSites(function, calls) || calls.empty()) continue;
+
+		unsigned numParams = LLVMCountParams(function);
+		for (unsigned i = 0; i < numParams; i++) {
+			LLVMValueRef param = LLVMGetParam(function, i);
+			LLVMValueRef value = LLVMGetArgOperand(calls[0], i);
+			if (LLVMGetFirstUse(param) == NULL || !LLVMIsAConstantInt(value)) continue;
+
+			bool sameEverywhere = true;
+			for (LLVMValueRef call : calls) {
+				if (LLVMGetArgOperand(call, i) != value) {
+					sameEverywhere = false;
+					break;
+				}
+			}
+			if (sameEverywhere) {
+				LLVMReplaceAllUsesWith(param, value);
+				numPropagated++;
+				if (TRACING(TRACE_CHANGES)) {
+					printf("Parameter %u of %s is always:\n", i, LLVMGetValueName(function));
+					LLVMDumpValue(value);
+					printf("\n");
+				}
+			}
+		}
+	}
+
+	// Remaining call sites with useful constant arguments
+	vector<SpecializationCandidate> candidates;
+	for (LLVMValueRef caller =  LLVMGetFirstFunction(module); 
+			caller; 
+			caller = LLVMGetNextFunction(caller)) {
+
+		if (!isDefinedFunction(caller)) continue;
+		vector<Loop>& loops = cachedLoops(caller);
+
+		for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(caller); bb; bb = LLVMGetNextBasicBlock(bb)) {
+			for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+				if (!LLVMIsACallInst(inst)) continue;
+				LLVMValueRef callee = getCalledFunction(inst);
+				if (!isDefinedFunction(callee) || LLVMIsFunctionVarArg(LLVMGlobalGetValueType(callee))
+						|| countInstructions(callee) > SPECIALIZE_MAX_SIZE) {
+					continue;
+				}
+
+				unsigned numParams = LLVMCountParams(callee);
+				for (unsigned i = 0; i < numParams; i++) {
+					if (LLVMIsAConstantInt(LLVMGetArgOperand(inst, i)) && LLVMGetFirstUse(LLVMGetParam(callee, i))) {
+						SpecializationCandidate candidate = { inst, callee, loopDepth(loops, bb) };
+						candidates.push_back(candidate);
+						break;
+					}
+				}
+			}
+		}
+	}
+	stable_sort(candidates.begin(), candidates.end(), [](const SpecializationCandidate& a, const SpecializationCandidate& b) {
+		return a.depth > b.depth;
+	});
+
+	int numSpecialized = 0;
+	int numRetargeted = 0;
+	unsigned budgetUsed = 0;
+	unordered_map<string, LLVMValueRef> specializations; // callee and constant arguments -> copy
+	unordered_set<LLVMValueRef> specializedFrom;
+	for (SpecializationCandidate& candidate : candidates) {
+		string key = to_string((uintptr_t)candidate.callee);
+		unsigned numParams = LLVMCountParams(candidate.callee);
+		for (unsigned i = 0; i < numParams; i++) {
+			LLVMValueRef arg = LLVMGetArgOperand(candidate.call, i);
+			key += LLVMIsAConstantInt(arg) ? "," + to_string((uintptr_t)arg) : ",x";
+		}
+
+		LLVMValueRef clone;
+		auto it = specializations.find(key);
+		if (it != specializations.end()) {
+			clone = it->second;
+		} else {
+			unsigned size = countInstructions(candidate.callee);
+			if (budgetUsed + size > SPECIALIZE_BUDGET) continue;
+			budgetUsed += size;
+
+			clone = specializeFunction(candidate.callee, candidate.call);
+			specializations[key] = clone;
+			specializedFrom.insert(candidate.callee);
+			numSpecialized++;
+			if (TRACING(TRACE_CHANGES)) {
+				printf("Specialized %s into %s for call site at loop depth %d\n",
+					LLVMGetValueName(candidate.callee), LLVMGetValueName(clone), candidate.depth);
+			}
+		}
+
+		// The called function is the last operand of a call
+		LLVMSetOperand(candidate.call, LLVMGetNumOperands(candidate.call) - 1, clone);
+		numRetargeted++;
+	}
+
+	// Internal functions whose every call site now goes to a copy
+	for (LLVMValueRef function : specializedFrom) {
+		LLVMLinkage linkage = LLVMGetLinkage(function);
+		if ((linkage == LLVMInternalLinkage || linkage == LLVMPrivateLinkage) && LLVMGetFirstUse(function) == NULL) {
+			LLVMDeleteFunction(function);
+		}
+	}
+
+	if (TRACING(TRACE_PASSES)) {
+		printf("Interprocedural constant propagation: %d parameters replaced, %d call sites moved to %d specialized copies (%u instructions)\n",
+			numPropagated, numRetargeted, numSpecialized, budgetUsed);
+	}
+	countStatistic("parameters propagated", numPropagated);
+	countStatistic("call sites specialized", numRetargeted);
+
+	if (numPropagated > 0 || numRetargeted > 0) markModuleChanged();
+
+	if (numPropagated > 0 || numRetargeted > 0) return 1; // Indicate that we made changes
+	else return 0; // No changes made
+}
+
+// ---- Reassociation ----
+
+// Trees of the associative and commutative add and mul are flattened into their leaf operands and rebuilt as
+// a left-leaning chain. The leaves are sorted by rank (arguments first, then instructions in reverse post-order)
+// and every constant leaf is combined into a single operand at the end of the chain, so a = b + 1; c = a + 2;
+// computes c as b + 3. Two sums of the same values also end up with the same operands in the same order, which
+// is what subexprElimination compares.
+//
+// Only single-use operands from the root's block are absorbed into the tree, so no shared value is computed
+// twice. A shared "x op C" leaf, including one read back from a local variable stored earlier in the same
+// block, is replaced by x and C only when the tree has another constant to combine C with, which keeps the
+// instruction count from growing.
+
+struct ReassociationTree {
+	LLVMOpcode opcode;
+	vector<LLVMValueRef> leaves; // non-constant operands
+	LLVMValueRef constant;       // all constant operands combined, NULL when there are none
+	int numConstants;            // constant operands before combining
+	bool rewritesSub;            // an add tree absorbed a "x - C"
+};
+
+// Value last stored to a local variable above load in the same block, or NULL
+LLVMValueRef forwardedStoreValue(LLVMValueRef load) {
+	LLVMValueRef address = LLVMGetOperand(load, 0);
+	if (!LLVMIsAAllocaInst(address) || !isLocalVariable(address)) return NULL;
+
+	for (LLVMValueRef inst = LLVMGetPreviousInstruction(load); inst; inst = LLVMGetPreviousInstruction(inst)) {
+		if (LLVMIsAStoreInst(inst) && LLVMGetOperand(inst, 1) == address) return LLVMGetOperand(inst, 0);
+	}
+	return NULL;
+}
+
+void addTreeConstant(ReassociationTree& tree, LLVMValueRef constant) {
+	if (tree.constant == NULL) tree.constant = constant;
+	else if (tree.opcode == LLVMAdd) tree.constant = LLVMConstAdd(tree.constant, constant);
+	else tree.constant = LLVMConstMul(tree.constant, constant);
+	tree.numConstants++;
+}
+
+// Whether value is "x op C" (or "x - C" in an add tree) and can be split into x and a constant
+bool splitsIntoConstant(ReassociationTree& tree, LLVMValueRef value) {
+	if (!LLVMIsABinaryOperator(value)) return false;
+	LLVMOpcode opcode = LLVMGetInstructionOpcode(value);
+	if (opcode == LLVMSub) return tree.opcode == LLVMAdd && LLVMIsAConstantInt(LLVMGetOperand(value, 1));
+	return opcode == tree.opcode
+		&& (LLVMIsAConstantInt(LLVMGetOperand(value, 0)) || LLVMIsAConstantInt(LLVMGetOperand(value, 1)));
+}
+
+// Interior nodes are single-use operands of the same kind from the root's block
+bool isTreeNode(ReassociationTree& tree, LLVMValueRef value, LLVMBasicBlockRef block) {
+	if (!LLVMIsABinaryOperator(value) || LLVMGetInstructionParent(value) != block) return false;
+	LLVMUseRef use = LLVMGetFirstUse(value);
+	if (use == NULL || LLVMGetNextUse(use) != NULL) return false;
+	LLVMOpcode opcode = LLVMGetInstructionOpcode(value);
+	return opcode == tree.opcode || (opcode == LLVMSub && splitsIntoConstant(tree, value));
+}
+
+void collectTreeOperands(ReassociationTree& tree, LLVMValueRef value, LLVMBasicBlockRef block, bool isRoot) {
+	if (LLVMIsAConstantInt(value)) {
+		addTreeConstant(tree, value);
+		return;
+	}
+	if (!isRoot && !isTreeNode(tree, value, block)) {
+		tree.leaves.push_back(value);
+		return;
+	}
+	if (LLVMGetInstructionOpcode(value) == LLVMSub) {
+		tree.rewritesSub = true;
+		collectTreeOperands(tree, LLVMGetOperand(value, 0), block, false);
+		addTreeConstant(tree, LLVMConstNeg(LLVMGetOperand(value, 1)));
+		return;
+	}
+	collectTreeOperands(tree, LLVMGetOperand(value, 0), block, false);
+	collectTreeOperands(tree, LLVMGetOperand(value, 1), block, false);
+}
+
+int reassociationInFunction(LLVMValueRef function) {
+	int numRewritten = 0;
+	if (LLVMGetFirstBasicBlock(function) == NULL) return 0;
+
+	// Ranks: 0 for constants, arguments in order, then instructions in reverse post-order
+	unordered_map<LLVMValueRef, unsigned> rank;
+	unsigned nextRank = 1;
+	for (LLVMValueRef param = LLVMGetFirstParam(function); param; param = LLVMGetNextParam(param)) {
+		rank[param] = nextRank++;
+	}
+	vector<LLVMBasicBlockRef>& rpo = cachedReversePostOrder(function);
+	for (LLVMBasicBlockRef bb : rpo) {
+		for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+			rank[inst] = nextRank++;
+		}
+	}
+	auto rankOf = [&](LLVMValueRef value) {
+		auto it = rank.find(value);
+		return it == rank.end() ? 0u : it->second;
+	};
+
+	LLVMBuilderRef builder = LLVMCreateBuilderInContext(LLVMGetTypeContext(LLVMTypeOf(function)));
+
+	for (LLVMBasicBlockRef bb : rpo) {
+		// Roots are add/mul instructions that are not themselves interior nodes of a larger tree
+		vector<LLVMValueRef> roots;
+		for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+			if (!LLVMIsABinaryOperator(inst) || LLVMGetTypeKind(LLVMTypeOf(inst)) != LLVMIntegerTypeKind) continue;
+			LLVMOpcode opcode = LLVMGetInstructionOpcode(inst);
+			if (opcode != LLVMAdd && opcode != LLVMMul) continue;
+
+			LLVMUseRef use = LLVMGetFirstUse(inst);
+			if (use != NULL && LLVMGetNextUse(use) == NULL) {
+				LLVMValueRef user = LLVMGetUser(use);
+				if (LLVMIsABinaryOperator(user) && LLVMGetInstructionOpcode(user) == opcode
+					&& LLVMGetInstructionParent(user) == bb) continue;
+			}
+			roots.push_back(inst);
+		}
+
+		for (LLVMValueRef root : roots) {
+			ReassociationTree tree;
+			tree.opcode = LLVMGetInstructionOpcode(root);
+			tree.constant = NULL;
+			tree.numConstants = 0;
+			tree.rewritesSub = false;
+			collectTreeOperands(tree, root, bb, true);
+
+			// Look through shared "x op C" leaves when their constant has something to fold with
+			bool lookedThrough = false;
+			if (tree.constant != NULL) {
+				for (LLVMValueRef& leaf : tree.leaves) {
+					while (true) {
+						LLVMValueRef value = leaf;
+						if (LLVMIsALoadInst(value)) {
+							LLVMValueRef stored = forwardedStoreValue(value);
+							if (stored != NULL) value = stored;
+						}
+						if (!splitsIntoConstant(tree, value)) break;
+
+						LLVMValueRef op1 = LLVMGetOperand(value, 0);
+						LLVMValueRef op2 = LLVMGetOperand(value, 1);
+						if (LLVMGetInstructionOpcode(value) == LLVMSub) {
+							addTreeConstant(tree, LLVMConstNeg(op2));
+							leaf = op1;
+						} else if (LLVMIsAConstantInt(op2)) {
+							addTreeConstant(tree, op2);
+							leaf = op1;
+						} else {
+							addTreeConstant(tree, op1);
+							leaf = op2;
+						}
+						lookedThrough = true;
+						if (LLVMIsAConstantInt(leaf)) break;
+					}
+				}
+				// A leaf that turned out to be constant joins the combined constant
+				for (size_t i = 0; i < tree.leaves.size(); i++) {
+					if (LLVMIsAConstantInt(tree.leaves[i])) {
+						addTreeConstant(tree, tree.leaves[i]);
+						tree.leaves.erase(tree.leaves.begin() + i);
+						i--;
+					}
+				}
+			}
+
+			stable_sort(tree.leaves.begin(), tree.leaves.end(), [&](LLVMValueRef a, LLVMValueRef b) {
+				return rankOf(a) < rankOf(b);
+			});
+
+			// The constant is dropped when it is the identity, and a product with zero is zero
+			LLVMValueRef constant = tree.constant;
+			bool isZero = constant != NULL && LLVMConstIntGetZExtValue(constant) == 0;
+			bool isOne = constant != NULL && LLVMConstIntGetZExtValue(constant) == 1;
+			bool absorbing = tree.opcode == LLVMMul && isZero;
+			if ((tree.opcode == LLVMAdd && isZero) || (tree.opcode == LLVMMul && isOne)) {
+				if (!tree.leaves.empty()) constant = NULL;
+			}
+
+			// Leave trees that are already a sorted chain with at most one trailing constant alone
+			if (!lookedThrough && !tree.rewritesSub && !absorbing && tree.numConstants == (constant ? 1 : 0)
+				&& (constant == NULL || LLVMGetOperand(root, 1) == constant)) {
+				vector<LLVMValueRef> chain; // operands from the top of the chain down
+				LLVMValueRef node = constant ? LLVMGetOperand(root, 0) : root;
+				while (node == root || isTreeNode(tree, node, bb)) {
+					chain.push_back(LLVMGetOperand(node, 1));
+					node = LLVMGetOperand(node, 0);
+				}
+				chain.push_back(node);
+				reverse(chain.begin(), chain.end());
+				if (chain == tree.leaves) continue;
+			}
+
+			LLVMPositionBuilderBefore(builder, root);
+			LLVMValueRef result = NULL;
+			if (absorbing) {
+				result = tree.constant;
+			} else {
+				for (LLVMValueRef leaf : tree.leaves) {
+					if (result == NULL) result = leaf;
+					else if (tree.opcode == LLVMAdd) result = LLVMBuildAdd(builder, result, leaf, "");
+					else result = LLVMBuildMul(builder, result, leaf, "");
+				}
+				if (constant != NULL) {
+					if (result == NULL) result = constant;
+					else if (tree.opcode == LLVMAdd) result = LLVMBuildAdd(builder, result, constant, "");
+					else result = LLVMBuildMul(builder, result, constant, "");
+				}
+			}
+
+			if (TRACING(TRACE_CHANGES)) {
+				printf("Reassociated:\n");
+				LLVMDumpValue(root);
+				printf("\n into:\n");
+				LLVMDumpValue(result);
+				printf("\n");
+			}
+
+			// The interior nodes are left without uses for dead code elimination
+			LLVMReplaceAllUsesWith(root, result);
+			LLVMInstructionEraseFromParent(root);
+			numRewritten++;
+			countStatistic("expressions reassociated");
+		}
+	}
+
+	LLVMDisposeBuilder(builder);
+	return numRewritten;
+}
+
+int reassociation(LLVMModuleRef module) {
+	bool changed = false;
+
+	for (LLVMValueRef function =  firstFunction(module); 
+			function; 
+			function = nextFunction(function)) {
+
+		if (!needsVisit(function)) continue;
+		if (reassociationInFunction(function)) {
+			markFunctionChanged(function);
+			changed = true;
+		}
+	}
+
+	if (changed) return 1; // Indicate that we made changes
+	else return 0; // No changes made
+}
+
+// ---- If-conversion ----
+
+// Small if/else diamonds and if-then triangles become straight-line code. The instructions of both arms are
+// speculated above the branch, each variable an arm stores gets select(cond, then-value, else-value) stored
+// unconditionally (an arm that leaves the variable alone contributes its current value), and phis at the join
+// become selects. Only loads and stores of allocas and arithmetic that cannot trap are speculated, and at most
+// IF_CONVERSION_THRESHOLD instructions in total, so a branch around a long arm is kept.
+
+#define IF_CONVERSION_THRESHOLD 8 // most instructions speculated out of the two arms
+
+// The block an arm falls through to when it can be speculated: its only predecessor is header and it ends in
+// an unconditional branch. Adds the instructions that would be speculated to cost. NULL otherwise.
+LLVMBasicBlockRef speculatableArmJoin(LLVMBasicBlockRef arm, LLVMBasicBlockRef header,
+		unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>>& preds, int& cost) {
+	if (arm == header || preds[arm].size() != 1) return NULL;
+	LLVMValueRef terminator = LLVMGetBasicBlockTerminator(arm);
+	if (LLVMGetInstructionOpcode(terminator) != LLVMBr || LLVMIsConditional(terminator)) return NULL;
+
+	for (LLVMValueRef inst = LLVMGetFirstInstruction(arm); inst != terminator; inst = LLVMGetNextInstruction(inst)) {
+		switch (LLVMGetInstructionOpcode(inst)) {
+			case LLVMLoad:
+				if (!LLVMIsAAllocaInst(LLVMGetOperand(inst, 0))) return NULL;
+				break;
+			case LLVMStore:
+				if (!LLVMIsAAllocaInst(LLVMGetOperand(inst, 1))) return NULL;
+				continue; // Stores turn into selects rather than being speculated
+			case LLVMAdd: case LLVMSub: case LLVMMul: case LLVMAnd: case LLVMOr: case LLVMXor:
+			case LLVMShl: case LLVMLShr: case LLVMAShr: case LLVMICmp: case LLVMSelect:
+			case LLVMZExt: case LLVMSExt: case LLVMTrunc:
+				break;
+			default:
+				return NULL; // Phis, calls, divisions and anything else that may trap or has side effects
+		}
+		cost++;
+	}
+	return LLVMGetSuccessor(terminator, 0);
+}
+
+// Moves the arm's computations before the builder position. Stores are dropped and their final value per
+// address is recorded instead, and loads of an address the arm already stored are replaced by the stored value.
+void speculateArm(LLVMBuilderRef builder, LLVMBasicBlockRef arm, unordered_map<LLVMValueRef, LLVMValueRef>& stored,
+		vector<LLVMValueRef>& addresses) {
+	LLVMValueRef terminator = LLVMGetBasicBlockTerminator(arm);
+	LLVMValueRef inst = LLVMGetFirstInstruction(arm);
+	while (inst != terminator) {
+		LLVMValueRef next = LLVMGetNextInstruction(inst);
+		if (LLVMIsAStoreInst(inst)) {
+			LLVMValueRef address = LLVMGetOperand(inst, 1);
+			if (find(addresses.begin(), addresses.end(), address) == addresses.end()) addresses.push_back(address);
+			stored[address] = LLVMGetOperand(inst, 0);
+		} else if (LLVMIsALoadInst(inst) && stored.count(LLVMGetOperand(inst, 0))) {
+			LLVMReplaceAllUsesWith(inst, stored[LLVMGetOperand(inst, 0)]);
+			LLVMInstructionEraseFromParent(inst);
+		} else {
+			moveInstruction(builder, inst);
+		}
+		inst = next;
+	}
+}
+
+// Converts the diamond or triangle headed by header's conditional branch, if there is one
+bool ifConvert(LLVMBasicBlockRef header, unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>>& preds) {
+	LLVMValueRef branch = LLVMGetBasicBlockTerminator(header);
+	if (branch == NULL || LLVMGetInstructionOpcode(branch) != LLVMBr || !LLVMIsConditional(branch)) return false;
+	LLVMBasicBlockRef thenBB = LLVMGetSuccessor(branch, 0);
+	LLVMBasicBlockRef elseBB = LLVMGetSuccessor(branch, 1);
+	if (thenBB == elseBB) return false;
+
+	int thenCost = 0, elseCost = 0;
+	LLVMBasicBlockRef thenJoin = speculatableArmJoin(thenBB, header, preds, thenCost);
+	LLVMBasicBlockRef elseJoin = speculatableArmJoin(elseBB, header, preds, elseCost);
+	LLVMBasicBlockRef thenArm = NULL, elseArm = NULL, join = NULL;
+	if (thenJoin != NULL && thenJoin == elseJoin) {
+		thenArm = thenBB; // Diamond
+		elseArm = elseBB;
+		join = thenJoin;
+	} else if (thenJoin == elseBB) {
+		thenArm = thenBB; // Triangle around the then-arm
+		join = elseBB;
+		elseCost = 0;
+	} else if (elseJoin == thenBB) {
+		elseArm = elseBB; // Triangle around the else-arm
+		join = thenBB;
+		thenCost = 0;
+	} else {
+		return false;
+	}
+	if (join == header || thenCost + elseCost > IF_CONVERSION_THRESHOLD) return false;
+
+	// Phis at the join can only become selects when the two sides are its only predecessors
+	if (LLVMIsAPHINode(LLVMGetFirstInstruction(join)) && preds[join].size() != 2) return false;
+
+	if (TRACING(TRACE_CHANGES)) {
+		printf("If-converting %s branch in block:\n", thenArm && elseArm ? "diamond" : "triangle");
+		LLVMDumpValue(LLVMBasicBlockAsValue(header));
+	}
+
+	LLVMValueRef cond = LLVMGetCondition(branch);
+	LLVMBuilderRef builder = LLVMCreateBuilderInContext(blockContext(header));
+	LLVMPositionBuilderBefore(builder, branch);
+
+	unordered_map<LLVMValueRef, LLVMValueRef> thenStored, elseStored;
+	vector<LLVMValueRef> addresses;
+	if (thenArm) speculateArm(builder, thenArm, thenStored, addresses);
+	if (elseArm) speculateArm(builder, elseArm, elseStored, addresses);
+
+	for (LLVMValueRef address : addresses) {
+		LLVMValueRef current = NULL;
+		if (!thenStored.count(address) || !elseStored.count(address)) {
+			current = LLVMBuildLoad2(builder, LLVMGetAllocatedType(address), address, "");
+		}
+		LLVMValueRef thenValue = thenStored.count(address) ? thenStored[address] : current;
+		LLVMValueRef elseValue = elseStored.count(address) ? elseStored[address] : current;
+		LLVMBuildStore(builder, LLVMBuildSelect(builder, cond, thenValue, elseValue, ""), address);
+	}
+
+	LLVMBasicBlockRef thenPred = thenArm ? thenArm : header;
+	LLVMBasicBlockRef elsePred = elseArm ? elseArm : header;
+	LLVMValueRef phi = LLVMGetFirstInstruction(join);
+	while (phi && LLVMIsAPHINode(phi)) {
+		LLVMValueRef next = LLVMGetNextInstruction(phi);
+		LLVMValueRef thenValue = NULL, elseValue = NULL;
+		unsigned numIncoming = LLVMCountIncoming(phi);
+		for (unsigned i = 0; i < numIncoming; i++) {
+			if (LLVMGetIncomingBlock(phi, i) == thenPred) thenValue = LLVMGetIncomingValue(phi, i);
+			if (LLVMGetIncomingBlock(phi, i) == elsePred) elseValue = LLVMGetIncomingValue(phi, i);
+		}
+		LLVMReplaceAllUsesWith(phi, LLVMBuildSelect(builder, cond, thenValue, elseValue, ""));
+		LLVMInstructionEraseFromParent(phi);
+		phi = next;
+	}
+
+	LLVMInstructionEraseFromParent(branch);
+	LLVMPositionBuilderAtEnd(builder, header);
+	LLVMBuildBr(builder, join);
+	LLVMDisposeBuilder(builder);
+
+	if (thenArm) LLVMDeleteBasicBlock(thenArm);
+	if (elseArm) LLVMDeleteBasicBlock(elseArm);
+	mergeIntoPredecessor(join);
+	return true;
+}
+
+int ifConversion(LLVMModuleRef module) {
+	int numConverted = 0;
+
+	for (LLVMValueRef function =  firstFunction(module); 
+			function; 
+			function = nextFunction(function)) {
+
+		if (!needsVisit(function)) continue;
+
+		// Start over after every conversion, since it may expose an enclosing diamond
+		bool converted = true;
+		while (converted) {
+			converted = false;
+			unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>>& preds = cachedPredecessors(function);
+			for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+				if (ifConvert(bb, preds)) {
+					invalidateAnalyses(function);
+					markFunctionChanged(function);
+					converted = true;
+					numConverted++;
+					break;
+				}
+			}
+		}
+	}
+
+	if (TRACING(TRACE_PASSES) && numConverted > 0) {
+		printf("If-conversion replaced %d branches with selects\n", numConverted);
+	}
+
+	countStatistic("branches converted", numConverted);
+
+	if (numConverted > 0) return 1; // Indicate that we made changes
+	else return 0; // No changes made
+}
+
+// ---- Value range analysis ----
+
+// Signed integer ranges [lo, hi] for every instruction result of at most 32 bits, and for every integer local
+// variable at block boundaries. Ranges come from constants, arithmetic, stores, phis and selects. On each edge
+// out of a conditional branch, the comparison narrows the variables it loaded, and an edge whose condition
+// cannot hold is infeasible. A loop head visited more than RANGE_WIDEN_AFTER times is widened to the type's
+// limits so loops converge, and RANGE_NARROW_ROUNDS plain passes afterwards win back bounds such as the one
+// a loop counter gets from its exit test.
+
+#define RANGE_WIDEN_AFTER 3
+#define RANGE_NARROW_ROUNDS 2
+
+bool isRangeType(LLVMTypeRef type) {
+	return LLVMGetTypeKind(type) == LLVMIntegerTypeKind && LLVMGetIntTypeWidth(type) <= 32;
+}
+
+ValueRange makeRange(long long lo, long long hi) {
+	ValueRange range;
+	range.lo = lo;
+	range.hi = hi;
+	range.empty = lo > hi;
+	return range;
+}
+
+ValueRange emptyRange() {
+	return makeRange(1, 0);
+}
+
+ValueRange fullRange(LLVMTypeRef type) {
+	if (!isRangeType(type)) return makeRange(LLONG_MIN, LLONG_MAX);
+	unsigned width = LLVMGetIntTypeWidth(type);
+	return makeRange(-(1LL << (width - 1)), (1LL << (width - 1)) - 1);
+}
+
+// The exact range [lo, hi] if type can hold it, otherwise the result may have wrapped and is unknown
+ValueRange fitRange(long long lo, long long hi, LLVMTypeRef type) {
+	ValueRange full = fullRange(type);
+	if (lo < full.lo || hi > full.hi) return full;
+	return makeRange(lo, hi);
+}
+
+ValueRange unionRange(ValueRange a, ValueRange b) {
+	if (a.empty) return b;
+	if (b.empty) return a;
+	return makeRange(min(a.lo, b.lo), max(a.hi, b.hi));
+}
+
+bool sameRange(ValueRange a, ValueRange b) {
+	return a.empty == b.empty && (a.empty || (a.lo == b.lo && a.hi == b.hi));
+}
+
+// Bounds that moved since old jump to the limits of type
+ValueRange widenRange(ValueRange old, ValueRange now, LLVMTypeRef type) {
+	if (old.empty || now.empty) return now;
+	ValueRange full = fullRange(type);
+	return makeRange(now.lo < old.lo ? full.lo : now.lo, now.hi > old.hi ? full.hi : now.hi);
+}
+
+LLVMIntPredicate inversePredicate(LLVMIntPredicate pred) {
+	switch (pred) {
+		case LLVMIntEQ: return LLVMIntNE;
+		case LLVMIntNE: return LLVMIntEQ;
+		case LLVMIntUGT: return LLVMIntULE;
+		case LLVMIntUGE: return LLVMIntULT;
+		case LLVMIntULT: return LLVMIntUGE;
+		case LLVMIntULE: return LLVMIntUGT;
+		case LLVMIntSGT: return LLVMIntSLE;
+		case LLVMIntSGE: return LLVMIntSLT;
+		case LLVMIntSLT: return LLVMIntSGE;
+		default: return LLVMIntSGT;
+	}
+}
+
+// The predicate with its operands swapped: a < b is b > a
+LLVMIntPredicate swappedPredicate(LLVMIntPredicate pred) {
+	switch (pred) {
+		case LLVMIntUGT: return LLVMIntULT;
+		case LLVMIntUGE: return LLVMIntULE;
+		case LLVMIntULT: return LLVMIntUGT;
+		case LLVMIntULE: return LLVMIntUGE;
+		case LLVMIntSGT: return LLVMIntSLT;
+		case LLVMIntSGE: return LLVMIntSLE;
+		case LLVMIntSLT: return LLVMIntSGT;
+		case LLVMIntSLE: return LLVMIntSGE;
+		default: return pred;
+	}
+}
+
+// 1 if a pred b holds for all values in the ranges, 0 if it never does, -1 if it depends
+int compareRanges(LLVMIntPredicate pred, ValueRange a, ValueRange b) {
+	if (a.empty || b.empty) return -1;
+
+	switch (pred) {
+		case LLVMIntEQ:
+			if (a.lo == a.hi && b.lo == b.hi && a.lo == b.lo) return 1;
+			if (a.hi < b.lo || b.hi < a.lo) return 0;
+			return -1;
+		case LLVMIntNE: {
+			int equal = compareRanges(LLVMIntEQ, a, b);
+			return equal < 0 ? -1 : !equal;
+		}
+		case LLVMIntSLT:
+			if (a.hi < b.lo) return 1;
+			if (a.lo >= b.hi) return 0;
+			return -1;
+		case LLVMIntSLE:
+			if (a.hi <= b.lo) return 1;
+			if (a.lo > b.hi) return 0;
+			return -1;
+		case LLVMIntSGT:
+		case LLVMIntSGE:
+			return compareRanges(swappedPredicate(pred), b, a);
+		default:
+			// Unsigned comparisons order non-negative values the same way signed ones do
+			if (a.lo < 0 || b.lo < 0) return -1;
+			if (pred == LLVMIntULT) return compareRanges(LLVMIntSLT, a, b);
+			if (pred == LLVMIntULE) return compareRanges(LLVMIntSLE, a, b);
+			if (pred == LLVMIntUGT) return compareRanges(LLVMIntSGT, a, b);
+			return compareRanges(LLVMIntSGE, a, b);
+	}
+}
+
+// The values of a for which a pred b can hold
+ValueRange refineRange(ValueRange a, LLVMIntPredicate pred, ValueRange b) {
+	if (a.empty || b.empty) return emptyRange();
+
+	switch (pred) {
+		case LLVMIntEQ:
+			return makeRange(max(a.lo, b.lo), min(a.hi, b.hi));
+		case LLVMIntNE:
+			if (b.lo == b.hi && a.lo == b.lo) a.lo++;
+			if (b.lo == b.hi && a.hi == b.lo) a.hi--;
+			return makeRange(a.lo, a.hi);
+		case LLVMIntSLT: return makeRange(a.lo, min(a.hi, b.hi - 1));
+		case LLVMIntSLE: return makeRange(a.lo, min(a.hi, b.hi));
+		case LLVMIntSGT: return makeRange(max(a.lo, b.lo + 1), a.hi);
+		case LLVMIntSGE: return makeRange(max(a.lo, b.lo), a.hi);
+		case LLVMIntULT:
+		case LLVMIntULE:
+			// Below a non-negative bound means non-negative as well
+			if (b.lo < 0) return a;
+			return makeRange(max(a.lo, 0LL), min(a.hi, pred == LLVMIntULT ? b.hi - 1 : b.hi));
+		default:
+			if (a.lo < 0 || b.lo < 0) return a;
+			return refineRange(a, pred == LLVMIntUGT ? LLVMIntSGT : LLVMIntSGE, b);
+	}
+}
+
+ValueRange rangeOf(RangeAnalysis& ranges, LLVMValueRef value) {
+	LLVMTypeRef type = LLVMTypeOf(value);
+	if (!isRangeType(type)) return fullRange(type);
+
+	if (LLVMIsAConstantInt(value)) {
+		long long constant = LLVMConstIntGetSExtValue(value);
+		return makeRange(constant, constant);
+	}
+	if (LLVMIsAInstruction(value)) {
+		auto it = ranges.values.find(value);
+		return it == ranges.values.end() ? emptyRange() : it->second;
+	}
+	return fullRange(type); // Arguments, globals, undef
+}
+
+void setVariableRange(VariableRanges& state, LLVMValueRef variable, ValueRange range) {
+	ValueRange full = fullRange(LLVMGetAllocatedType(variable));
+	if (!range.empty && range.lo <= full.lo && range.hi >= full.hi) state.vars.erase(variable);
+	else state.vars[variable] = range;
+}
+
+ValueRange variableRange(VariableRanges& state, LLVMValueRef variable) {
+	auto it = state.vars.find(variable);
+	return it == state.vars.end() ? fullRange(LLVMGetAllocatedType(variable)) : it->second;
+}
+
+VariableRanges joinVariableRanges(VariableRanges& a, VariableRanges& b) {
+	if (!a.reached) return b;
+	if (!b.reached) return a;
+	VariableRanges joined;
+	joined.reached = true;
+	for (auto& entry : a.vars) {
+		auto it = b.vars.find(entry.first);
+		if (it != b.vars.end()) setVariableRange(joined, entry.first, unionRange(entry.second, it->second));
+	}
+	return joined;
+}
+
+bool sameVariableRanges(VariableRanges& a, VariableRanges& b) {
+	if (a.reached != b.reached || a.vars.size() != b.vars.size()) return false;
+	for (auto& entry : a.vars) {
+		auto it = b.vars.find(entry.first);
+		if (it == b.vars.end() || !sameRange(entry.second, it->second)) return false;
+	}
+	return true;
+}
+
+// The tracked variable value was loaded from, if the load is in bb and the variable still holds that value at
+// the end of bb; a load from an earlier block may have been overwritten on the way
+LLVMValueRef loadedVariable(RangeAnalysis& ranges, LLVMValueRef value, LLVMBasicBlockRef bb) {
+	if (!LLVMIsALoadInst(value) || LLVMGetInstructionParent(value) != bb) return NULL;
+	if (!ranges.variables.count(LLVMGetOperand(value, 0))) return NULL;
+	LLVMValueRef variable = LLVMGetOperand(value, 0);
+	for (LLVMValueRef inst = LLVMGetNextInstruction(value); inst; inst = LLVMGetNextInstruction(inst)) {
+		if (LLVMIsAStoreInst(inst) && LLVMGetOperand(inst, 1) == variable) return NULL;
+	}
+	return variable;
+}
+
+// Variables on the edge pred -> succ: the state at pred's branch narrowed by the condition the edge implies
+VariableRanges edgeRanges(RangeAnalysis& ranges, LLVMBasicBlockRef pred, LLVMBasicBlockRef succ) {
+	VariableRanges state = ranges.blockOut[pred];
+	LLVMValueRef branch = LLVMGetBasicBlockTerminator(pred);
+	if (!state.reached || LLVMGetInstructionOpcode(branch) != LLVMBr || !LLVMIsConditional(branch)) return state;
+
+	bool onTrue = LLVMGetSuccessor(branch, 0) == succ;
+	if (onTrue == (LLVMGetSuccessor(branch, 1) == succ)) return state;
+
+	LLVMValueRef cond = LLVMGetCondition(branch);
+	ValueRange condRange = rangeOf(ranges, cond);
+	if (condRange.empty || (condRange.lo == condRange.hi && (condRange.lo != 0) != onTrue)) {
+		state.reached = false;
+		return state;
+	}
+	if (!LLVMIsAICmpInst(cond)) return state;
+
+	LLVMIntPredicate predicate = LLVMGetICmpPredicate(cond);
+	if (!onTrue) predicate = inversePredicate(predicate);
+	for (int side = 0; side < 2; side++) {
+		LLVMValueRef variable = loadedVariable(ranges, LLVMGetOperand(cond, side), pred);
+		if (variable == NULL) continue;
+		ValueRange refined = refineRange(variableRange(state, variable), side == 0 ? predicate : swappedPredicate(predicate),
+			rangeOf(ranges, LLVMGetOperand(cond, 1 - side)));
+		if (refined.empty) {
+			state.reached = false;
+			return state;
+		}
+		setVariableRange(state, variable, refined);
+	}
+	return state;
+}
+
+bool edgeFeasible(RangeAnalysis& ranges, LLVMBasicBlockRef pred, LLVMBasicBlockRef succ) {
+	return edgeRanges(ranges, pred, succ).reached;
+}
+
+ValueRange evaluateRange(RangeAnalysis& ranges, LLVMValueRef inst, VariableRanges& state) {
+	LLVMTypeRef type = LLVMTypeOf(inst);
+	LLVMOpcode opcode = LLVMGetInstructionOpcode(inst);
+
+	if (opcode == LLVMLoad) {
+		LLVMValueRef address = LLVMGetOperand(inst, 0);
+		return ranges.variables.count(address) ? variableRange(state, address) : fullRange(type);
+	}
+	if (opcode == LLVMPHI) {
+		ValueRange range = emptyRange();
+		unsigned numIncoming = LLVMCountIncoming(inst);
+		for (unsigned i = 0; i < numIncoming; i++) {
+			if (edgeFeasible(ranges, LLVMGetIncomingBlock(inst, i), LLVMGetInstructionParent(inst))) {
+				range = unionRange(range, rangeOf(ranges, LLVMGetIncomingValue(inst, i)));
+			}
+		}
+		return range;
+	}
+	if (opcode == LLVMICmp) {
+		ValueRange a = rangeOf(ranges, LLVMGetOperand(inst, 0));
+		ValueRange b = rangeOf(ranges, LLVMGetOperand(inst, 1));
+		if (a.empty || b.empty) return emptyRange();
+		int result = compareRanges(LLVMGetICmpPredicate(inst), a, b);
+		return result < 0 ? makeRange(-1, 0) : makeRange(-result, -result); // i1 true is -1 when read as signed
+	}
+	if (opcode == LLVMSelect) {
+		ValueRange cond = rangeOf(ranges, LLVMGetOperand(inst, 0));
+		ValueRange whenTrue = rangeOf(ranges, LLVMGetOperand(inst, 1));
+		ValueRange whenFalse = rangeOf(ranges, LLVMGetOperand(inst, 2));
+		if (cond.empty) return emptyRange();
+		if (cond.lo == cond.hi) return cond.lo ? whenTrue : whenFalse;
+		return unionRange(whenTrue, whenFalse);
+	}
+
+	if (LLVMGetNumOperands(inst) < 1) return fullRange(type);
+	ValueRange a = rangeOf(ranges, LLVMGetOperand(inst, 0));
+	if (a.empty) return emptyRange();
+
+	switch (opcode) {
+		case LLVMSExt:
+			return isRangeType(type) ? a : fullRange(type);
+		case LLVMZExt: {
+			if (!isRangeType(type)) return fullRange(type);
+			if (a.lo >= 0) return a;
+			long long modulus = 1LL << LLVMGetIntTypeWidth(LLVMTypeOf(LLVMGetOperand(inst, 0)));
+			if (a.hi < 0) return makeRange(a.lo + modulus, a.hi + modulus);
+			return makeRange(0, modulus - 1);
+		}
+		case LLVMTrunc:
+			return fitRange(a.lo, a.hi, type);
+		default:
+			break;
+	}
+
+	if (!LLVMIsABinaryOperator(inst) || !isRangeType(type)) return fullRange(type);
+	ValueRange b = rangeOf(ranges, LLVMGetOperand(inst, 1));
+	if (b.empty) return emptyRange();
+
+	// Operands have at most 32 bits, so none of these overflow a long long
+	switch (opcode) {
+		case LLVMAdd:
+			return fitRange(a.lo + b.lo, a.hi + b.hi, type);
+		case LLVMSub:
+			return fitRange(a.lo - b.hi, a.hi - b.lo, type);
+		case LLVMMul: {
+			long long products[4] = { a.lo * b.lo, a.lo * b.hi, a.hi * b.lo, a.hi * b.hi };
+			return fitRange(*min_element(products, products + 4), *max_element(products, products + 4), type);
+		}
+		case LLVMSDiv:
+			// Dividing by a positive range keeps the sign and moves toward zero
+			if (b.lo > 0) return makeRange(min(a.lo / b.lo, a.lo / b.hi), max(a.hi / b.lo, a.hi / b.hi));
+			return fullRange(type);
+		case LLVMAnd:
+			if (a.lo >= 0 && b.lo >= 0) return makeRange(0, min(a.hi, b.hi));
+			if (a.lo >= 0) return makeRange(0, a.hi);
+			if (b.lo >= 0) return makeRange(0, b.hi);
+			return fullRange(type);
+		case LLVMAShr:
+			if (b.lo == b.hi && b.lo >= 0 && b.lo < LLVMGetIntTypeWidth(type)) {
+				return makeRange(a.lo >> b.lo, a.hi >> b.lo);
+			}
+			return fullRange(type);
+		default:
+			return fullRange(type);
+	}
+}
+
+// Runs the instructions of bb on state; stores the results and the final state, noting whether anything changed
+void rangeTransfer(RangeAnalysis& ranges, LLVMBasicBlockRef bb, VariableRanges state, bool widen, bool& changed) {
+	for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+		if (LLVMIsAStoreInst(inst)) {
+			LLVMValueRef address = LLVMGetOperand(inst, 1);
+			if (ranges.variables.count(address)) setVariableRange(state, address, rangeOf(ranges, LLVMGetOperand(inst, 0)));
+			continue;
+		}
+		if (!isRangeType(LLVMTypeOf(inst))) continue;
+
+		ValueRange range = evaluateRange(ranges, inst, state);
+		auto it = ranges.values.find(inst);
+		if (it != ranges.values.end()) {
+			if (widen && LLVMIsAPHINode(inst)) {
+				range = widenRange(it->second, unionRange(it->second, range), LLVMTypeOf(inst));
+			}
+			if (sameRange(it->second, range)) continue;
+		}
+		ranges.values[inst] = range;
+		changed = true;
+	}
+
+	if (!sameVariableRanges(ranges.blockOut[bb], state)) {
+		ranges.blockOut[bb] = state;
+		changed = true;
+	}
+}
+
+RangeAnalysis computeRanges(LLVMValueRef function) {
+	RangeAnalysis ranges;
+	if (LLVMGetFirstBasicBlock(function) == NULL) return ranges;
+
+	LLVMBasicBlockRef entry = LLVMGetEntryBasicBlock(function);
+	for (LLVMValueRef inst = LLVMGetFirstInstruction(entry); inst; inst = LLVMGetNextInstruction(inst)) {
+		if (LLVMIsAAllocaInst(inst) && isRangeType(LLVMGetAllocatedType(inst)) && isLocalVariable(inst)) {
+			ranges.variables.insert(inst);
+		}
+	}
+
+	vector<LLVMBasicBlockRef>& rpo = cachedReversePostOrder(function);
+	unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>>& preds = cachedPredecessors(function);
+	unordered_map<LLVMBasicBlockRef, int> visits;
+
+	// Widening only happens where a cycle is closed, at the targets of edges going back in reverse post-order,
+	// so the ranges a loop condition establishes in the body stay bounded
+	unordered_map<LLVMBasicBlockRef, size_t> rpoIndex;
+	for (size_t i = 0; i < rpo.size(); i++) {
+		rpoIndex[rpo[i]] = i;
+	}
+	unordered_set<LLVMBasicBlockRef> loopHeads;
+	for (size_t i = 0; i < rpo.size(); i++) {
+		for (LLVMBasicBlockRef succ : getSuccessors(rpo[i])) {
+			if (rpoIndex[succ] <= i) loopHeads.insert(succ);
+		}
+	}
+
+	// Rounds over the blocks in reverse post-order until nothing changes, widening blocks visited too often,
+	// then a few more rounds without widening
+	bool changed = true;
+	int narrowRounds = 0;
+	while (changed || narrowRounds < RANGE_NARROW_ROUNDS) {
+		bool narrowing = !changed;
+		if (narrowing) narrowRounds++;
+		changed = false;
+
+		for (LLVMBasicBlockRef bb : rpo) {
+			VariableRanges state;
+			state.reached = bb == entry; // Variables start out uninitialized, so anything goes
+			for (LLVMBasicBlockRef pred : preds[bb]) {
+				VariableRanges edge = edgeRanges(ranges, pred, bb);
+				state = joinVariableRanges(state, edge);
+			}
+
+			bool widen = !narrowing && loopHeads.count(bb) && ++visits[bb] > RANGE_WIDEN_AFTER;
+			VariableRanges& old = ranges.blockIn[bb];
+			if (widen && old.reached) {
+				VariableRanges joined = joinVariableRanges(old, state);
+				VariableRanges widened;
+				widened.reached = true;
+				for (auto& entry : joined.vars) {
+					auto it = old.vars.find(entry.first);
+					if (it == old.vars.end()) continue;
+					setVariableRange(widened, entry.first,
+						widenRange(it->second, entry.second, LLVMGetAllocatedType(entry.first)));
+				}
+				state = widened;
+			}
+			if (!narrowing && !sameVariableRanges(old, state)) changed = true;
+			old = state;
+
+			bool blockChanged = false;
+			rangeTransfer(ranges, bb, state, widen, blockChanged);
+			if (!narrowing && blockChanged) changed = true;
+		}
+	}
+
+	return ranges;
+}
+
+LLVMValueRef foldComparison(RangeAnalysis& ranges, LLVMValueRef icmp) {
+	int result = compareRanges(LLVMGetICmpPredicate(icmp), rangeOf(ranges, LLVMGetOperand(icmp, 0)),
+		rangeOf(ranges, LLVMGetOperand(icmp, 1)));
+	if (result < 0) return NULL;
+	return LLVMConstInt(LLVMTypeOf(icmp), result, 0);
+}
+
+// Range of value, computed in bb, when bb is entered from pred with the variables in state rather than with
+// what all its predecessors together bring. The block is evaluated in place and its own results put back after.
+ValueRange rangeThroughEdge(RangeAnalysis& ranges, LLVMBasicBlockRef pred, LLVMBasicBlockRef bb, VariableRanges state,
+		LLVMValueRef value) {
+	unordered_map<LLVMValueRef, ValueRange> saved;
+	for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+		auto it = ranges.values.find(inst);
+		if (it != ranges.values.end()) saved[inst] = it->second;
+	}
+
+	for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+		if (LLVMIsAStoreInst(inst)) {
+			LLVMValueRef address = LLVMGetOperand(inst, 1);
+			if (ranges.variables.count(address)) setVariableRange(state, address, rangeOf(ranges, LLVMGetOperand(inst, 0)));
+			continue;
+		}
+		if (!isRangeType(LLVMTypeOf(inst))) continue;
+
+		ValueRange range = emptyRange();
+		if (LLVMIsAPHINode(inst)) {
+			unsigned numIncoming = LLVMCountIncoming(inst);
+			for (unsigned i = 0; i < numIncoming; i++) {
+				if (LLVMGetIncomingBlock(inst, i) == pred) range = rangeOf(ranges, LLVMGetIncomingValue(inst, i));
+			}
+		} else {
+			range = evaluateRange(ranges, inst, state);
+		}
+		ranges.values[inst] = range;
+	}
+	ValueRange result = rangeOf(ranges, value);
+
+	for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+		auto it = saved.find(inst);
+		if (it != saved.end()) ranges.values[inst] = it->second;
+		else ranges.values.erase(inst);
+	}
+	return result;
+}
+
+// ---- Branch simplification ----
+
+// A conditional branch with a constant condition, or with an edge the value range analysis shows is never taken,
+// becomes an unconditional branch, and the blocks that can no longer be reached are deleted.
+
+int branchSimplification(LLVMModuleRef module) {
+	int numSimplified = 0;
+
+	for (LLVMValueRef function =  firstFunction(module); 
+			function; 
+			function = nextFunction(function)) {
+
+		if (LLVMGetFirstBasicBlock(function) == NULL || !needsVisit(function)) continue;
+
+		RangeAnalysis ranges = computeRanges(function);
+		LLVMBuilderRef builder = LLVMCreateBuilderInContext(LLVMGetModuleContext(module));
+		bool functionChanged = false;
+
+		for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+			LLVMValueRef branch = LLVMGetBasicBlockTerminator(bb);
+			if (branch == NULL || LLVMGetInstructionOpcode(branch) != LLVMBr || !LLVMIsConditional(branch)) continue;
+
+			LLVMBasicBlockRef succs[2] = { LLVMGetSuccessor(branch, 0), LLVMGetSuccessor(branch, 1) };
+			if (succs[0] == succs[1]) continue;
+
+			int taken = -1;
+			LLVMValueRef cond = LLVMGetCondition(branch);
+			if (LLVMIsAConstantInt(cond)) {
+				taken = LLVMConstIntGetZExtValue(cond) ? 0 : 1;
+			} else {
+				bool feasible[2] = { edgeFeasible(ranges, bb, succs[0]), edgeFeasible(ranges, bb, succs[1]) };
+				if (feasible[0] != feasible[1]) taken = feasible[0] ? 0 : 1;
+			}
+			if (taken < 0) continue;
+
+			if (TRACING(TRACE_CHANGES)) {
+				printf("Branch always goes to its %s successor:\n", taken == 0 ? "true" : "false");
+				LLVMDumpValue(branch);
+				printf("\n");
+			}
+
+			removePhiIncomingBlock(succs[1 - taken], bb);
+			LLVMInstructionEraseFromParent(branch);
+			LLVMPositionBuilderAtEnd(builder, bb);
+			LLVMBuildBr(builder, succs[taken]);
+			numSimplified++;
+			functionChanged = true;
+		}
+
+		LLVMDisposeBuilder(builder);
+		if (!functionChanged) continue;
+		markFunctionChanged(function);
+
+		deleteUnreachableBlocks(function);
+		mergeStraightLines(function);
+	}
+
+	countStatistic("branches folded", numSimplified);
+
+	if (numSimplified > 0) return 1; // Indicate that we made changes
+	else return 0; // No changes made
+}
+
+// ---- Loop unswitching ----
+
+// A conditional branch inside a loop whose condition cannot change while the loop runs is decided once, in the
+// preheader. The loop is cloned, the original keeps only the true side of the branch and the copy only the
+// false side, and the preheader branches to one or the other. The condition may read local variables the loop
+// never stores. Since every unswitch duplicates a loop, only loops of at most UNSWITCH_MAX_SIZE instructions
+// are cloned, until the function has grown by UNSWITCH_BUDGET. The main optimization loop then simplifies
+// both copies.
+
+#define UNSWITCH_MAX_SIZE 120 // largest loop (in instructions) that gets cloned
+#define UNSWITCH_BUDGET 300   // total instructions a function may grow by through unswitching
+
+// Whether value is the same on every iteration of loop and can be recomputed ahead of it; storedVars are the
+// addresses the loop stores to
+bool isLoopInvariant(LLVMValueRef value, Loop& loop, unordered_set<LLVMValueRef>& storedVars) {
+	if (!LLVMIsAInstruction(value) || !loop.contains.count(LLVMGetInstructionParent(value))) return true;
+
+	switch (LLVMGetInstructionOpcode(value)) {
+		case LLVMLoad: {
+			LLVMValueRef address = LLVMGetOperand(value, 0);
+			return LLVMIsAAllocaInst(address) && isLocalVariable(address) && !storedVars.count(address);
+		}
+		case LLVMAdd: case LLVMSub: case LLVMMul: case LLVMAnd: case LLVMOr: case LLVMXor:
+		case LLVMShl: case LLVMLShr: case LLVMAShr: case LLVMICmp: case LLVMSelect:
+		case LLVMZExt: case LLVMSExt: case LLVMTrunc: {
+			int numOperands = LLVMGetNumOperands(value);
+			for (int i = 0; i < numOperands; i++) {
+				if (!isLoopInvariant(LLVMGetOperand(value, i), loop, storedVars)) return false;
+			}
+			return true;
+		}
+		default:
+			return false; // Calls, phis, and divisions that might trap once hoisted
+	}
+}
+
+// Recomputes an invariant value of loop at the builder position; names are those taken in the function
+LLVMValueRef hoistInvariant(LLVMBuilderRef builder, LLVMValueRef value, Loop& loop,
+		unordered_map<LLVMValueRef, LLVMValueRef>& hoisted, unordered_set<string>& names) {
+	if (!LLVMIsAInstruction(value) || !loop.contains.count(LLVMGetInstructionParent(value))) return value;
+	if (hoisted.count(value)) return hoisted[value];
+
+	LLVMValueRef clone = LLVMInstructionClone(value);
+	int numOperands = LLVMGetNumOperands(value);
+	for (int i = 0; i < numOperands; i++) {
+		LLVMSetOperand(clone, i, hoistInvariant(builder, LLVMGetOperand(value, i), loop, hoisted, names));
+	}
+	string name = copyName(value, names);
+	LLVMInsertIntoBuilderWithName(builder, clone, name.c_str());
+	hoisted[value] = clone;
+	return clone;
+}
+
+// Turns a conditional branch into a jump to its successor number taken
+void foldBranch(LLVMValueRef branch, unsigned taken) {
+	LLVMBasicBlockRef bb = LLVMGetInstructionParent(branch);
+	LLVMBasicBlockRef target = LLVMGetSuccessor(branch, taken);
+	LLVMBasicBlockRef other = LLVMGetSuccessor(branch, 1 - taken);
+	if (other != target) removePhiIncomingBlock(other, bb);
+
+	LLVMInstructionEraseFromParent(branch);
+	LLVMBuilderRef builder = LLVMCreateBuilderInContext(blockContext(bb));
+	LLVMPositionBuilderAtEnd(builder, bb);
+	LLVMBuildBr(builder, target);
+	LLVMDisposeBuilder(builder);
+}
+
+// A branch between two blocks of loop on an invariant condition, or NULL
+LLVMValueRef findInvariantBranch(Loop& loop) {
+	unordered_set<LLVMValueRef> storedVars;
+	for (LLVMBasicBlockRef bb : loop.blocks) {
+		for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+			if (LLVMIsAStoreInst(inst)) storedVars.insert(LLVMGetOperand(inst, 1));
+		}
+	}
+
+	for (LLVMBasicBlockRef bb : loop.blocks) {
+		LLVMValueRef branch = LLVMGetBasicBlockTerminator(bb);
+		if (LLVMGetInstructionOpcode(branch) != LLVMBr || !LLVMIsConditional(branch)) continue;
+		LLVMBasicBlockRef thenBB = LLVMGetSuccessor(branch, 0);
+		LLVMBasicBlockRef elseBB = LLVMGetSuccessor(branch, 1);
+		if (thenBB == elseBB || !loop.contains.count(thenBB) || !loop.contains.count(elseBB)) continue;
+
+		LLVMValueRef cond = LLVMGetCondition(branch);
+		if (!LLVMIsAConstant(cond) && isLoopInvariant(cond, loop, storedVars)) return branch;
+	}
+	return NULL;
+}
+
+// Whether all uses of values defined in loop are inside it or in phis of the blocks it exits to, the only
+// uses the clone can be wired into without building new phis
+bool loopValuesStayInside(Loop& loop) {
+	for (LLVMBasicBlockRef bb : loop.blocks) {
+		for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+			for (LLVMUseRef use = LLVMGetFirstUse(inst); use; use = LLVMGetNextUse(use)) {
+				LLVMValueRef user = LLVMGetUser(use);
+				if (loop.contains.count(LLVMGetInstructionParent(user))) continue;
+				if (!LLVMIsAPHINode(user)) return false;
+				unsigned numIncoming = LLVMCountIncoming(user);
+				for (unsigned i = 0; i < numIncoming; i++) {
+					if (LLVMGetIncomingValue(user, i) == inst && !loop.contains.count(LLVMGetIncomingBlock(user, i))) {
+						return false;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+bool unswitchLoop(LLVMValueRef function, Loop& loop, LLVMValueRef branch) {
+	unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>> preds = computePredecessors(function);
+	LLVMBasicBlockRef preheader = loopPreheader(loop, preds);
+	if (preheader == NULL) return false;
+
+	if (TRACING(TRACE_CHANGES)) {
+		printf("Unswitching loop at %s on:\n", valueName(LLVMBasicBlockAsValue(loop.header)).c_str());
+		LLVMDumpValue(branch);
+		printf("\n");
+	}
+
+	unordered_map<LLVMValueRef, LLVMValueRef> valueMap;
+	vector<LLVMBasicBlockRef> copies = copyBlocks(loop.blocks, function, LLVMGetNextBasicBlock(loop.blocks.back()), valueMap);
+
+	// The blocks the loop exits to are now also entered from the copy
+	for (size_t b = 0; b < loop.blocks.size(); b++) {
+		for (LLVMBasicBlockRef succ : getSuccessors(loop.blocks[b])) {
+			if (loop.contains.count(succ)) continue;
+			for (LLVMValueRef phi = LLVMGetFirstInstruction(succ); phi && LLVMIsAPHINode(phi); phi = LLVMGetNextInstruction(phi)) {
+				unsigned numIncoming = LLVMCountIncoming(phi);
+				for (unsigned i = 0; i < numIncoming; i++) {
+					if (LLVMGetIncomingBlock(phi, i) != loop.blocks[b]) continue;
+					LLVMValueRef value = mapValue(valueMap, LLVMGetIncomingValue(phi, i));
+					LLVMAddIncoming(phi, &value, &copies[b], 1);
+				}
+			}
+		}
+	}
+
+	// The preheader tests the condition once and picks a copy
+	LLVMValueRef preheaderBranch = LLVMGetBasicBlockTerminator(preheader);
+	LLVMBuilderRef builder = LLVMCreateBuilderInContext(blockContext(preheader));
+	LLVMPositionBuilderBefore(builder, preheaderBranch);
+	unordered_map<LLVMValueRef, LLVMValueRef> hoisted;
+	unordered_set<string> names = localNames(function);
+	LLVMValueRef cond = hoistInvariant(builder, LLVMGetCondition(branch), loop, hoisted, names);
+	LLVMInstructionEraseFromParent(preheaderBranch);
+	LLVMPositionBuilderAtEnd(builder, preheader);
+	LLVMBuildCondBr(builder, cond, loop.header, LLVMValueAsBasicBlock(valueMap[LLVMBasicBlockAsValue(loop.header)]));
+	LLVMDisposeBuilder(builder);
+
+	foldBranch(valueMap[branch], 1);
+	foldBranch(branch, 0);
+	deleteUnreachableBlocks(function);
+	mergeStraightLines(function);
+	return true;
+}
+
+int loopUnswitching(LLVMModuleRef module) {
+	int numUnswitched = 0;
+
+	for (LLVMValueRef function =  firstFunction(module); 
+			function; 
+			function = nextFunction(function)) {
+
+		if (!isDefinedFunction(function) || !needsVisit(function)) continue;
+
+		// Loops are found again after every unswitch, inner loops first
+		int budget = UNSWITCH_BUDGET;
+		bool unswitched = true;
+		while (unswitched) {
+			unswitched = false;
+			vector<Loop>& loops = cachedLoops(function);
+			for (Loop& loop : loops) {
+				int size = 0;
+				for (LLVMBasicBlockRef bb : loop.blocks) {
+					for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) size++;
+				}
+				if (size > UNSWITCH_MAX_SIZE || size > budget) continue;
+
+				LLVMValueRef branch = findInvariantBranch(loop);
+				if (branch == NULL || !loopValuesStayInside(loop) || !unswitchLoop(function, loop, branch)) continue;
+				invalidateAnalyses(function);
+				markFunctionChanged(function);
+
+				budget -= size;
+				numUnswitched++;
+				unswitched = true;
+				break;
+			}
+		}
+	}
+
+	if (TRACING(TRACE_PASSES) && numUnswitched > 0) {
+		printf("Loop unswitching unswitched %d loops\n", numUnswitched);
+	}
+
+	countStatistic("loops unswitched", numUnswitched);
+
+	if (numUnswitched > 0) return 1; // Indicate that we made changes
+	else return 0; // No changes made
+}
+
+
+// ---- Jump threading ----
+
+// A block that ends in a conditional branch is often entered from a predecessor that already decides that
+// branch: the predecessor stored a constant into the variable the condition reads, or its own branch tested
+// the variable so that only one outcome is possible on the edge. Such a predecessor gets its own copy of the
+// block, ending in a jump straight to the successor the branch would take. What the edge implies comes from
+// the value range analysis, sharpened with the reaching stores constant propagation works from; once a path
+// has its own copy, constant propagation sees a single reaching store where there were several. Only blocks
+// of at most JUMP_THREAD_THRESHOLD instructions are copied, until the function has grown by JUMP_THREAD_BUDGET.
+// Loop headers are never threaded, since the loop would then have a second entry.
+
+#define JUMP_THREAD_THRESHOLD 6 // largest block (in instructions, besides phis and the branch) that gets copied
+#define JUMP_THREAD_BUDGET 60   // total instructions a function may grow by through threading
+
+// The successor number bb's branch takes whenever bb is entered from pred, or -1 if that is not known
+int threadedSuccessor(RangeAnalysis& ranges, unordered_map<LLVMBasicBlockRef, BBDataflow>& stores,
+		LLVMBasicBlockRef pred, LLVMBasicBlockRef bb) {
+	VariableRanges state = edgeRanges(ranges, pred, bb);
+	if (!state.reached) return -1; // The edge is never taken, branch simplification removes it
+
+	for (LLVMValueRef variable : ranges.variables) {
+		LLVMValueRef constant = reachingConstant(stores[pred].outSet, variable);
+		if (constant == NULL) continue;
+		long long value = LLVMConstIntGetSExtValue(constant);
+		ValueRange range = variableRange(state, variable);
+		if (range.empty || value < range.lo || value > range.hi) return -1;
+		setVariableRange(state, variable, makeRange(value, value));
+	}
+
+	ValueRange cond = rangeThroughEdge(ranges, pred, bb, state, LLVMGetCondition(LLVMGetBasicBlockTerminator(bb)));
+	if (cond.empty || cond.lo != cond.hi) return -1;
+	return cond.lo != 0 ? 0 : 1;
+}
+
+// Gives pred its own copy of bb that jumps to bb's successor number taken
+void threadEdge(LLVMBasicBlockRef pred, LLVMBasicBlockRef bb, unsigned taken) {
+	if (TRACING(TRACE_CHANGES)) {
+		LLVMBasicBlockRef target = LLVMGetSuccessor(LLVMGetBasicBlockTerminator(bb), taken);
+		printf("Threading %s -> %s straight to %s\n", valueName(LLVMBasicBlockAsValue(pred)).c_str(),
+			valueName(LLVMBasicBlockAsValue(bb)).c_str(), valueName(LLVMBasicBlockAsValue(target)).c_str());
+	}
+
+	LLVMBasicBlockRef copy = copyBlockForPredecessor(pred, bb);
+	foldBranch(LLVMGetBasicBlockTerminator(copy), taken);
+}
+
+int jumpThreading(LLVMModuleRef module) {
+	int numThreaded = 0;
+
+	for (LLVMValueRef function =  firstFunction(module); 
+			function; 
+			function = nextFunction(function)) {
+
+		if (!isDefinedFunction(function) || !needsVisit(function)) continue;
+
+		// The analyses are redone after every threaded edge
+		int budget = JUMP_THREAD_BUDGET;
+		bool threaded = true;
+		bool functionChanged = false;
+		while (threaded) {
+			threaded = false;
+			RangeAnalysis ranges = computeRanges(function);
+			unordered_map<LLVMBasicBlockRef, BBDataflow>& stores = cachedReachingStores(function);
+			DominatorTree& dom = cachedDominators(function);
+			unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>>& preds = cachedPredecessors(function);
+
+			for (LLVMBasicBlockRef bb : dom.rpo) {
+				LLVMValueRef branch = LLVMGetBasicBlockTerminator(bb);
+				if (LLVMGetInstructionOpcode(branch) != LLVMBr || !LLVMIsConditional(branch)) continue;
+				if (LLVMIsAConstant(LLVMGetCondition(branch)) || preds[bb].size() < 2) continue;
+				if (LLVMGetSuccessor(branch, 0) == LLVMGetSuccessor(branch, 1)) continue;
+
+				int size = 0;
+				for (LLVMValueRef inst = firstNonPhi(bb); inst != branch; inst = LLVMGetNextInstruction(inst)) size++;
+				if (size > JUMP_THREAD_THRESHOLD || size > budget) continue;
+
+				bool loopHeader = false;
+				for (LLVMBasicBlockRef pred : preds[bb]) {
+					if (dom.idom.count(pred) && dominates(dom, bb, pred)) loopHeader = true;
+				}
+				if (loopHeader || !blockValuesStayInside(bb)) continue;
+
+				for (LLVMBasicBlockRef pred : preds[bb]) {
+					if (!dom.idom.count(pred)) continue;
+					vector<LLVMBasicBlockRef> predSuccs = getSuccessors(pred);
+					LLVMValueRef predTerminator = LLVMGetBasicBlockTerminator(pred);
+					if (predSuccs.size() != LLVMGetNumSuccessors(predTerminator)) continue; // Both arms go to bb
+
+					int taken = threadedSuccessor(ranges, stores, pred, bb);
+					if (taken < 0 || LLVMGetSuccessor(branch, taken) == bb) continue;
+
+					threadEdge(pred, bb, taken);
+					invalidateAnalyses(function);
+					markFunctionChanged(function);
+					budget -= size;
+					numThreaded++;
+					threaded = true;
+					functionChanged = true;
+					break;
+				}
+				if (threaded) break;
+			}
+		}
+
+		if (functionChanged) {
+			deleteUnreachableBlocks(function);
+			mergeStraightLines(function);
+		}
+	}
+
+	if (TRACING(TRACE_PASSES) && numThreaded > 0) {
+		printf("Jump threading threaded %d edges\n", numThreaded);
+	}
+
+	countStatistic("edges threaded", numThreaded);
+
+	if (numThreaded > 0) return 1; // Indicate that we made changes
+	else return 0; // No changes made
+}
+
+// ---- Loop rotation ----
+
+// clang emits a while loop as a header that tests the condition and leaves the loop, the body, and a latch that
+// jumps back to the header: two branches per iteration. Rotation copies the header twice. One copy is a guard in
+// front of the loop that skips it when the condition fails on entry, the other is appended to the latch, so the
+// test moves to the bottom of the body and the back edge is the only branch left per iteration. The guard
+// enters the loop through a block of its own, the preheader. Headers of more than ROTATE_MAX_HEADER
+// instructions (besides phis and the branch) are left alone.
+
+#define ROTATE_MAX_HEADER 8
+
+bool rotateLoop(LLVMValueRef function, Loop& loop) {
+	LLVMBasicBlockRef header = loop.header;
+	if (loop.latches.size() != 1 || loop.latches[0] == header) return false;
+	LLVMBasicBlockRef latch = loop.latches[0];
+	if (LLVMGetNumSuccessors(LLVMGetBasicBlockTerminator(latch)) != 1) return false; // Already tested at the bottom
+
+	// The header must be the loop's exit test
+	LLVMValueRef branch = LLVMGetBasicBlockTerminator(header);
+	if (LLVMGetInstructionOpcode(branch) != LLVMBr || !LLVMIsConditional(branch)) return false;
+	LLVMBasicBlockRef succs[2] = { LLVMGetSuccessor(branch, 0), LLVMGetSuccessor(branch, 1) };
+	if (loop.contains.count(succs[0]) == loop.contains.count(succs[1])) return false;
+	LLVMBasicBlockRef body = loop.contains.count(succs[0]) ? succs[0] : succs[1];
+
+	int size = 0;
+	for (LLVMValueRef inst = firstNonPhi(header); inst != branch; inst = LLVMGetNextInstruction(inst)) size++;
+	if (size > ROTATE_MAX_HEADER || !blockValuesStayInside(header)) return false;
+
+	unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>> preds = computePredecessors(function);
+	LLVMBasicBlockRef preheader = loopPreheader(loop, preds);
+	if (preheader == NULL) return false;
+
+	if (TRACING(TRACE_CHANGES)) {
+		printf("Rotating loop at %s\n", valueName(LLVMBasicBlockAsValue(header)).c_str());
+	}
+
+	LLVMBasicBlockRef guard = copyBlockForPredecessor(preheader, header);
+	copyBlockForPredecessor(latch, header);
+	deleteUnreachableBlocks(function); // The original header
+	splitEdge(guard, body);
+	mergeStraightLines(function);
+	return true;
+}
+
+int loopRotation(LLVMModuleRef module) {
+	int numRotated = 0;
+
+	for (LLVMValueRef function =  firstFunction(module); 
+			function; 
+			function = nextFunction(function)) {
+
+		if (!isDefinedFunction(function) || !needsVisit(function)) continue;
+
+		// Loops are found again after every rotation; a rotated loop no longer qualifies
+		bool rotated = true;
+		while (rotated) {
+			rotated = false;
+			vector<Loop>& loops = cachedLoops(function);
+			for (Loop& loop : loops) {
+				if (!rotateLoop(function, loop)) continue;
+				invalidateAnalyses(function);
+				markFunctionChanged(function);
+				numRotated++;
+				rotated = true;
+				break;
+			}
+		}
+	}
+
+	if (TRACING(TRACE_PASSES) && numRotated > 0) {
+		printf("Loop rotation rotated %d loops\n", numRotated);
+	}
+
+	countStatistic("loops rotated", numRotated);
+
+	if (numRotated > 0) return 1; // Indicate that we made changes
+	else return 0; // No changes made
+}
+
+// ---- Scalar promotion ----
+
+// A local variable that a loop reads and writes is kept in a register for the duration of the loop: it is
+// loaded once in the preheader, carried around the loop by phis, and stored back on each edge leaving the
+// loop (only when the loop stores it). The loads and stores inside the loop disappear. The values it holds
+// inside the loop are found on demand, walking up from each load to the nearest store, with a phi wherever
+// several paths meet; phis that turn out to merge one value are removed at the end. Inner loops are
+// promoted first, which moves their accesses into the enclosing loop for it to promote in turn.
+
+struct PromotedVariable {
+	LLVMValueRef variable;
+	unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>> preds;
+	unordered_map<LLVMBasicBlockRef, LLVMValueRef> atEntry; // value on entry to each block
+	unordered_map<LLVMBasicBlockRef, LLVMValueRef> atEnd;   // and on leaving it; the preheader holds the initial load
+	vector<LLVMValueRef> phis;
+};
+
+LLVMValueRef promotedValueAtEnd(PromotedVariable& promoted, LLVMBasicBlockRef bb);
+
+LLVMValueRef promotedValueAtEntry(PromotedVariable& promoted, LLVMBasicBlockRef bb) {
+	auto it = promoted.atEntry.find(bb);
+	if (it != promoted.atEntry.end()) return it->second;
+
+	vector<LLVMBasicBlockRef>& preds = promoted.preds[bb];
+	if (preds.size() == 1) {
+		LLVMValueRef value = promotedValueAtEnd(promoted, preds[0]);
+		promoted.atEntry[bb] = value;
+		return value;
+	}
+
+	// The phi is recorded before its incoming values are looked up, so walking around the loop ends at it
+	LLVMBuilderRef builder = LLVMCreateBuilderInContext(blockContext(bb));
+	LLVMPositionBuilder(builder, bb, LLVMGetFirstInstruction(bb));
+	LLVMValueRef phi = LLVMBuildPhi(builder, LLVMGetAllocatedType(promoted.variable), "");
+	LLVMDisposeBuilder(builder);
+	promoted.atEntry[bb] = phi;
+	promoted.phis.push_back(phi);
+
+	for (LLVMBasicBlockRef pred : preds) {
+		LLVMValueRef value = promotedValueAtEnd(promoted, pred);
+		LLVMValueRef terminator = LLVMGetBasicBlockTerminator(pred);
+		unsigned numSuccessors = LLVMGetNumSuccessors(terminator);
+		for (unsigned i = 0; i < numSuccessors; i++) {
+			if (LLVMGetSuccessor(terminator, i) == bb) LLVMAddIncoming(phi, &value, &pred, 1); // One entry per edge
+		}
+	}
+	return phi;
+}
+
+LLVMValueRef promotedValueAtEnd(PromotedVariable& promoted, LLVMBasicBlockRef bb) {
+	auto it = promoted.atEnd.find(bb);
+	if (it != promoted.atEnd.end()) return it->second;
+
+	LLVMValueRef value = NULL;
+	for (LLVMValueRef inst = LLVMGetLastInstruction(bb); inst && value == NULL; inst = LLVMGetPreviousInstruction(inst)) {
+		if (LLVMIsAStoreInst(inst) && LLVMGetOperand(inst, 1) == promoted.variable) value = LLVMGetOperand(inst, 0);
+	}
+	if (value == NULL) value = promotedValueAtEntry(promoted, bb);
+	promoted.atEnd[bb] = value;
+	return value;
+}
+
+// The value a replaced load finally stands for, following loads replaced by other loads
+LLVMValueRef promotedReplacement(unordered_map<LLVMValueRef, LLVMValueRef>& replacements, LLVMValueRef value) {
+	auto it = replacements.find(value);
+	while (it != replacements.end()) {
+		value = it->second;
+		it = replacements.find(value);
+	}
+	return value;
+}
+
+// Whether every access of variable inside loop is a plain load or store of its allocated type, and there is one
+bool promotableInLoop(LLVMValueRef variable, Loop& loop) {
+	LLVMTypeRef type = LLVMGetAllocatedType(variable);
+	bool accessed = false;
+	for (LLVMUseRef use = LLVMGetFirstUse(variable); use; use = LLVMGetNextUse(use)) {
+		LLVMValueRef user = LLVMGetUser(use);
+		if (!loop.contains.count(LLVMGetInstructionParent(user))) continue;
+		LLVMTypeRef accessType = LLVMIsALoadInst(user) ? LLVMTypeOf(user) : LLVMTypeOf(LLVMGetOperand(user, 0));
+		if (accessType != type || LLVMGetVolatile(user)) return false;
+		accessed = true;
+	}
+	return accessed;
+}
+
+void promoteInLoop(LLVMValueRef function, Loop& loop, LLVMBasicBlockRef preheader, LLVMValueRef variable) {
+	if (TRACING(TRACE_CHANGES)) {
+		printf("Promoting %s in the loop at %s\n", valueName(variable).c_str(),
+			valueName(LLVMBasicBlockAsValue(loop.header)).c_str());
+	}
+
+	LLVMBuilderRef builder = LLVMCreateBuilderInContext(blockContext(preheader));
+	LLVMPositionBuilderBefore(builder, LLVMGetBasicBlockTerminator(preheader));
+	LLVMValueRef initial = LLVMBuildLoad2(builder, LLVMGetAllocatedType(variable), variable, "");
+
+	PromotedVariable promoted;
+	promoted.variable = variable;
+	promoted.preds = computePredecessors(function);
+	promoted.atEnd[preheader] = initial;
+
+	// Find the value of every load and leaving edge first, then rewrite
+	unordered_map<LLVMValueRef, LLVMValueRef> replacements;
+	vector<LLVMValueRef> accesses;
+	bool stored = false;
+	for (LLVMBasicBlockRef bb : loop.blocks) {
+		LLVMValueRef current = NULL;
+		for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+			if (LLVMIsAStoreInst(inst) && LLVMGetOperand(inst, 1) == variable) {
+				current = LLVMGetOperand(inst, 0);
+				accesses.push_back(inst);
+				stored = true;
+			} else if (LLVMIsALoadInst(inst) && LLVMGetOperand(inst, 0) == variable) {
+				replacements[inst] = current ? current : promotedValueAtEntry(promoted, bb);
+				accesses.push_back(inst);
+			}
+		}
+	}
+	vector<pair<LLVMBasicBlockRef, LLVMBasicBlockRef>> exits;
+	vector<LLVMValueRef> exitValues;
+	if (stored) {
+		for (LLVMBasicBlockRef bb : loop.blocks) {
+			for (LLVMBasicBlockRef succ : getSuccessors(bb)) {
+				if (loop.contains.count(succ)) continue;
+				exits.push_back(make_pair(bb, succ));
+				exitValues.push_back(promotedValueAtEnd(promoted, bb));
+			}
+		}
+	}
+
+	for (auto& entry : replacements) {
+		LLVMReplaceAllUsesWith(entry.first, promotedReplacement(replacements, entry.first));
+	}
+	for (size_t e = 0; e < exits.size(); e++) {
+		LLVMBasicBlockRef mid = splitEdge(exits[e].first, exits[e].second);
+		LLVMPositionBuilderBefore(builder, LLVMGetBasicBlockTerminator(mid));
+		LLVMBuildStore(builder, promotedReplacement(replacements, exitValues[e]), variable);
+	}
+	for (LLVMValueRef inst : accesses) {
+		LLVMInstructionEraseFromParent(inst);
+	}
+	LLVMDisposeBuilder(builder);
+
+	// Drop the phis that merge a single value (besides themselves)
+	bool removed = true;
+	while (removed) {
+		removed = false;
+		for (LLVMValueRef& phi : promoted.phis) {
+			if (phi == NULL) continue;
+			LLVMValueRef same = NULL;
+			bool trivial = true;
+			unsigned numIncoming = LLVMCountIncoming(phi);
+			for (unsigned i = 0; i < numIncoming; i++) {
+				LLVMValueRef value = LLVMGetIncomingValue(phi, i);
+				if (value == phi || value == same) continue;
+				if (same != NULL) trivial = false;
+				same = value;
+			}
+			if (!trivial || same == NULL) continue;
+			LLVMReplaceAllUsesWith(phi, same);
+			LLVMInstructionEraseFromParent(phi);
+			phi = NULL;
+			removed = true;
+		}
+	}
+}
+
+int scalarPromotion(LLVMModuleRef module) {
+	int numPromoted = 0;
+
+	for (LLVMValueRef function =  firstFunction(module); 
+			function; 
+			function = nextFunction(function)) {
+
+		if (!isDefinedFunction(function) || !needsVisit(function)) continue;
+
+		vector<LLVMValueRef> variables;
+		LLVMBasicBlockRef entry = LLVMGetEntryBasicBlock(function);
+		for (LLVMValueRef inst = LLVMGetFirstInstruction(entry); inst; inst = LLVMGetNextInstruction(inst)) {
+			if (LLVMIsAAllocaInst(inst) && isLocalVariable(inst)) variables.push_back(inst);
+		}
+
+		// Loops are found again after each promoted loop, since exits were split; inner loops come first
+		bool promoted = true;
+		bool functionChanged = false;
+		while (promoted) {
+			promoted = false;
+			vector<Loop>& loops = cachedLoops(function);
+			for (Loop& loop : loops) {
+				vector<LLVMValueRef> promotable;
+				for (LLVMValueRef variable : variables) {
+					if (promotableInLoop(variable, loop)) promotable.push_back(variable);
+				}
+				if (promotable.empty()) continue;
+
+				LLVMBasicBlockRef preheader = loopPreheader(loop, cachedPredecessors(function));
+				if (preheader == NULL) continue;
+
+				for (LLVMValueRef variable : promotable) {
+					promoteInLoop(function, loop, preheader, variable);
+					numPromoted++;
+				}
+				invalidateAnalyses(function);
+				markFunctionChanged(function);
+				promoted = true;
+				functionChanged = true;
+				break;
+			}
+		}
+
+		if (functionChanged) mergeStraightLines(function);
+	}
+
+	if (TRACING(TRACE_PASSES) && numPromoted > 0) {
+		printf("Scalar promotion promoted %d variables\n", numPromoted);
+	}
+
+	countStatistic("variables promoted", numPromoted);
+
+	if (numPromoted > 0) return 1; // Indicate that we made changes
+	else return 0; // No changes made
+}
+
+// ---- Code sinking ----
+
+// An instruction whose result is only needed on some of the paths leaving its block is moved down to the
+// nearest block that dominates all of its uses, right before the first of them. That block must lie inside one
+// arm of the branch ending the original block, so the instruction runs less often, and sinking never enters a
+// loop the instruction was not already in. Loads move only into an arm directly below their block, and only
+// when nothing after them in the block may write the memory they read; in the arm they go before the first
+// write that may come ahead of their first user, if there is one. Sinking runs last, once dead stores are
+// gone (their values count as uses), and outside the main loop so it does not compete with the passes that hoist.
+
+// Instructions without side effects that may run on fewer paths
+bool isSinkable(LLVMValueRef inst) {
+	return LLVMIsABinaryOperator(inst) || LLVMIsAICmpInst(inst) || LLVMIsASelectInst(inst) || LLVMIsACastInst(inst)
+		|| LLVMIsAGetElementPtrInst(inst);
+}
+
+// Whether the instructions from first up to (not including) last leave the memory load reads alone; a NULL
+// last runs to the end of the block
+bool loadStaysValid(LLVMValueRef load, LLVMValueRef first, LLVMValueRef last) {
+	LLVMValueRef address = LLVMGetOperand(load, 0);
+	bool local = isLocalVariable(address);
+	for (LLVMValueRef inst = first; inst != last; inst = LLVMGetNextInstruction(inst)) {
+		if (LLVMIsAStoreInst(inst) && (!local || LLVMGetOperand(inst, 1) == address)) return false;
+		if (LLVMIsACallInst(inst) && !local) return false;
+	}
+	return true;
+}
+
+// The block inst should move to, or NULL to leave it where it is
+LLVMBasicBlockRef sinkTarget(LLVMValueRef inst, DominatorTree& dom, vector<Loop>& loops,
+		unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>>& preds) {
+	LLVMBasicBlockRef bb = LLVMGetInstructionParent(inst);
+	LLVMBasicBlockRef target = NULL;
+	for (LLVMUseRef use = LLVMGetFirstUse(inst); use; use = LLVMGetNextUse(use)) {
+		LLVMValueRef user = LLVMGetUser(use);
+		LLVMBasicBlockRef useBlock = LLVMGetInstructionParent(user);
+		if (LLVMIsAPHINode(user)) {
+			// A phi uses its incoming values at the end of the incoming blocks
+			unsigned numIncoming = LLVMCountIncoming(user);
+			for (unsigned i = 0; i < numIncoming; i++) {
+				if (LLVMGetIncomingValue(user, i) != inst) continue;
+				useBlock = LLVMGetIncomingBlock(user, i);
+				if (!dom.idom.count(useBlock) || useBlock == bb) return NULL;
+				target = target ? nearestCommonDominator(dom, target, useBlock) : useBlock;
+			}
+			continue;
+		}
+		if (!dom.idom.count(useBlock) || useBlock == bb) return NULL;
+		target = target ? nearestCommonDominator(dom, target, useBlock) : useBlock;
+	}
+	if (target == NULL || target == bb) return NULL;
+
+	// Back out of loops the instruction is not in
+	int depth = loopDepth(loops, bb);
+	while (target != bb && loopDepth(loops, target) > depth) target = dom.idom[target];
+	if (target == bb) return NULL;
+
+	// The block right below bb on the way to target has to be an arm of bb's branch
+	LLVMBasicBlockRef arm = target;
+	while (dom.idom[arm] != bb) arm = dom.idom[arm];
+	if (preds[arm].size() != 1 || getSuccessors(bb).size() < 2) return NULL;
+
+	if (LLVMIsALoadInst(inst) && (target != arm || !loadStaysValid(inst, LLVMGetNextInstruction(inst), NULL))) {
+		return NULL;
+	}
+	return target;
+}
+
+int codeSinking(LLVMModuleRef module) {
+	int numSunk = 0;
+
+	for (LLVMValueRef function =  firstFunction(module); 
+			function; 
+			function = nextFunction(function)) {
+
+		if (!isDefinedFunction(function) || !needsVisit(function)) continue;
+
+		// Moving instructions leaves the CFG alone, so the analyses hold throughout
+		DominatorTree& dom = cachedDominators(function);
+		vector<Loop>& loops = cachedLoops(function);
+		unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>>& preds = cachedPredecessors(function);
+		LLVMBuilderRef builder = LLVMCreateBuilderInContext(LLVMGetModuleContext(module));
+
+		// Blocks in reverse post-order, so a sunk instruction can sink again from its new block; instructions
+		// bottom-up, so the operands of a sunk instruction see its new place
+		for (LLVMBasicBlockRef bb : dom.rpo) {
+			LLVMValueRef inst = LLVMGetLastInstruction(bb);
+			while (inst) {
+				LLVMValueRef prev = LLVMGetPreviousInstruction(inst);
+				if (!isSinkable(inst) && !LLVMIsALoadInst(inst)) {
+					inst = prev;
+					continue;
+				}
+				LLVMBasicBlockRef target = sinkTarget(inst, dom, loops, preds);
+				if (target == NULL) {
+					inst = prev;
+					continue;
+				}
+
+				LLVMValueRef before = LLVMGetBasicBlockTerminator(target);
+				for (LLVMValueRef other = firstNonPhi(target); other != before; other = LLVMGetNextInstruction(other)) {
+					bool uses = false;
+					int numOperands = LLVMGetNumOperands(other);
+					for (int i = 0; i < numOperands; i++) {
+						if (LLVMGetOperand(other, i) == inst) uses = true;
+					}
+					if (uses) {
+						before = other;
+						break;
+					}
+				}
+				// A load cannot pass a write to its memory on the way down
+				if (LLVMIsALoadInst(inst) && !loadStaysValid(inst, firstNonPhi(target), before)) {
+					before = firstNonPhi(target);
+				}
+
+				if (TRACING(TRACE_CHANGES)) {
+					printf("Sinking into %s:\n", valueName(LLVMBasicBlockAsValue(target)).c_str());
+					LLVMDumpValue(inst);
+					printf("\n");
+				}
+				LLVMPositionBuilderBefore(builder, before);
+				moveInstruction(builder, inst);
+				markFunctionChanged(function);
+				numSunk++;
+				inst = prev;
+			}
+		}
+
+		LLVMDisposeBuilder(builder);
+	}
+
+	if (TRACING(TRACE_PASSES) && numSunk > 0) {
+		printf("Code sinking moved %d instructions\n", numSunk);
+	}
+
+	countStatistic("instructions sunk", numSunk);
+
+	if (numSunk > 0) return 1; // Indicate that we made changes
+	else return 0; // No changes made
+}
+
+// ---- Scalar evolution ----
+
+// A value that changes by the same amount on every iteration of a loop is an add-recurrence: in iteration k
+// (counting from 0) it is base * scale + offset + step * k, where base is a value from before the loop. The
+// header phis that add a constant each time around are the starting points; sums, differences and constant
+// multiples of recurrences are recurrences too. All coefficients are kept modulo 2^width, like the IR computes.
+//
+// A rotated loop that is only left at the bottom, where a recurrence X is compared to a value B from before the
+// loop, leaves in an iteration that follows in closed form: counting up by one while X < B (or down while
+// X > B) it stops once X reaches B, or at once when X already started past it; counting by one while X != B it
+// stops at B. With constant bounds other steps work too. Values computed in the loop and used after it are
+// then computed after the loop directly from that iteration, and a loop left with no side effects and no
+// uses is deleted.
+
+struct Recurrence {
+	bool valid;
+	LLVMValueRef base; // from before the loop, or NULL
+	uint64_t scale;
+	uint64_t offset;
+	uint64_t step;
+};
+
+Recurrence invalidRecurrence() {
+	Recurrence r = { false, NULL, 0, 0, 0 };
+	return r;
+}
+
+Recurrence recurrenceOf(LLVMValueRef value, Loop& loop, unordered_map<LLVMValueRef, Recurrence>& phis) {
+	if (LLVMGetTypeKind(LLVMTypeOf(value)) != LLVMIntegerTypeKind || LLVMGetIntTypeWidth(LLVMTypeOf(value)) > 64) {
+		return invalidRecurrence();
+	}
+	if (LLVMIsAConstantInt(value)) {
+		Recurrence r = { true, NULL, 0, LLVMConstIntGetZExtValue(value), 0 };
+		return r;
+	}
+	if (LLVMIsAConstant(value)) return invalidRecurrence();
+	if (!LLVMIsAInstruction(value) || !loop.contains.count(LLVMGetInstructionParent(value))) {
+		Recurrence r = { true, value, 1, 0, 0 };
+		return r;
+	}
+	if (LLVMIsAPHINode(value)) {
+		auto it = phis.find(value);
+		return it == phis.end() ? invalidRecurrence() : it->second;
+	}
+
+	LLVMOpcode opcode = LLVMGetInstructionOpcode(value);
+	if (opcode != LLVMAdd && opcode != LLVMSub && opcode != LLVMMul && opcode != LLVMShl) return invalidRecurrence();
+	Recurrence a = recurrenceOf(LLVMGetOperand(value, 0), loop, phis);
+	Recurrence b = recurrenceOf(LLVMGetOperand(value, 1), loop, phis);
+	if (!a.valid || !b.valid) return invalidRecurrence();
+
+	if (opcode == LLVMAdd || opcode == LLVMSub) {
+		if (a.base && b.base && a.base != b.base) return invalidRecurrence();
+		uint64_t sign = opcode == LLVMAdd ? 1 : (uint64_t)-1;
+		Recurrence r = { true, a.base ? a.base : b.base, a.scale + sign * b.scale, a.offset + sign * b.offset,
+			a.step + sign * b.step };
+		return r;
+	}
+
+	// A multiple of a recurrence by a constant
+	if (opcode == LLVMShl) {
+		if (b.base || b.step || b.offset >= LLVMGetIntTypeWidth(LLVMTypeOf(value))) return invalidRecurrence();
+		b.offset = 1ULL << b.offset;
+	} else if (a.base == NULL && a.step == 0) {
+		swap(a, b);
+	}
+	if (b.base || b.step) return invalidRecurrence();
+	Recurrence r = { true, a.base, a.scale * b.offset, a.offset * b.offset, a.step * b.offset };
+	return r;
+}
+
+// The header phis of loop that are add-recurrences
+unordered_map<LLVMValueRef, Recurrence> headerRecurrences(Loop& loop, LLVMBasicBlockRef preheader, LLVMBasicBlockRef latch) {
+	unordered_map<LLVMValueRef, Recurrence> recurrences;
+	for (LLVMValueRef phi = LLVMGetFirstInstruction(loop.header); phi && LLVMIsAPHINode(phi); phi = LLVMGetNextInstruction(phi)) {
+		if (LLVMCountIncoming(phi) != 2) continue;
+		LLVMValueRef start = NULL, next = NULL;
+		for (unsigned i = 0; i < 2; i++) {
+			if (LLVMGetIncomingBlock(phi, i) == preheader) start = LLVMGetIncomingValue(phi, i);
+			if (LLVMGetIncomingBlock(phi, i) == latch) next = LLVMGetIncomingValue(phi, i);
+		}
+		if (start == NULL || next == NULL) continue;
+
+		// The value around the back edge has to be the phi plus a constant
+		unordered_map<LLVMValueRef, Recurrence> self;
+		Recurrence itself = { true, phi, 1, 0, 0 };
+		self[phi] = itself;
+		Recurrence increment = recurrenceOf(next, loop, self);
+		if (!increment.valid || increment.base != phi || increment.scale != 1 || increment.step != 0) continue;
+
+		Recurrence r = recurrenceOf(start, loop, self);
+		if (!r.valid) continue;
+		r.step = increment.offset;
+		recurrences[phi] = r;
+	}
+	return recurrences;
+}
+
+// base * scale + offset + step * k, built before builder's position; k may be NULL for iteration 0
+LLVMValueRef buildRecurrence(LLVMBuilderRef builder, Recurrence& r, LLVMTypeRef type, LLVMValueRef k) {
+	unsigned width = LLVMGetIntTypeWidth(type);
+	LLVMValueRef value = NULL;
+	if (r.base && truncateBits(r.scale, width) != 0) {
+		value = truncateBits(r.scale, width) == 1 ? r.base : LLVMBuildMul(builder, r.base, LLVMConstInt(type, r.scale, 0), "");
+	}
+	uint64_t step = truncateBits(r.step, width);
+	if (k && step == truncateBits(-1, width)) {
+		value = value ? LLVMBuildSub(builder, value, k, "") : LLVMBuildNeg(builder, k, "");
+	} else if (k && step != 0) {
+		LLVMValueRef term = step == 1 ? k : LLVMBuildMul(builder, k, LLVMConstInt(type, r.step, 0), "");
+		value = value ? LLVMBuildAdd(builder, value, term, "") : term;
+	}
+	if (value == NULL) return LLVMConstInt(type, r.offset, 0);
+	if (truncateBits(r.offset, width) != 0) value = LLVMBuildAdd(builder, value, LLVMConstInt(type, r.offset, 0), "");
+	return value;
+}
+
+// The iteration a loop counting X by step from x0 leaves in, while X predicate bound holds, with constants
+bool constantTripCount(LLVMIntPredicate predicate, long long x0, long long step, long long bound, unsigned width,
+		long long& trip) {
+	long long maximum = signedBits((1ULL << (width - 1)) - 1, width);
+	long long minimum = -maximum - 1;
+	if (width > 32 || step == 0) return false; // Keeps the arithmetic below inside a long long
+
+	if (predicate == LLVMIntSLE || predicate == LLVMIntSGE) {
+		if (bound == (predicate == LLVMIntSLE ? maximum : minimum)) return false; // Never fails
+		bound += predicate == LLVMIntSLE ? 1 : -1;
+		predicate = predicate == LLVMIntSLE ? LLVMIntSLT : LLVMIntSGT;
+	}
+	if (predicate == LLVMIntSLT && step > 0) {
+		trip = x0 >= bound ? 0 : (bound - x0 + step - 1) / step;
+		return x0 + step * trip <= maximum;
+	}
+	if (predicate == LLVMIntSGT && step < 0) {
+		trip = x0 <= bound ? 0 : (x0 - bound - step - 1) / -step;
+		return x0 + step * trip >= minimum;
+	}
+	if (predicate == LLVMIntNE) {
+		if ((bound - x0) % step != 0 || (bound - x0) / step < 0) return false;
+		trip = (bound - x0) / step;
+		return true;
+	}
+	return false;
+}
+
+// Whether an instruction may be dropped when its loop is deleted
+bool removableWithLoop(LLVMValueRef inst) {
+	if (LLVMIsAStoreInst(inst) || LLVMIsACallInst(inst) || LLVMIsAAllocaInst(inst)) return false;
+	if (LLVMIsALoadInst(inst)) return !LLVMGetVolatile(inst);
+	LLVMOpcode opcode = LLVMGetInstructionOpcode(inst);
+	if (opcode == LLVMSDiv || opcode == LLVMUDiv || opcode == LLVMSRem || opcode == LLVMURem) {
+		LLVMValueRef divisor = LLVMGetOperand(inst, 1);
+		return LLVMIsAConstantInt(divisor) && LLVMConstIntGetZExtValue(divisor) != 0
+			&& !(opcode == LLVMSDiv || opcode == LLVMSRem ? LLVMConstIntGetSExtValue(divisor) == -1 : false);
+	}
+	return true;
+}
+
+bool evolveLoop(LLVMValueRef function, Loop& loop) {
+	if (loop.latches.size() != 1) return false;
+	LLVMBasicBlockRef latch = loop.latches[0];
+	LLVMValueRef branch = LLVMGetBasicBlockTerminator(latch);
+	if (LLVMGetInstructionOpcode(branch) != LLVMBr || !LLVMIsConditional(branch)) return false;
+	bool continueOnTrue = LLVMGetSuccessor(branch, 0) == loop.header;
+	LLVMBasicBlockRef exit = LLVMGetSuccessor(branch, continueOnTrue ? 1 : 0);
+	if (loop.contains.count(exit) || LLVMGetSuccessor(branch, continueOnTrue ? 0 : 1) != loop.header) return false;
+
+	// Only the latch leaves the loop, and a preheader leads in
+	for (LLVMBasicBlockRef bb : loop.blocks) {
+		if (bb == latch) continue;
+		for (LLVMBasicBlockRef succ : getSuccessors(bb)) {
+			if (!loop.contains.count(succ)) return false;
+		}
+	}
+	LLVMBasicBlockRef preheader = NULL;
+	unordered_map<LLVMBasicBlockRef, vector<LLVMBasicBlockRef>> preds = computePredecessors(function);
+	for (LLVMBasicBlockRef pred : preds[loop.header]) {
+		if (loop.contains.count(pred)) continue;
+		if (preheader) return false;
+		preheader = pred;
+	}
+	if (preheader == NULL || LLVMGetNumSuccessors(LLVMGetBasicBlockTerminator(preheader)) != 1) return false;
+
+	// The exit test: X compared to a bound from before the loop
+	LLVMValueRef cond = LLVMGetCondition(branch);
+	if (!LLVMIsAICmpInst(cond)) return false;
+	unordered_map<LLVMValueRef, Recurrence> phis = headerRecurrences(loop, preheader, latch);
+	LLVMIntPredicate predicate = LLVMGetICmpPredicate(cond);
+	if (!continueOnTrue) predicate = inversePredicate(predicate);
+	LLVMValueRef x = LLVMGetOperand(cond, 0);
+	LLVMValueRef bound = LLVMGetOperand(cond, 1);
+	if (LLVMIsAInstruction(x) && !loop.contains.count(LLVMGetInstructionParent(x))) {
+		swap(x, bound);
+		predicate = swappedPredicate(predicate);
+	}
+	if (LLVMIsAInstruction(bound) && loop.contains.count(LLVMGetInstructionParent(bound))) return false;
+	Recurrence rx = recurrenceOf(x, loop, phis);
+	LLVMTypeRef type = LLVMTypeOf(x);
+	if (!rx.valid || truncateBits(rx.step, LLVMGetIntTypeWidth(type)) == 0) return false;
+	unsigned width = LLVMGetIntTypeWidth(type);
+	long long step = signedBits(truncateBits(rx.step, width), width);
+
+	bool symbolic = (step == 1 && predicate == LLVMIntSLT) || (step == -1 && predicate == LLVMIntSGT)
+		|| ((step == 1 || step == -1) && predicate == LLVMIntNE);
+	long long trip = 0;
+	if (!symbolic) {
+		if (rx.base || !LLVMIsAConstantInt(bound)) return false;
+		if (!constantTripCount(predicate, signedBits(truncateBits(rx.offset, width), width), step,
+				LLVMConstIntGetSExtValue(bound), width, trip)) return false;
+	}
+
+	// Values used after the loop, and whether anything else keeps the loop alive
+	vector<LLVMValueRef> liveOut;
+	bool removable = true;
+	for (LLVMBasicBlockRef bb : loop.blocks) {
+		for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+			if (!LLVMIsATerminatorInst(inst) && !removableWithLoop(inst)) removable = false;
+			bool usedOutside = false;
+			for (LLVMUseRef use = LLVMGetFirstUse(inst); use; use = LLVMGetNextUse(use)) {
+				if (!loop.contains.count(LLVMGetInstructionParent(LLVMGetUser(use)))) usedOutside = true;
+			}
+			if (!usedOutside) continue;
+			if (recurrenceOf(inst, loop, phis).valid) liveOut.push_back(inst);
+			else removable = false;
+		}
+	}
+	if (liveOut.empty() && !removable) return false;
+
+	if (TRACING(TRACE_CHANGES)) {
+		printf("Loop at %s leaves after a computable number of iterations%s\n",
+			valueName(LLVMBasicBlockAsValue(loop.header)).c_str(), removable ? ", deleting it" : "");
+	}
+
+	// The values of the last iteration, computed on the way out
+	LLVMBasicBlockRef after = splitEdge(latch, exit);
+	LLVMBuilderRef builder = LLVMCreateBuilderInContext(blockContext(after));
+	LLVMPositionBuilderBefore(builder, LLVMGetBasicBlockTerminator(after));
+	LLVMValueRef k;
+	LLVMValueRef last = NULL; // X in the last iteration
+	if (symbolic) {
+		LLVMValueRef x0 = buildRecurrence(builder, rx, type, NULL);
+		last = bound;
+		if (predicate != LLVMIntNE) {
+			LLVMValueRef past = LLVMBuildICmp(builder, predicate, x0, bound, "");
+			last = LLVMBuildSelect(builder, past, bound, x0, "");
+		}
+		k = step == 1 ? LLVMBuildSub(builder, last, x0, "") : LLVMBuildSub(builder, x0, last, "");
+	} else {
+		k = LLVMConstInt(type, trip, 1);
+	}
+	for (LLVMValueRef inst : liveOut) {
+		Recurrence r = recurrenceOf(inst, loop, phis);
+		LLVMTypeRef instType = LLVMTypeOf(inst);
+		LLVMValueRef iteration = instType == type ? k : LLVMBuildIntCast2(builder, k, instType, 0, "");
+		bool sameAsX = r.base == rx.base && r.scale == rx.scale && r.offset == rx.offset && r.step == rx.step;
+		LLVMValueRef closed = last && sameAsX && instType == type ? last : buildRecurrence(builder, r, instType, iteration);
+
+		vector<LLVMValueRef> users;
+		for (LLVMUseRef use = LLVMGetFirstUse(inst); use; use = LLVMGetNextUse(use)) {
+			LLVMValueRef user = LLVMGetUser(use);
+			if (!loop.contains.count(LLVMGetInstructionParent(user)) && find(users.begin(), users.end(), user) == users.end()) {
+				users.push_back(user);
+			}
+		}
+		for (LLVMValueRef user : users) {
+			int numOperands = LLVMGetNumOperands(user);
+			for (int i = 0; i < numOperands; i++) {
+				if (LLVMGetOperand(user, i) == inst) LLVMSetOperand(user, i, closed);
+			}
+		}
+	}
+	LLVMDisposeBuilder(builder);
+
+	if (removable) {
+		LLVMSetSuccessor(LLVMGetBasicBlockTerminator(preheader), 0, after);
+		deleteUnreachableBlocks(function);
+	}
+	mergeStraightLines(function);
+	return true;
+}
+
+int scalarEvolution(LLVMModuleRef module) {
+	int numEvolved = 0;
+
+	for (LLVMValueRef function =  firstFunction(module); 
+			function; 
+			function = nextFunction(function)) {
+
+		if (!isDefinedFunction(function) || !needsVisit(function)) continue;
+
+		// Loops are found again after every rewritten loop, inner loops first
+		bool evolved = true;
+		while (evolved) {
+			evolved = false;
+			vector<Loop>& loops = cachedLoops(function);
+			for (Loop& loop : loops) {
+				if (!evolveLoop(function, loop)) continue;
+				invalidateAnalyses(function);
+				markFunctionChanged(function);
+				numEvolved++;
+				evolved = true;
+				break;
+			}
+		}
+	}
+
+	if (TRACING(TRACE_PASSES) && numEvolved > 0) {
+		printf("Scalar evolution rewrote %d loops\n", numEvolved);
+	}
+
+	countStatistic("loops evolved", numEvolved);
+
+	if (numEvolved > 0) return 1; // Indicate that we made changes
+	else return 0; // No changes made
+}
+
+// ---- Equality saturation ----
+
+// An optional alternative to the greedy arithmetic rewrites (enabled with -egraph). The add, sub, mul and shl
+// instructions of a block form an expression DAG over leaves (everything else) and constants, which is loaded
+// into an e-graph: classes of expressions known to be equal, each a set of nodes whose operands are classes.
+// Rewrite rules (commutativity, associativity, distributivity in both directions, identities, cancellation,
+// shifts as multiplications and back, constant folding) only ever add nodes and merge classes, so all forms
+// stay available at once, until nothing new appears or the graph reaches EGRAPH_MAX_NODES nodes or
+// EGRAPH_MAX_MATCHES rule matches (checked as the rules go, since one round of them can multiply the graph).
+// Both limits count work rather than time, so the result does not depend on the machine or on what other
+// threads are doing; EGRAPH_TIME_LIMIT_MS is only a safety net. Then the cheapest form of every value used
+// outside the DAG is extracted under a latency model (mul 3, add/sub/shl 1) and rebuilt, but only when it
+// beats the original. A value may only be rebuilt from leaves that already exist where it is computed.
+
+#define EGRAPH_MAX_NODES 2000      // stop saturating once the graph has this many nodes
+#define EGRAPH_MAX_ITERATIONS 12   // rounds of rule application per block
+#define EGRAPH_MAX_MATCHES 50000   // rule matches per block
+#define EGRAPH_TIME_LIMIT_MS 1000  // per block, in CPU time of the thread; not reached within the other limits
+
+double cpuMilliseconds();
+
+enum EOp { E_LEAF, E_CONST, E_ADD, E_SUB, E_MUL, E_SHL };
+
+struct ENode {
+	EOp op;
+	LLVMTypeRef type;
+	int a, b;            // operand classes
+	uint64_t constant;   // E_CONST
+	LLVMValueRef leaf;   // E_LEAF
+
+	bool operator<(const ENode& other) const {
+		if (op != other.op) return op < other.op;
+		if (type != other.type) return type < other.type;
+		if (a != other.a) return a < other.a;
+		if (b != other.b) return b < other.b;
+		if (constant != other.constant) return constant < other.constant;
+		return leaf < other.leaf;
+	}
+};
+
+struct EGraph {
+	vector<ENode> nodes;
+	vector<int> parent;                 // union-find over classes; a class is named after its first node
+	vector<vector<int>> classNodes;     // nodes of each class (valid for class representatives)
+	vector<bool> isConstant;            // the class has a constant value (valid for representatives)
+	vector<uint64_t> constant;
+	map<ENode, int> memo;               // node with canonical operands -> class
+	bool changed;
+	long matches;                       // rule matches so far
+	double start;                       // cpuMilliseconds() when saturation started
+	bool exhausted;                     // over one of the limits; add no more rules
+};
+
+// Counts a rule match; whether saturation has to stop
+bool eOverBudget(EGraph& graph) {
+	if (!graph.exhausted) {
+		graph.matches++;
+		graph.exhausted = graph.nodes.size() >= EGRAPH_MAX_NODES || graph.matches >= EGRAPH_MAX_MATCHES
+			|| cpuMilliseconds() - graph.start >= EGRAPH_TIME_LIMIT_MS;
+	}
+	return graph.exhausted;
+}
+
+int eFind(EGraph& graph, int c) {
+	while (graph.parent[c] != c) {
+		graph.parent[c] = graph.parent[graph.parent[c]];
+		c = graph.parent[c];
+	}
+	return c;
+}
+
+int eAdd(EGraph& graph, ENode node);
+
+// Merges two classes; returns whether they were different
+bool eMerge(EGraph& graph, int a, int b) {
+	a = eFind(graph, a);
+	b = eFind(graph, b);
+	if (a == b) return false;
+	if (graph.classNodes[a].size() < graph.classNodes[b].size()) swap(a, b);
+	graph.parent[b] = a;
+	graph.classNodes[a].insert(graph.classNodes[a].end(), graph.classNodes[b].begin(), graph.classNodes[b].end());
+	graph.classNodes[b].clear();
+	if (graph.isConstant[b] && !graph.isConstant[a]) {
+		graph.isConstant[a] = true;
+		graph.constant[a] = graph.constant[b];
+	}
+	graph.changed = true;
+	return true;
+}
+
+int eConstant(EGraph& graph, LLVMTypeRef type, uint64_t value) {
+	ENode node = { E_CONST, type, -1, -1, truncateBits(value, LLVMGetIntTypeWidth(type)), NULL };
+	return eAdd(graph, node);
+}
+
+int eBinary(EGraph& graph, EOp op, LLVMTypeRef type, int a, int b) {
+	ENode node = { op, type, a, b, 0, NULL };
+	return eAdd(graph, node);
+}
+
+// Adds a node (or finds an equal one) and returns its class
+int eAdd(EGraph& graph, ENode node) {
+	if (node.a >= 0) node.a = eFind(graph, node.a);
+	if (node.b >= 0) node.b = eFind(graph, node.b);
+	auto it = graph.memo.find(node);
+	if (it != graph.memo.end()) return eFind(graph, it->second);
+
+	int id = graph.nodes.size();
+	graph.nodes.push_back(node);
+	graph.parent.push_back(id);
+	graph.classNodes.push_back(vector<int>(1, id));
+	graph.isConstant.push_back(node.op == E_CONST);
+	graph.constant.push_back(node.constant);
+	graph.memo[node] = id;
+	graph.changed = true;
+	if (graph.nodes.size() >= EGRAPH_MAX_NODES) graph.exhausted = true;
+
+	// Constant folding
+	if (node.op >= E_ADD && graph.isConstant[node.a] && graph.isConstant[node.b]) {
+		unsigned width = LLVMGetIntTypeWidth(node.type);
+		uint64_t x = graph.constant[node.a], y = graph.constant[node.b];
+		if (node.op != E_SHL || y < width) {
+			uint64_t folded = node.op == E_ADD ? x + y : node.op == E_SUB ? x - y : node.op == E_MUL ? x * y : x << y;
+			eMerge(graph, id, eConstant(graph, node.type, folded));
+		}
+	}
+	return eFind(graph, id);
+}
+
+// Restores the invariant that equal nodes are in one class, after merges made operands equal
+void eRebuild(EGraph& graph) {
+	bool merged = true;
+	while (merged) {
+		merged = false;
+		graph.memo.clear();
+		for (size_t n = 0; n < graph.nodes.size(); n++) {
+			ENode node = graph.nodes[n];
+			if (node.a >= 0) node.a = eFind(graph, node.a);
+			if (node.b >= 0) node.b = eFind(graph, node.b);
+			graph.nodes[n] = node;
+			auto it = graph.memo.find(node);
+			if (it == graph.memo.end()) graph.memo[node] = n;
+			else if (eMerge(graph, it->second, n)) merged = true;
+		}
+	}
+}
+
+bool eIsConstant(EGraph& graph, int c, uint64_t value) {
+	c = eFind(graph, c);
+	return graph.isConstant[c] && graph.constant[c] == truncateBits(value, LLVMGetIntTypeWidth(graph.nodes[c].type));
+}
+
+// Nodes of class c with operation op
+vector<ENode> eNodesOf(EGraph& graph, int c, EOp op) {
+	vector<ENode> found;
+	for (int n : graph.classNodes[eFind(graph, c)]) {
+		if (graph.nodes[n].op == op) found.push_back(graph.nodes[n]);
+	}
+	return found;
+}
+
+// Adds what the rules derive from node n to its class. The operand nodes the rules match are taken before any
+// of them apply: the new nodes can land in the very classes being matched (x * 0 + y * 0 makes a, b and the
+// sum one class), and matching those again would feed on itself.
+void eApplyRules(EGraph& graph, int n) {
+	ENode node = graph.nodes[n];
+	if (node.op < E_ADD || eOverBudget(graph)) return;
+	int c = eFind(graph, n);
+	int a = eFind(graph, node.a), b = eFind(graph, node.b);
+	LLVMTypeRef type = node.type;
+	unsigned width = LLVMGetIntTypeWidth(type);
+	vector<ENode> aAdds = eNodesOf(graph, a, E_ADD), aSubs = eNodesOf(graph, a, E_SUB);
+	vector<ENode> aMuls = eNodesOf(graph, a, E_MUL), bMuls = eNodesOf(graph, b, E_MUL);
+
+	switch (node.op) {
+		case E_ADD:
+			eMerge(graph, c, eBinary(graph, E_ADD, type, b, a));
+			if (eIsConstant(graph, b, 0)) eMerge(graph, c, a);
+			if (a == b) eMerge(graph, c, eBinary(graph, E_MUL, type, a, eConstant(graph, type, 2)));
+			for (ENode inner : aAdds) { // (x + y) + b = x + (y + b)
+				if (eOverBudget(graph)) return;
+				eMerge(graph, c, eBinary(graph, E_ADD, type, inner.a, eBinary(graph, E_ADD, type, inner.b, b)));
+			}
+			for (ENode inner : aSubs) { // (x - b) + b = x
+				if (eFind(graph, inner.b) == eFind(graph, b)) eMerge(graph, c, inner.a);
+			}
+			for (ENode left : aMuls) { // x * y + x * z = x * (y + z)
+				for (ENode right : bMuls) {
+					if (eOverBudget(graph)) return;
+					if (eFind(graph, left.a) != eFind(graph, right.a)) continue;
+					eMerge(graph, c, eBinary(graph, E_MUL, type, left.a, eBinary(graph, E_ADD, type, left.b, right.b)));
+				}
+			}
+			break;
+		case E_SUB:
+			if (a == b) eMerge(graph, c, eConstant(graph, type, 0));
+			if (eIsConstant(graph, b, 0)) eMerge(graph, c, a);
+			if (graph.isConstant[b]) eMerge(graph, c, eBinary(graph, E_ADD, type, a, eConstant(graph, type, -graph.constant[b])));
+			for (ENode inner : aAdds) { // (x + b) - b = x
+				if (eFind(graph, inner.b) == eFind(graph, b)) eMerge(graph, c, inner.a);
+				else if (eFind(graph, inner.a) == eFind(graph, b)) eMerge(graph, c, inner.b);
+			}
+			break;
+		case E_MUL:
+			eMerge(graph, c, eBinary(graph, E_MUL, type, b, a));
+			if (eIsConstant(graph, b, 1)) eMerge(graph, c, a);
+			if (eIsConstant(graph, b, 0)) eMerge(graph, c, eConstant(graph, type, 0));
+			if (graph.isConstant[b]) {
+				uint64_t value = graph.constant[b];
+				if (value > 1 && (value & (value - 1)) == 0) {
+					uint64_t shift = 0;
+					while ((1ULL << shift) != value) shift++;
+					eMerge(graph, c, eBinary(graph, E_SHL, type, a, eConstant(graph, type, shift)));
+				}
+			}
+			for (ENode inner : aMuls) { // (x * y) * b = x * (y * b)
+				if (eOverBudget(graph)) return;
+				eMerge(graph, c, eBinary(graph, E_MUL, type, inner.a, eBinary(graph, E_MUL, type, inner.b, b)));
+			}
+			for (ENode inner : aAdds) { // (x + y) * b = x * b + y * b
+				if (eOverBudget(graph)) return;
+				eMerge(graph, c, eBinary(graph, E_ADD, type, eBinary(graph, E_MUL, type, inner.a, b),
+					eBinary(graph, E_MUL, type, inner.b, b)));
+			}
+			for (ENode inner : aSubs) { // (x - y) * b = x * b - y * b
+				if (eOverBudget(graph)) return;
+				eMerge(graph, c, eBinary(graph, E_SUB, type, eBinary(graph, E_MUL, type, inner.a, b),
+					eBinary(graph, E_MUL, type, inner.b, b)));
+			}
+			break;
+		case E_SHL:
+			if (graph.isConstant[b] && graph.constant[b] < width) {
+				eMerge(graph, c, eBinary(graph, E_MUL, type, a, eConstant(graph, type, 1ULL << graph.constant[b])));
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+bool isEGraphInstruction(LLVMValueRef inst) {
+	LLVMOpcode opcode = LLVMGetInstructionOpcode(inst);
+	return (opcode == LLVMAdd || opcode == LLVMSub || opcode == LLVMMul || opcode == LLVMShl)
+		&& LLVMGetIntTypeWidth(LLVMTypeOf(inst)) <= 64;
+}
+
+int eClassOf(EGraph& graph, LLVMValueRef value, LLVMBasicBlockRef bb, unordered_map<LLVMValueRef, int>& classes) {
+	auto it = classes.find(value);
+	if (it != classes.end()) return eFind(graph, it->second);
+
+	int c;
+	if (LLVMIsAConstantInt(value) && LLVMGetIntTypeWidth(LLVMTypeOf(value)) <= 64) {
+		c = eConstant(graph, LLVMTypeOf(value), LLVMConstIntGetZExtValue(value));
+	} else if (LLVMIsAInstruction(value) && LLVMGetInstructionParent(value) == bb && isEGraphInstruction(value)) {
+		LLVMOpcode opcode = LLVMGetInstructionOpcode(value);
+		EOp op = opcode == LLVMAdd ? E_ADD : opcode == LLVMSub ? E_SUB : opcode == LLVMMul ? E_MUL : E_SHL;
+		int a = eClassOf(graph, LLVMGetOperand(value, 0), bb, classes);
+		int b = eClassOf(graph, LLVMGetOperand(value, 1), bb, classes);
+		c = eBinary(graph, op, LLVMTypeOf(value), a, b);
+	} else {
+		ENode node = { E_LEAF, LLVMTypeOf(value), -1, -1, 0, value };
+		c = eAdd(graph, node);
+	}
+	classes[value] = c;
+	return c;
+}
+
+int eOpCost(EOp op) {
+	return op == E_MUL ? 3 : op >= E_ADD ? 1 : 0;
+}
+
+// Cost of computing value as the block does now, counting shared parts once per use like extraction does
+long originalCost(LLVMValueRef value, LLVMBasicBlockRef bb) {
+	if (!LLVMIsAInstruction(value) || LLVMGetInstructionParent(value) != bb || !isEGraphInstruction(value)) return 0;
+	LLVMOpcode opcode = LLVMGetInstructionOpcode(value);
+	return eOpCost(opcode == LLVMMul ? E_MUL : E_ADD) + originalCost(LLVMGetOperand(value, 0), bb)
+		+ originalCost(LLVMGetOperand(value, 1), bb);
+}
+
+// Cheapest node of every class using only leaves positioned before cutoff
+void eExtract(EGraph& graph, unordered_map<LLVMValueRef, int>& positions, int cutoff, vector<long>& cost, vector<int>& best) {
+	const long unavailable = LONG_MAX / 4;
+	cost.assign(graph.nodes.size(), unavailable);
+	best.assign(graph.nodes.size(), -1);
+	bool improved = true;
+	while (improved) {
+		improved = false;
+		for (size_t n = 0; n < graph.nodes.size(); n++) {
+			ENode& node = graph.nodes[n];
+			long c;
+			if (node.op == E_CONST) c = 0;
+			else if (node.op == E_LEAF) c = positions.count(node.leaf) && positions[node.leaf] >= cutoff ? unavailable : 0;
+			else c = eOpCost(node.op) + cost[eFind(graph, node.a)] + cost[eFind(graph, node.b)];
+			int cls = eFind(graph, n);
+			if (c < cost[cls]) {
+				cost[cls] = c;
+				best[cls] = n;
+				improved = true;
+			}
+		}
+	}
+}
+
+LLVMValueRef eBuild(EGraph& graph, int c, vector<int>& best, LLVMBuilderRef builder, unordered_map<int, LLVMValueRef>& built) {
+	c = eFind(graph, c);
+	auto it = built.find(c);
+	if (it != built.end()) return it->second;
+
+	ENode& node = graph.nodes[best[c]];
+	LLVMValueRef value;
+	if (node.op == E_CONST) {
+		value = LLVMConstInt(node.type, node.constant, 0);
+	} else if (node.op == E_LEAF) {
+		value = node.leaf;
+	} else {
+		LLVMValueRef a = eBuild(graph, node.a, best, builder, built);
+		LLVMValueRef b = eBuild(graph, node.b, best, builder, built);
+		if (node.op == E_ADD) value = LLVMBuildAdd(builder, a, b, "");
+		else if (node.op == E_SUB) value = LLVMBuildSub(builder, a, b, "");
+		else if (node.op == E_MUL) value = LLVMBuildMul(builder, a, b, "");
+		else value = LLVMBuildShl(builder, a, b, "");
+	}
+	built[c] = value;
+	return value;
+}
+
+int equalitySaturationInBlock(LLVMBasicBlockRef bb) {
+	// The values leaving the DAG: used by anything but another DAG instruction of the block
+	vector<LLVMValueRef> roots;
+	unordered_map<LLVMValueRef, int> positions;
+	int position = 0;
+	int dagSize = 0;
+	for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+		positions[inst] = position++;
+		if (!isEGraphInstruction(inst)) continue;
+		dagSize++;
+		for (LLVMUseRef use = LLVMGetFirstUse(inst); use; use = LLVMGetNextUse(use)) {
+			LLVMValueRef user = LLVMGetUser(use);
+			if (LLVMGetInstructionParent(user) != bb || !isEGraphInstruction(user)) {
+				roots.push_back(inst);
+				break;
+			}
+		}
+	}
+	if (dagSize < 2 || roots.empty()) return 0;
+
+	EGraph graph;
+	graph.changed = false;
+	graph.matches = 0;
+	graph.start = cpuMilliseconds();
+	graph.exhausted = false;
+	unordered_map<LLVMValueRef, int> classes;
+	for (LLVMValueRef root : roots) {
+		eClassOf(graph, root, bb, classes);
+	}
+
+	for (int iteration = 0; iteration < EGRAPH_MAX_ITERATIONS; iteration++) {
+		graph.changed = false;
+		size_t numNodes = graph.nodes.size();
+		for (size_t n = 0; n < numNodes && !eOverBudget(graph); n++) {
+			eApplyRules(graph, n);
+		}
+		eRebuild(graph);
+		if (!graph.changed) break; // Saturated
+		if (eOverBudget(graph)) {
+			if (TRACING(TRACE_PASSES)) {
+				printf("E-graph limit reached with %zu nodes after %ld rule matches\n", graph.nodes.size(), graph.matches);
+			}
+			break;
+		}
+	}
+
+	int numRebuilt = 0;
+	LLVMBuilderRef builder = LLVMCreateBuilderInContext(blockContext(bb));
+	unordered_map<int, LLVMValueRef> built;
+	for (LLVMValueRef root : roots) {
+		vector<long> cost;
+		vector<int> best;
+		eExtract(graph, positions, positions[root], cost, best);
+		int c = eFind(graph, classes[root]);
+		if (cost[c] >= originalCost(root, bb)) continue;
+
+		if (TRACING(TRACE_CHANGES)) {
+			printf("E-graph found a form of cost %ld instead of %ld for:\n", cost[c], originalCost(root, bb));
+			LLVMDumpValue(root);
+			printf("\n");
+		}
+		// Values built for earlier roots stay valid here, later in the block
+		LLVMPositionBuilderBefore(builder, root);
+		LLVMValueRef value = eBuild(graph, c, best, builder, built);
+		if (value == root) continue;
+		markInstructionChanged(root);
+		LLVMReplaceAllUsesWith(root, value);
+		numRebuilt++;
+	}
+	LLVMDisposeBuilder(builder);
+	return numRebuilt;
+}
+
+int equalitySaturation(LLVMModuleRef module) {
+	int numRebuilt = 0;
+
+	for (LLVMValueRef function =  firstFunction(module); 
+			function; 
+			function = nextFunction(function)) {
+
+		for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+			if (!needsVisit(bb)) continue;
+			numRebuilt += equalitySaturationInBlock(bb);
+		}
+	}
+
+	countStatistic("expressions rebuilt", numRebuilt);
+
+	if (numRebuilt > 0) return 1; // Indicate that we made changes
+	else return 0; // No changes made
+}
+
+// ---- Pass instrumentation ----
+
+// Every pass, and every repeat group of the pipeline, accumulates its run count, wall and CPU time and the
+// counters it reported through countStatistic. -time-passes prints them as a table, -stats-json=<file>
+// writes them as JSON ("-" for stdout).
+
+struct PassStatistics {
+	string name;
+	int runs;
+	int changedRuns;
+	double wallMs;
+	double cpuMs;
+	map<string, long> counters;
+};
+
+// One entry per registered pass, in registry order, followed by the repeat groups of the pipeline
+thread_local vector<PassStatistics> pipelineStatistics;
+
+double wallMilliseconds() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000.0 + now.tv_nsec / 1e6;
+}
+
+// CPU time of the calling thread, so that passes running on worker threads are not charged for each other
+double cpuMilliseconds() {
+	struct timespec now;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+	return now.tv_sec * 1000.0 + now.tv_nsec / 1e6;
+}
+
+double processCpuMilliseconds() {
+	return clock() * 1000.0 / CLOCKS_PER_SEC;
+}
+
+void addStatistics(vector<PassStatistics>& part) {
+	for (size_t i = 0; i < pipelineStatistics.size(); i++) {
+		PassStatistics& total = pipelineStatistics[i];
+		total.runs += part[i].runs;
+		total.changedRuns += part[i].changedRuns;
+		total.wallMs += part[i].wallMs;
+		total.cpuMs += part[i].cpuMs;
+		for (auto& counter : part[i].counters) total.counters[counter.first] += counter.second;
+	}
+}
+
+void printStatisticsTable(FILE* out, double totalWallMs, double totalCpuMs) {
+	fprintf(out, "===%s===\n", string(74, '-').c_str());
+	fprintf(out, "  Pass execution timing report (total %.3f ms wall, %.3f ms CPU)\n", totalWallMs, totalCpuMs);
+	fprintf(out, "===%s===\n", string(74, '-').c_str());
+	fprintf(out, "%-40s %5s %7s %10s %10s  %s\n", "Pass", "Runs", "Changed", "Wall ms", "CPU ms", "Counters");
+	for (PassStatistics& entry : pipelineStatistics) {
+		if (entry.runs == 0) continue;
+		string counters;
+		for (auto& counter : entry.counters) {
+			if (!counters.empty()) counters += ", ";
+			counters += counter.first + "=" + to_string(counter.second);
+		}
+		string name = entry.name.size() > 40 ? entry.name.substr(0, 37) + "..." : entry.name;
+		fprintf(out, "%-40s %5d %7d %10.3f %10.3f  %s\n", name.c_str(), entry.runs, entry.changedRuns,
+			entry.wallMs, entry.cpuMs, counters.c_str());
+	}
+}
+
+void printStatisticsJSON(FILE* out, double totalWallMs, double totalCpuMs) {
+	fprintf(out, "{\n  \"wall_ms\": %.3f,\n  \"cpu_ms\": %.3f,\n  \"passes\": [", totalWallMs, totalCpuMs);
+	bool first = true;
+	for (PassStatistics& entry : pipelineStatistics) {
+		if (entry.runs == 0) continue;
+		// Pass names and pipeline text never contain quotes or backslashes
+		fprintf(out, "%s\n    {\"name\": \"%s\", \"runs\": %d, \"changed\": %d, \"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"counters\": {",
+			first ? "" : ",", entry.name.c_str(), entry.runs, entry.changedRuns, entry.wallMs, entry.cpuMs);
+		bool firstCounter = true;
+		for (auto& counter : entry.counters) {
+			fprintf(out, "%s\"%s\": %ld", firstCounter ? "" : ", ", counter.first.c_str(), counter.second);
+			firstCounter = false;
+		}
+		fprintf(out, "}}");
+		first = false;
+	}
+	fprintf(out, "\n  ]\n}\n");
+}
+
+// ---- Pass manager ----
+
+// Every pass is registered under a short name, and the order they run in is a pipeline string: a comma
+// separated list of pass names and repeat(...) groups, which rerun their contents until a whole round
+// changes nothing, e.g. "repeat(cse,dce,repeat(fold,constprop)),dse". Within a group, a pass is skipped when
+// nothing changed the module since it last ran without finding anything to do. -O0/-O1/-O2 name presets.
+
+#define PIPELINE_MAX_ROUNDS 1000 // guards against passes that keep undoing each other's changes
+
+struct Pass {
+	const char* name;
+	const char* description; // as printed in "<description> made changes"
+	int (*run)(LLVMModuleRef);
+	unsigned preserves;      // analyses that stay valid when the pass changes the module
+	bool interprocedural;    // looks at (or adds and removes) other functions than the one it changes
+};
+
+Pass passRegistry[] = {
+	{ "evaluate", "Compile-time evaluation", compileTimeEvaluation, PRESERVE_NONE, true },
+	{ "ipcp", "Interprocedural constant propagation", interproceduralConstantPropagation, PRESERVE_NONE, true },
+	{ "inline", "Function inlining", functionInlining, PRESERVE_NONE, true },
+	{ "rotate", "Loop rotation", loopRotation, PRESERVE_NONE, false },
+	{ "unswitch", "Loop unswitching", loopUnswitching, PRESERVE_NONE, false },
+	{ "promote", "Scalar promotion", scalarPromotion, PRESERVE_NONE, false },
+	{ "reassociate", "Reassociation", reassociation, PRESERVE_ALL, false },
+	{ "egraph", "Equality saturation", equalitySaturation, PRESERVE_ALL, false },
+	{ "cse", "Subexpression elimination", subexprElimination, PRESERVE_ALL, false },
+	{ "pre", "Partial redundancy elimination", partialRedundancyElimination, PRESERVE_NONE, false },
+	{ "dce", "Dead code elimination", deadcodeElimination, PRESERVE_CFG, false },
+	{ "ifconvert", "If-conversion", ifConversion, PRESERVE_NONE, false },
+	{ "fold", "Constant folding", constantFolding, PRESERVE_ALL, false },
+	{ "constprop", "Constant propagation", constantPropagation, PRESERVE_CFG, false },
+	{ "simplifycfg", "Branch simplification", branchSimplification, PRESERVE_NONE, false },
+	{ "jumpthread", "Jump threading", jumpThreading, PRESERVE_NONE, false },
+	{ "scev", "Scalar evolution", scalarEvolution, PRESERVE_NONE, false },
+	{ "sdiv", "Division strength reduction", sdivStrengthReduction, PRESERVE_ALL, false },
+	{ "dse", "Live variable analysis", liveVarAnalysis, PRESERVE_CFG, false },
+	{ "sink", "Code sinking", codeSinking, PRESERVE_ALL, false },
+};
+
+#define NUM_PASSES (int) (sizeof(passRegistry) / sizeof(passRegistry[0]))
+
+const char* optimizationPresets[] = {
+	// -O0
+	"",
+	// -O1
+	"repeat(cse,dce,repeat(fold,constprop)),dse,repeat(dce)",
+	// -O2
+	"evaluate,ipcp,inline,rotate,unswitch,promote,"
+	"repeat(reassociate,cse,pre,dce,ifconvert,repeat(fold,constprop),simplifycfg,jumpthread,scev),"
+	"sdiv,dse,repeat(dce),sink",
+};
+
+// A pass, or a repeat group of steps when pass is -1
+struct PipelineStep {
+	int pass;
+	vector<PipelineStep> steps;
+	unsigned cleanVersion; // module version at which the pass last ran without changes, 0 if never
+	int statistics;        // index into pipelineStatistics
+};
+
+int findPass(const string& name) {
+	for (int i = 0; i < NUM_PASSES; i++) {
+		if (name == passRegistry[i].name) return i;
+	}
+	return -1;
+}
+
+// Parses a comma separated list of steps starting at pos; returns false with a message on errors
+bool parsePipeline(const string& text, size_t& pos, vector<PipelineStep>& steps, string& error) {
+	while (true) {
+		while (pos < text.size() && text[pos] == ' ') pos++;
+		size_t nameStart = pos;
+		while (pos < text.size() && (isalnum((unsigned char) text[pos]) || text[pos] == '-' || text[pos] == '_')) pos++;
+		string name = text.substr(nameStart, pos - nameStart);
+		while (pos < text.size() && text[pos] == ' ') pos++;
+
+		PipelineStep step;
+		step.cleanVersion = 0;
+		if (name == "repeat" && pos < text.size() && text[pos] == '(') {
+			pos++;
+			step.pass = -1;
+			if (!parsePipeline(text, pos, step.steps, error)) return false;
+			if (pos >= text.size() || text[pos] != ')') {
+				error = "expected ')' at position " + to_string(pos);
+				return false;
+			}
+			pos++;
+			step.statistics = pipelineStatistics.size();
+			pipelineStatistics.push_back({ text.substr(nameStart, pos - nameStart), 0, 0, 0, 0, {} });
+			while (pos < text.size() && text[pos] == ' ') pos++;
+		} else {
+			step.pass = findPass(name);
+			if (step.pass < 0) {
+				error = name.empty() ? "expected a pass name at position " + to_string(nameStart) : "unknown pass '" + name + "'";
+				return false;
+			}
+			step.statistics = step.pass;
+		}
+		steps.push_back(step);
+
+		if (pos < text.size() && text[pos] == ',') pos++;
+		else return true;
+	}
+}
+
+bool parsePipeline(const string& text, vector<PipelineStep>& steps, string& error) {
+	size_t pos = 0;
+	steps.clear();
+	pipelineStatistics.clear();
+	for (int i = 0; i < NUM_PASSES; i++) {
+		pipelineStatistics.push_back({ passRegistry[i].name, 0, 0, 0, 0, {} });
+	}
+	while (pos < text.size() && text[pos] == ' ') pos++;
+	if (pos == text.size()) return true; // Empty pipeline
+	if (!parsePipeline(text, pos, steps, error)) return false;
+	if (pos != text.size()) {
+		error = "unexpected '" + string(1, text[pos]) + "' at position " + to_string(pos);
+		return false;
+	}
+	return true;
+}
+
+thread_local unsigned moduleVersion = 1; // bumped whenever a pass changes the module
+thread_local bool reportPasses = true;   // print a line per pass run (off on worker threads)
+
+bool dirtyTracking = true;               // skip functions and blocks a pass already went over unchanged
+thread_local vector<CleanRecord> passCleanRecords(NUM_PASSES);
+
+// Runs the steps once, in order; returns whether any of them changed the module
+int runPipeline(LLVMModuleRef module, vector<PipelineStep>& steps, bool inRepeat) {
+	int changed = 0;
+	for (PipelineStep& step : steps) {
+		PassStatistics& statistics = pipelineStatistics[step.statistics];
+		if (step.pass < 0) {
+			double wallStart = wallMilliseconds(), cpuStart = cpuMilliseconds();
+			int rounds = 0;
+			int groupChanged = 1;
+			while (groupChanged && rounds++ < PIPELINE_MAX_ROUNDS) {
+				if (reportPasses) printf("Starting optimization iteration...\n");
+				double roundStart = wallMilliseconds();
+				groupChanged = runPipeline(module, step.steps, true);
+				if (groupChanged) changed = 1;
+				if (TRACING(TRACE_PASSES)) {
+					printf("Iteration %d of %s took %.3f ms\n", rounds, statistics.name.c_str(), wallMilliseconds() - roundStart);
+				}
+			}
+			statistics.runs++;
+			if (rounds > 1) statistics.changedRuns++; // The last round never changes anything
+			statistics.counters["iterations"] += rounds;
+			statistics.wallMs += wallMilliseconds() - wallStart;
+			statistics.cpuMs += cpuMilliseconds() - cpuStart;
+			continue;
+		}
+
+		Pass& pass = passRegistry[step.pass];
+		if (inRepeat && step.cleanVersion == moduleVersion) continue; // Nothing new to look at
+
+		double wallStart = wallMilliseconds(), cpuStart = cpuMilliseconds();
+		passCounters = &statistics.counters;
+		passCleanRecord = dirtyTracking ? &passCleanRecords[step.pass] : NULL;
+		int passChanged = pass.run(module);
+		passCounters = NULL;
+		passCleanRecord = NULL;
+		statistics.runs++;
+		statistics.wallMs += wallMilliseconds() - wallStart;
+		statistics.cpuMs += cpuMilliseconds() - cpuStart;
+
+		if (reportPasses) printf("%s made changes: %s\n", pass.description, passChanged ? "Yes" : "No");
+		if (passChanged) {
+			statistics.changedRuns++;
+			invalidateAllAnalyses(pass.preserves);
+			moduleVersion++;
+			changed = 1;
+		} else {
+			step.cleanVersion = moduleVersion;
+		}
+	}
+	return changed;
+}
+
+// ---- Parallel optimization ----
+
+// With -jobs=N the function passes run on N worker threads. The interprocedural passes at the start of the
+// pipeline run first, on the whole module; everything after them must be function passes, which only ever
+// look at the function they change, so the functions can be optimized independently. The defined functions
+// are dealt out to N shards (largest first, each to the shard with the fewest instructions so far). Every
+// worker parses its own copy of the module from bitcode into its own LLVMContextRef, deletes the bodies of the
+// functions other shards own and runs the pipeline; all state passes keep is thread_local. The shards come
+// back as bitcode, are parsed into the context of the module and their function bodies moved into the
+// original functions one by one, in module order. Each function sees the same sequence of passes as in a
+// serial run (a repeat group only runs more rounds there, which change nothing), so the result is identical.
+//
+// The copies are taken after the interprocedural passes. The passes name copied instructions themselves
+// (copyName) rather than leave clashing names to LLVM, whose count of them starts over in a copy read from
+// bitcode, so a function gets the same names in a shard as in a serial run.
+//
+// Named struct types and debug info cannot be matched up again between the copies through the C API, so such
+// modules are optimized serially. Bitcode does not keep the order of use lists either; the only place that
+// order shows is the "; preds = ..." comment of a block, so orderPredecessorLists puts those in block order
+// before the module is printed, in both modes.
+
+struct ShardResult {
+	string bitcode;
+	vector<PassStatistics> statistics;
+	string error;
+};
+
+// Turns function into a declaration
+void deleteFunctionBody(LLVMValueRef function) {
+	for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+		for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+			if (LLVMGetTypeKind(LLVMTypeOf(inst)) != LLVMVoidTypeKind) {
+				LLVMReplaceAllUsesWith(inst, LLVMGetUndef(LLVMTypeOf(inst)));
+			}
+		}
+	}
+	while (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function)) {
+		while (LLVMValueRef inst = LLVMGetLastInstruction(bb)) LLVMInstructionEraseFromParent(inst);
+		LLVMDeleteBasicBlock(bb);
+	}
+}
+
+bool containsNamedStruct(LLVMTypeRef type) {
+	switch (LLVMGetTypeKind(type)) {
+	case LLVMStructTypeKind: {
+		if (!LLVMIsLiteralStruct(type)) return true;
+		unsigned count = LLVMCountStructElementTypes(type);
+		for (unsigned i = 0; i < count; i++) {
+			if (containsNamedStruct(LLVMStructGetTypeAtIndex(type, i))) return true;
+		}
+		return false;
+	}
+	case LLVMArrayTypeKind:
+	case LLVMVectorTypeKind:
+		return containsNamedStruct(LLVMGetElementType(type));
+	case LLVMFunctionTypeKind: {
+		if (containsNamedStruct(LLVMGetReturnType(type))) return true;
+		vector<LLVMTypeRef> params(LLVMCountParamTypes(type));
+		LLVMGetParamTypes(type, params.data());
+		for (LLVMTypeRef param : params) {
+			if (containsNamedStruct(param)) return true;
+		}
+		return false;
+	}
+	default:
+		return false;
+	}
+}
+
+// Whether the function bodies of copies of module can be moved back into it; reason says why not
+bool shardable(LLVMModuleRef module, string& reason) {
+	if (LLVMGetNamedMetadata(module, "llvm.dbg.cu", strlen("llvm.dbg.cu"))) {
+		reason = "the module has debug info";
+		return false;
+	}
+	for (LLVMValueRef global = LLVMGetFirstGlobal(module); global; global = LLVMGetNextGlobal(global)) {
+		if (containsNamedStruct(LLVMGlobalGetValueType(global))) reason = "the module uses named struct types";
+	}
+	for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+		if (containsNamedStruct(LLVMGlobalGetValueType(function))) reason = "the module uses named struct types";
+		for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+			for (LLVMValueRef inst = LLVMGetFirstInstruction(bb); inst; inst = LLVMGetNextInstruction(inst)) {
+				bool named = containsNamedStruct(LLVMTypeOf(inst));
+				if (LLVMIsAAllocaInst(inst)) named |= containsNamedStruct(LLVMGetAllocatedType(inst));
+				if (LLVMIsAGetElementPtrInst(inst)) named |= containsNamedStruct(LLVMGetGEPSourceElementType(inst));
+				int numOperands = LLVMGetNumOperands(inst);
+				for (int i = 0; i < numOperands; i++) named |= containsNamedStruct(LLVMTypeOf(LLVMGetOperand(inst, i)));
+				if (named) reason = "the module uses named struct types";
+			}
+		}
+	}
+	return reason.empty();
+}
+
+// Deals the defined functions of module out to jobs shards; owner gets the shard of each function in module
+// order, -1 for declarations. Returns the number of defined functions.
+int dealFunctions(LLVMModuleRef module, int jobs, vector<int>& owner) {
+	vector<pair<int, int>> sizes; // (-instructions, index)
+	owner.clear();
+	for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+		if (isDefinedFunction(function)) {
+			int size = 0;
+			for (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(function); bb; bb = LLVMGetNextBasicBlock(bb)) {
+				size += countBlockInstructions(bb);
+			}
+			sizes.push_back(make_pair(-size, (int) owner.size()));
+		}
+		owner.push_back(-1);
+	}
+	sort(sizes.begin(), sizes.end());
+	vector<long> load(jobs, 0);
+	for (auto& entry : sizes) {
+		int lightest = min_element(load.begin(), load.end()) - load.begin();
+		owner[entry.second] = lightest;
+		load[lightest] -= entry.first;
+	}
+	return sizes.size();
+}
+
+// Runs functionPasses on the functions of a copy of the module parsed from bitcode that are dealt to shard
+void optimizeShard(const char* bitcode, size_t size, int shard, int jobs, vector<PipelineStep> functionPasses,
+		vector<PassStatistics> statistics, ShardResult* result) {
+	LLVMContextRef context = LLVMContextCreate();
+	LLVMMemoryBufferRef buffer = LLVMCreateMemoryBufferWithMemoryRange(bitcode, size, "shard", 0);
+	LLVMModuleRef module = NULL;
+	bool failed = LLVMParseBitcodeInContext2(context, buffer, &module);
+	LLVMDisposeMemoryBuffer(buffer);
+	if (failed) {
+		result->error = "cannot read the module back from bitcode";
+		LLVMContextDispose(context);
+		return;
+	}
+
+	reportPasses = false;
+	pipelineStatistics = statistics;
+
+	vector<int> owner;
+	dealFunctions(module, jobs, owner);
+	int index = 0;
+	for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+		if (owner[index] >= 0 && owner[index] != shard) {
+			deleteFunctionBody(function);
+			LLVMSetLinkage(function, LLVMExternalLinkage); // A declaration cannot be internal
+		}
+		index++;
+	}
+	invalidateAllAnalyses(PRESERVE_NONE);
+	markModuleChanged();
+
+	runPipeline(module, functionPasses, false);
+	result->statistics = pipelineStatistics;
+	analysisCache.clear();
+	functionChanges.clear();
+
+	LLVMMemoryBufferRef output = LLVMWriteBitcodeToMemoryBuffer(module);
+	result->bitcode.assign(LLVMGetBufferStart(output), LLVMGetBufferSize(output));
+	LLVMDisposeMemoryBuffer(output);
+	LLVMDisposeModule(module);
+	LLVMContextDispose(context);
+}
+
+vector<LLVMValueRef> globalValues(LLVMModuleRef module) {
+	vector<LLVMValueRef> values;
+	for (LLVMValueRef global = LLVMGetFirstGlobal(module); global; global = LLVMGetNextGlobal(global)) {
+		values.push_back(global);
+	}
+	for (LLVMValueRef alias = LLVMGetFirstGlobalAlias(module); alias; alias = LLVMGetNextGlobalAlias(alias)) {
+		values.push_back(alias);
+	}
+	for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+		values.push_back(function);
+	}
+	return values;
+}
+
+// Recreates the uses of every block so that its predecessors list in block order: a new use goes to the front
+// of the list, so the terminators are visited last block first
+void orderPredecessorLists(LLVMModuleRef module) {
+	for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+		for (LLVMBasicBlockRef bb = LLVMGetLastBasicBlock(function); bb; bb = LLVMGetPreviousBasicBlock(bb)) {
+			LLVMValueRef terminator = LLVMGetBasicBlockTerminator(bb);
+			if (terminator == NULL) continue;
+			for (int i = (int)LLVMGetNumSuccessors(terminator) - 1; i >= 0; i--) {
+				LLVMSetSuccessor(terminator, i, LLVMGetSuccessor(terminator, i));
+			}
+		}
+	}
+}
+
+// Runs the function passes functionPasses over the functions of module on jobs threads; returns false (with
+// the module left as it was) if it cannot
+bool runPipelineInParallel(LLVMModuleRef module, vector<PipelineStep>& functionPasses, int jobs, string& error) {
+	if (!shardable(module, error)) return false;
+
+	// Deal out the defined functions, largest first
+	vector<LLVMValueRef> functions;
+	for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+		functions.push_back(function);
+	}
+	vector<int> owner;
+	int numDefined = dealFunctions(module, jobs, owner);
+	if (jobs > numDefined) jobs = dealFunctions(module, numDefined, owner);
+	if (jobs < 2) {
+		error = "the module has fewer than two defined functions";
+		return false;
+	}
+
+	// The shards count from zero, and what they count is added to the statistics of the module at the end
+	vector<PassStatistics> statistics = pipelineStatistics;
+	for (PassStatistics& entry : statistics) entry = { entry.name, 0, 0, 0, 0, {} };
+	LLVMMemoryBufferRef bitcode = LLVMWriteBitcodeToMemoryBuffer(module);
+	vector<ShardResult> results(jobs);
+	vector<thread> workers;
+	for (int k = 0; k < jobs; k++) {
+		workers.push_back(thread(optimizeShard, LLVMGetBufferStart(bitcode), LLVMGetBufferSize(bitcode), k, jobs,
+			functionPasses, statistics, &results[k]));
+	}
+	for (thread& worker : workers) worker.join();
+	LLVMDisposeMemoryBuffer(bitcode);
+
+	// Read the shards back into the context of module
+	vector<LLVMModuleRef> shardModules(jobs, NULL);
+	for (int k = 0; k < jobs && error.empty(); k++) {
+		if (!results[k].error.empty()) {
+			error = results[k].error;
+			break;
+		}
+		LLVMMemoryBufferRef buffer = LLVMCreateMemoryBufferWithMemoryRange(results[k].bitcode.data(),
+			results[k].bitcode.size(), "shard", 0);
+		if (LLVMParseBitcodeInContext2(LLVMGetModuleContext(module), buffer, &shardModules[k])) {
+			error = "cannot read an optimized shard";
+		}
+		LLVMDisposeMemoryBuffer(buffer);
+	}
+	vector<LLVMValueRef> originals = globalValues(module);
+	vector<vector<LLVMValueRef>> copies(jobs);
+	for (int k = 0; k < jobs && error.empty(); k++) {
+		copies[k] = globalValues(shardModules[k]);
+		if (copies[k].size() != originals.size()) error = "a shard has different globals than the module";
+	}
+	if (!error.empty()) {
+		for (LLVMModuleRef shardModule : shardModules) {
+			if (shardModule) LLVMDisposeModule(shardModule);
+		}
+		return false;
+	}
+
+	// The copied globals stand for the originals from here on, then the bodies move over in module order
+	for (int k = 0; k < jobs; k++) {
+		for (size_t i = 0; i < originals.size(); i++) LLVMReplaceAllUsesWith(copies[k][i], originals[i]);
+	}
+	size_t firstFunction = originals.size() - functions.size();
+	for (size_t i = 0; i < functions.size(); i++) {
+		if (owner[i] < 0) continue;
+		LLVMValueRef function = functions[i];
+		LLVMValueRef copy = copies[owner[i]][firstFunction + i];
+		deleteFunctionBody(function);
+		unsigned numParams = LLVMCountParams(function);
+		for (unsigned p = 0; p < numParams; p++) LLVMReplaceAllUsesWith(LLVMGetParam(copy, p), LLVMGetParam(function, p));
+		while (LLVMBasicBlockRef bb = LLVMGetFirstBasicBlock(copy)) {
+			LLVMRemoveBasicBlockFromParent(bb);
+			LLVMAppendExistingBasicBlock(function, bb);
+		}
+	}
+	for (LLVMModuleRef shardModule : shardModules) LLVMDisposeModule(shardModule);
+
+	// Statistics add up over the shards
+	for (int k = 0; k < jobs; k++) addStatistics(results[k].statistics);
+	printf("Optimized %d functions in %d parallel shards\n", numDefined, jobs);
+	return true;
+}
+
+bool hasInterproceduralPass(vector<PipelineStep>& steps) {
+	for (PipelineStep& step : steps) {
+		if (step.pass < 0 ? hasInterproceduralPass(step.steps) : passRegistry[step.pass].interprocedural) return true;
+	}
+	return false;
+}
+
+// Runs the pipeline over module, the function passes after the leading interprocedural ones on jobs threads
+void optimizeModule(LLVMModuleRef module, vector<PipelineStep>& pipeline, int jobs) {
+	if (jobs <= 1 || TRACING(TRACE_PASSES)) {
+		runPipeline(module, pipeline, false);
+		return;
+	}
+
+	// The interprocedural passes in front run on the whole module, the rest in parallel
+	size_t split = 0;
+	while (split < pipeline.size() && pipeline[split].pass >= 0 && passRegistry[pipeline[split].pass].interprocedural) split++;
+	vector<PipelineStep> modulePasses(pipeline.begin(), pipeline.begin() + split);
+	vector<PipelineStep> functionPasses(pipeline.begin() + split, pipeline.end());
+	runPipeline(module, modulePasses, false);
+
+	string reason;
+	if (hasInterproceduralPass(functionPasses)) reason = "interprocedural passes follow function passes";
+	if (!reason.empty() || !runPipelineInParallel(module, functionPasses, jobs, reason)) {
+		fprintf(stderr, "Optimizing serially: %s\n", reason.c_str());
+		runPipeline(module, functionPasses, false);
+	}
+}
+
+// ---- Lazy loading ----
+
+// With -lazy the input is read as bitcode with lazy function bodies: only the global values are parsed up
+// front, and each body is materialized just before the pipeline runs on it, with focusFunction keeping the
+// passes to that one function. Its analyses are dropped once it is done, so the unoptimized IR and the analyses
+// held at any time are those of a single function. The interprocedural passes need every body at once and are
+// left out of the pipeline.
+//
+// The C API can neither dematerialize a function nor print a module piecemeal (attribute groups and metadata
+// are numbered over the whole module), so the optimized bodies stay in memory until the module is written.
+
+bool lazyLoading = false;
+
+// Forgets what the passes remember about the module, whose functions and blocks the next module may reuse the
+// addresses of
+void forgetModule() {
+	invalidateAllAnalyses(PRESERVE_NONE);
+	markModuleChanged();
+	moduleVersion++;
+}
+
+// Drops the interprocedural passes from steps, collecting their names
+void removeInterproceduralPasses(vector<PipelineStep>& steps, string& removed) {
+	for (size_t i = 0; i < steps.size(); ) {
+		if (steps[i].pass < 0) {
+			removeInterproceduralPasses(steps[i].steps, removed);
+		} else if (passRegistry[steps[i].pass].interprocedural) {
+			if (removed.find(passRegistry[steps[i].pass].name) == string::npos) {
+				removed += string(removed.empty() ? "" : ", ") + passRegistry[steps[i].pass].name;
+			}
+			steps.erase(steps.begin() + i);
+			continue;
+		}
+		i++;
+	}
+}
+
+// The pipeline text of steps, as parsePipeline reads it
+string describeSteps(vector<PipelineStep>& steps) {
+	string text;
+	for (PipelineStep& step : steps) {
+		if (!text.empty()) text += ",";
+		text += step.pass < 0 ? "repeat(" + describeSteps(step.steps) + ")" : passRegistry[step.pass].name;
+	}
+	return text;
+}
+
+// Puts pass to in place of every step of pass from, and renames the repeat groups that held it
+bool replacePass(vector<PipelineStep>& steps, int from, int to) {
+	bool replaced = false;
+	for (PipelineStep& step : steps) {
+		if (step.pass < 0) {
+			if (!replacePass(step.steps, from, to)) continue;
+			pipelineStatistics[step.statistics].name = "repeat(" + describeSteps(step.steps) + ")";
+			replaced = true;
+		} else if (step.pass == from) {
+			step.pass = step.statistics = to;
+			replaced = true;
+		}
+	}
+	return replaced;
+}
+
+// Reads the bitcode file inputFile lazily and runs steps (function passes only) over its functions one at a
+// time; returns the optimized module, or NULL if the file cannot be read
+LLVMModuleRef optimizeLazily(const char* inputFile, LLVMContextRef context, vector<PipelineStep>& steps) {
+	char* err = NULL;
+	LLVMMemoryBufferRef buffer = NULL;
+	if (LLVMCreateMemoryBufferWithContentsOfFile(inputFile, &buffer, &err)) {
+		printf("%s: %s\n", inputFile, err);
+		LLVMDisposeMessage(err);
+		return NULL;
+	}
+	// The reader reports malformed bitcode through the context and exits; text is caught here
+	LLVMModuleRef module = NULL;
+	if (!isBitcode(buffer) || LLVMGetBitcodeModuleInContext2(context, buffer, &module)) {
+		printf("%s: not a bitcode file (-lazy reads .bc files)\n", inputFile);
+		LLVMDisposeMemoryBuffer(buffer);
+		return NULL;
+	}
+
+	// Running a function pass manager on a function materializes it, even with no passes in it
+	LLVMPassManagerRef materializer = LLVMCreateFunctionPassManagerForModule(module);
+	int functions = 0;
+	for (LLVMValueRef function = LLVMGetFirstFunction(module); function; function = LLVMGetNextFunction(function)) {
+		if (LLVMIsDeclaration(function)) continue;
+		LLVMRunFunctionPassManager(materializer, function);
+		forgetModule(); // Also makes the repeat groups run again
+		focusFunction = function;
+		runPipeline(module, steps, false);
+		focusFunction = NULL;
+		functions++;
+	}
+	forgetModule();
+	LLVMDisposePassManager(materializer);
+	if (reportPasses) printf("Optimized %d functions one at a time\n", functions);
+	return module;
+}
+
+// ---- Batch optimization ----
+
+// Given several input files, the optimizer works through them on -jobs threads (one per hardware thread by
+// default), so the LLVM libraries are loaded and initialized once for the whole batch. Every thread parses the
+// modules it optimizes into its own LLVMContextRef and takes the next file off a shared counter when it is
+// done with one; each file is optimized serially and written next to its input as usual. The timings of the
+// files are printed in input order at the end, and the pass statistics add up over all of them.
+
+struct FileResult {
+	bool ok;
+	double wallMs; // reading, optimizing and writing the file
+	double cpuMs;
+};
+
+enum OutputFormat {
+	OUTPUT_LIKE_INPUT,
+	OUTPUT_TEXT,    // -emit-ll
+	OUTPUT_BITCODE, // -emit-bc
+};
+
+OutputFormat outputFormat = OUTPUT_LIKE_INPUT;
+
+void writeOptimizedModule(LLVMModuleRef module, const char* inputFile) {
+	orderPredecessorLists(module);
+	if (TRACING(TRACE_PASSES)) LLVMDumpModule(module);
+
+	bool bitcode = outputFormat == OUTPUT_LIKE_INPUT ? isBitcodeFile(inputFile) : outputFormat == OUTPUT_BITCODE;
+	string suffix = bitcode ? "_optimized.bc" : "_optimized.ll";
+
+	// Build output filename: strip a trailing .ll (or .bc) extension, append _optimized.ll (or .bc)
+	string inputName(inputFile);
+	size_t length = inputName.size();
+	string extension = length >= 3 ? inputName.substr(length - 3) : "";
+	if (extension == ".ll" || extension == ".bc") length -= 3;
+	string outputName = inputName.substr(0, length) + suffix;
+	if (bitcode) LLVMWriteBitcodeToFile(module, outputName.c_str());
+	else LLVMPrintModuleToFile(module, outputName.c_str(), NULL);
+}
+
+void optimizeFiles(vector<char*>* inputFiles, atomic<size_t>* nextFile, vector<PipelineStep> steps,
+		vector<PassStatistics> statistics, vector<FileResult>* results, vector<PassStatistics>* totals) {
+	LLVMContextRef context = LLVMContextCreate();
+	reportPasses = false;
+	pipelineStatistics = statistics;
+	for (size_t i = (*nextFile)++; i < inputFiles->size(); i = (*nextFile)++) {
+		double wallStart = wallMilliseconds(), cpuStart = cpuMilliseconds();
+		LLVMModuleRef module = lazyLoading ? optimizeLazily((*inputFiles)[i], context, steps)
+			: createLLVMModel((*inputFiles)[i], context);
+		if (module != NULL) {
+			if (!lazyLoading) {
+				forgetModule();
+				runPipeline(module, steps, false);
+			}
+			writeOptimizedModule(module, (*inputFiles)[i]);
+			LLVMDisposeModule(module);
+		}
+		(*results)[i] = { module != NULL, wallMilliseconds() - wallStart, cpuMilliseconds() - cpuStart };
+	}
+	forgetModule();
+	*totals = pipelineStatistics;
+	LLVMContextDispose(context);
+}
+
+// Optimizes inputFiles on jobs threads and prints their timings; returns whether all of them could be read
+bool optimizeBatch(vector<char*>& inputFiles, vector<PipelineStep>& pipeline, int jobs, double& totalWallMs,
+		double& totalCpuMs) {
+	if (TRACING(TRACE_PASSES)) jobs = 1; // Keep the traces of the files apart
+	jobs = min(jobs, (int) inputFiles.size());
+	double wallStart = wallMilliseconds(), cpuStart = processCpuMilliseconds();
+	atomic<size_t> nextFile(0);
+	vector<FileResult> results(inputFiles.size());
+	vector<vector<PassStatistics>> statistics(jobs);
+	vector<thread> workers;
+	for (int k = 0; k < jobs; k++) {
+		workers.push_back(thread(optimizeFiles, &inputFiles, &nextFile, pipeline, pipelineStatistics, &results,
+			&statistics[k]));
+	}
+	for (thread& worker : workers) worker.join();
+	for (int k = 0; k < jobs; k++) addStatistics(statistics[k]);
+	totalWallMs = wallMilliseconds() - wallStart;
+	totalCpuMs = processCpuMilliseconds() - cpuStart;
+
+	int failed = 0;
+	double fileWallMs = 0, fileCpuMs = 0;
+	printf("===%s===\n", string(74, '-').c_str());
+	printf("  Batch timing report (%d files on %d threads, total %.3f ms wall, %.3f ms CPU)\n",
+		(int) inputFiles.size(), jobs, totalWallMs, totalCpuMs);
+	printf("===%s===\n", string(74, '-').c_str());
+	printf("%-56s %10s %10s\n", "File", "Wall ms", "CPU ms");
+	for (size_t i = 0; i < inputFiles.size(); i++) {
+		string name = inputFiles[i];
+		if (name.size() > 56) name = "..." + name.substr(name.size() - 53);
+		if (!results[i].ok) {
+			printf("%-56s %21s\n", name.c_str(), "failed");
+			failed++;
+			continue;
+		}
+		printf("%-56s %10.3f %10.3f\n", name.c_str(), results[i].wallMs, results[i].cpuMs);
+		fileWallMs += results[i].wallMs;
+		fileCpuMs += results[i].cpuMs;
+	}
+	printf("%-56s %10.3f %10.3f\n", "Sum over files", fileWallMs, fileCpuMs);
+	if (failed) printf("%d of %d files could not be read\n", failed, (int) inputFiles.size());
+	return failed == 0;
+}
+
+// ---- Input and output benchmark ----
+
+// -io-benchmark optimizes nothing; for every input file it measures how large the module is as textual IR and
+// as bitcode, and how long it takes to write and read back in either form. Everything happens in memory, so
+// the disk does not count, and each time is the best of IO_BENCHMARK_ROUNDS.
+
+#define IO_BENCHMARK_ROUNDS 5 // Timed runs of every read and write
+
+struct IOCosts {
+	size_t textBytes, bitcodeBytes;
+	double textWriteMs, textReadMs, bitcodeWriteMs, bitcodeReadMs;
+};
+
+IOCosts measureIO(LLVMModuleRef module) {
+	IOCosts costs = { 0, 0, 1e30, 1e30, 1e30, 1e30 };
+	LLVMContextRef context = LLVMGetModuleContext(module);
+	for (int round = 0; round < IO_BENCHMARK_ROUNDS; round++) {
+		double start = wallMilliseconds();
+		char* text = LLVMPrintModuleToString(module);
+		costs.textWriteMs = min(costs.textWriteMs, wallMilliseconds() - start);
+		costs.textBytes = strlen(text);
+
+		// The IR parser takes the buffer over
+		LLVMMemoryBufferRef textBuffer = LLVMCreateMemoryBufferWithMemoryRangeCopy(text, costs.textBytes, "text");
+		LLVMDisposeMessage(text);
+		LLVMModuleRef copy = NULL;
+		char* err = NULL;
+		start = wallMilliseconds();
+		LLVMParseIRInContext(context, textBuffer, &copy, &err);
+		costs.textReadMs = min(costs.textReadMs, wallMilliseconds() - start);
+		if (err != NULL) LLVMDisposeMessage(err);
+		if (copy != NULL) LLVMDisposeModule(copy);
+
+		start = wallMilliseconds();
+		LLVMMemoryBufferRef bitcode = LLVMWriteBitcodeToMemoryBuffer(module);
+		costs.bitcodeWriteMs = min(costs.bitcodeWriteMs, wallMilliseconds() - start);
+		costs.bitcodeBytes = LLVMGetBufferSize(bitcode);
+
+		copy = NULL;
+		start = wallMilliseconds();
+		LLVMParseBitcodeInContext2(context, bitcode, &copy);
+		costs.bitcodeReadMs = min(costs.bitcodeReadMs, wallMilliseconds() - start);
+		if (copy != NULL) LLVMDisposeModule(copy);
+		LLVMDisposeMemoryBuffer(bitcode);
+	}
+	return costs;
+}
+
+// Prints the costs of reading and writing inputFiles as text and as bitcode; returns whether all of them could
+// be read
+bool benchmarkIO(vector<char*>& inputFiles) {
+	printf("===%s===\n", string(74, '-').c_str());
+	printf("  Text vs bitcode I/O (in memory, best of %d)\n", IO_BENCHMARK_ROUNDS);
+	printf("===%s===\n", string(74, '-').c_str());
+	printf("%-28s %9s %9s %8s %8s %8s %8s\n", "File", "Text KB", "BC KB", "Write ms", "Read ms", "Write ms", "Read ms");
+	printf("%-28s %9s %9s %17s %17s\n", "", "", "", "(text)", "(bitcode)");
+	IOCosts total = { 0, 0, 0, 0, 0, 0 };
+	int failed = 0;
+	for (char* inputFile : inputFiles) {
+		string name = inputFile;
+		if (name.size() > 28) name = "..." + name.substr(name.size() - 25);
+		LLVMModuleRef module = createLLVMModel(inputFile, LLVMGetGlobalContext());
+		if (module == NULL) {
+			printf("%-28s %s\n", name.c_str(), "failed");
+			failed++;
+			continue;
+		}
+		IOCosts costs = measureIO(module);
+		LLVMDisposeModule(module);
+		printf("%-28s %9.1f %9.1f %8.3f %8.3f %8.3f %8.3f\n", name.c_str(), costs.textBytes / 1024.0,
+			costs.bitcodeBytes / 1024.0, costs.textWriteMs, costs.textReadMs, costs.bitcodeWriteMs, costs.bitcodeReadMs);
+		total.textBytes += costs.textBytes;
+		total.bitcodeBytes += costs.bitcodeBytes;
+		total.textWriteMs += costs.textWriteMs;
+		total.textReadMs += costs.textReadMs;
+		total.bitcodeWriteMs += costs.bitcodeWriteMs;
+		total.bitcodeReadMs += costs.bitcodeReadMs;
+	}
+	printf("%-28s %9.1f %9.1f %8.3f %8.3f %8.3f %8.3f\n", "Total", total.textBytes / 1024.0,
+		total.bitcodeBytes / 1024.0, total.textWriteMs, total.textReadMs, total.bitcodeWriteMs, total.bitcodeReadMs);
+	if (total.bitcodeBytes > 0 && total.bitcodeWriteMs + total.bitcodeReadMs > 0) {
+		printf("Bitcode is %.1fx smaller, %.1fx faster to write and %.1fx faster to read\n",
+			(double) total.textBytes / total.bitcodeBytes, total.textWriteMs / total.bitcodeWriteMs,
+			total.textReadMs / total.bitcodeReadMs);
+	}
+	if (failed) printf("%d of %d files could not be read\n", failed, (int) inputFiles.size());
+	return failed == 0;
+}
+
+void printUsage(const char* program) {
+	fprintf(stderr, "Usage: %s [-O0|-O1|-O2] [-passes=<pipeline>] [-egraph] [-trace=<0-3>] [-time-passes]"
+		" [-stats-json=<file>] [-no-dirty-tracking] [-jobs=<n>] [-lazy] [-emit-ll|-emit-bc] [-io-benchmark]"
+		" file.ll|file.bc...\n", program);
+	fprintf(stderr, "Passes:");
+	for (int i = 0; i < NUM_PASSES; i++) fprintf(stderr, " %s", passRegistry[i].name);
+	fprintf(stderr, "\n");
+}
+
+int main(int argc, char** argv)
+{
+	LLVMModuleRef m = NULL;
+
+	vector<char*> inputFiles;
+	bool useEqualitySaturation = false;
+	bool timePasses = false;
+	bool ioBenchmark = false;
+	int jobs = -1;
+	string statisticsFile;
+	string pipelineText = optimizationPresets[2];
+	bool presetPipeline = true;
+	for (int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if (arg == "-egraph") useEqualitySaturation = true;
+		else if (arg == "-O0" || arg == "-O1" || arg == "-O2") {
+			pipelineText = optimizationPresets[arg[2] - '0'];
+			presetPipeline = true;
+		}
+		else if (arg.compare(0, 8, "-passes=") == 0) {
+			pipelineText = arg.substr(8);
+			presetPipeline = false;
+		}
+		else if (arg.compare(0, 7, "-trace=") == 0) traceLevel = atoi(arg.c_str() + 7);
+		else if (arg == "-time-passes") timePasses = true;
+		else if (arg == "-no-dirty-tracking") dirtyTracking = false;
+		else if (arg == "-lazy") lazyLoading = true;
+		else if (arg == "-emit-ll") outputFormat = OUTPUT_TEXT;
+		else if (arg == "-emit-bc") outputFormat = OUTPUT_BITCODE;
+		else if (arg == "-io-benchmark") ioBenchmark = true;
+		else if (arg.compare(0, 6, "-jobs=") == 0 && atoi(arg.c_str() + 6) >= 0) {
+			jobs = atoi(arg.c_str() + 6);
+		}
+		else if (arg.compare(0, 12, "-stats-json=") == 0 && arg.size() > 12) statisticsFile = arg.substr(12);
+		else if (arg[0] != '-') inputFiles.push_back(argv[i]);
+		else {
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (inputFiles.empty()) {
+		printUsage(argv[0]);
+		return 1;
+	}
+	if (useEqualitySaturation && !presetPipeline) {
+		fprintf(stderr, "-egraph only changes the -O presets; name egraph in -passes= instead\n");
+		return 1;
+	}
+	if (ioBenchmark) return benchmarkIO(inputFiles) ? 0 : 1;
+	// A batch runs on every hardware thread unless told otherwise
+	if (jobs < 0) jobs = inputFiles.size() > 1 ? 0 : 1;
+	if (jobs == 0) jobs = max(1u, thread::hardware_concurrency());
+
+	vector<PipelineStep> pipeline;
+	string error;
+	if (!parsePipeline(pipelineText, pipeline, error)) {
+		fprintf(stderr, "Invalid pass pipeline: %s\n", error.c_str());
+		printUsage(argv[0]);
+		return 1;
+	}
+
+	// -egraph swaps the greedy reassociation of the presets for equality saturation
+	if (useEqualitySaturation) replacePass(pipeline, findPass("reassociate"), findPass("egraph"));
+
+	// Lazily loaded functions are optimized on their own
+	if (lazyLoading) {
+		string removed;
+		removeInterproceduralPasses(pipeline, removed);
+		if (!removed.empty()) fprintf(stderr, "-lazy leaves out the interprocedural passes: %s\n", removed.c_str());
+	}
+
+	double totalWallMs = 0, totalCpuMs = 0;
+	bool ok = true;
+	if (inputFiles.size() > 1) {
+		ok = optimizeBatch(inputFiles, pipeline, jobs, totalWallMs, totalCpuMs);
+	} else if (lazyLoading) {
+		double wallStart = wallMilliseconds(), cpuStart = processCpuMilliseconds();
+		m = optimizeLazily(inputFiles[0], LLVMGetGlobalContext(), pipeline);
+		if (m == NULL) return 1;
+		totalWallMs = wallMilliseconds() - wallStart;
+		totalCpuMs = processCpuMilliseconds() - cpuStart;
+	} else {
+		m = createLLVMModel(inputFiles[0], LLVMGetGlobalContext());
+		if (m == NULL) return 1;
+		double wallStart = wallMilliseconds(), cpuStart = processCpuMilliseconds();
+		optimizeModule(m, pipeline, jobs);
+		totalWallMs = wallMilliseconds() - wallStart;
+		totalCpuMs = processCpuMilliseconds() - cpuStart;
+	}
+
+	if (timePasses) printStatisticsTable(stdout, totalWallMs, totalCpuMs);
+	if (!statisticsFile.empty()) {
+		FILE* out = statisticsFile == "-" ? stdout : fopen(statisticsFile.c_str(), "w");
+		if (out == NULL) {
+			fprintf(stderr, "Cannot write %s\n", statisticsFile.c_str());
+		} else {
+			printStatisticsJSON(out, totalWallMs, totalCpuMs);
+			if (out != stdout) fclose(out);
+		}
+	}
+
+	if (inputFiles.size() == 1) writeOptimizedModule(m, inputFiles[0]);
+
+	return ok ? 0 : 1;
+}